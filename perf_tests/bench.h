@@ -0,0 +1,724 @@
+/*
+ * Micro-benchmark harness for the clib perf tests
+ *
+ * Copyright (c) 2023 Andreas Heck <aheck@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Every perf_test_* binary describes its benchmarks in a table and hands it to
+ * bench_main():
+ *
+ *     void bench_append(BenchState *state)
+ *     {
+ *         for (uint64_t i = 0; i < state->iterations; i++) {
+ *             ...
+ *         }
+ *     }
+ *
+ *     static const Benchmark benchmarks[] = {
+ *         BENCHMARK(bench_append, 1000),
+ *     };
+ *
+ *     int main(int argc, char **argv)
+ *     {
+ *         return bench_main(argc, argv, benchmarks, BENCH_COUNT(benchmarks));
+ *     }
+ *
+ * The source file that includes bench.h defines BENCH_IMPL first to compile
+ * the harness into the binary.
+ *
+ * The harness picks the number of iterations so that one run takes at least
+ * --min-time seconds, does --warmup runs that are thrown away and then reports
+ * mean and standard deviation over --repetitions runs. Benchmarks can be
+ * selected with --filter=<substring>.
+ *
+ * On Linux --counters additionally reads hardware performance counters via
+ * perf_event_open() while the timer is running and reports them per
+ * operation. This needs kernel.perf_event_paranoid <= 2 for user space only
+ * counting; counters the kernel or the CPU refuses are reported as "-".
+ *
+ * Benchmarks that build a data structure can report its heap footprint by
+ * setting state->bytes, usually to the difference of bench_heap_bytes() before
+ * and after building it. --save=<file> writes the results of a run to a file
+ * and --compare=<file> prints them next to the current results together with
+ * the time and memory ratios (current / saved).
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#if (defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define BENCH_DEFAULT_MIN_TIME 0.05
+#define BENCH_DEFAULT_REPETITIONS 5
+#define BENCH_DEFAULT_WARMUP 1
+#define BENCH_MAX_REPETITIONS 100
+#define BENCH_MAX_SAVED_RESULTS 1024
+#define BENCH_MAX_NAME_LEN 128
+
+enum {
+    BENCH_COUNTER_CYCLES,
+    BENCH_COUNTER_INSTRUCTIONS,
+    BENCH_COUNTER_L1D_MISSES,
+    BENCH_COUNTER_LLC_MISSES,
+    BENCH_COUNTER_BRANCH_MISSES,
+    BENCH_COUNTER_DTLB_MISSES,
+    BENCH_NUM_COUNTERS
+};
+
+typedef struct BenchCounters {
+    int fds[BENCH_NUM_COUNTERS];
+    bool available;
+} BenchCounters;
+
+typedef struct BenchState {
+    uint64_t iterations;
+    uint64_t arg;
+    uint64_t items_per_iteration;
+    uint64_t bytes;
+    uint64_t _start_ns;
+    uint64_t _elapsed_ns;
+    bool _running;
+    BenchCounters *_counters;
+} BenchState;
+
+typedef void (*BenchFunc)(BenchState *state);
+
+typedef struct Benchmark {
+    const char *name;
+    BenchFunc func;
+    uint64_t arg;
+} Benchmark;
+
+#define BENCHMARK(func, arg) { #func, func, arg }
+#define BENCH_COUNT(benchmarks) (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+// Keep the compiler from optimizing away a computed value or the stores that
+// lead to it. MSVC has no inline assembly on x64 so the value is written to a
+// volatile sink instead, which requires value to be an lvalue.
+#if defined(__GNUC__) || defined(__clang__)
+#define bench_do_not_optimize(value) __asm__ volatile("" : : "g"(value) : "memory")
+#define bench_clobber_memory() __asm__ volatile("" : : : "memory")
+#else
+#include <intrin.h>
+extern volatile const void *_bench_sink;
+#define bench_do_not_optimize(value) (_bench_sink = (const void*) &(value), _ReadWriteBarrier())
+#define bench_clobber_memory() _ReadWriteBarrier()
+#endif
+
+uint64_t bench_now_ns(void);
+void bench_pause_timing(BenchState *state);
+void bench_resume_timing(BenchState *state);
+uint64_t bench_random(uint64_t *seed);
+size_t bench_heap_bytes(void);
+bool bench_counters_open(BenchCounters *counters);
+void bench_counters_close(BenchCounters *counters);
+void bench_counters_reset(BenchCounters *counters);
+double bench_counters_read(BenchCounters *counters, int counter);
+int bench_main(int argc, char **argv, const Benchmark *benchmarks, size_t num_benchmarks);
+
+// The harness has its own guard instead of _CLIB_IMPL so that it is also
+// compiled into binaries that don't use clib, like perf_compare_glib
+#ifdef BENCH_IMPL
+
+#if !(defined(__GNUC__) || defined(__clang__))
+volatile const void *_bench_sink;
+#endif
+
+typedef struct _BenchOptions {
+    const char *filter;
+    const char *save_file;
+    const char *compare_file;
+    double min_time;
+    unsigned int repetitions;
+    unsigned int warmup;
+    bool list;
+    bool counters;
+} _BenchOptions;
+
+typedef struct _BenchResult {
+    char name[BENCH_MAX_NAME_LEN];
+    double ns_per_op;
+    uint64_t bytes;
+} _BenchResult;
+
+const char *_bench_counter_names[BENCH_NUM_COUNTERS] = {
+    "cycles", "instr", "L1d-miss", "LLC-miss", "br-miss", "dTLB-miss"
+};
+
+#ifdef __linux__
+int _bench_counter_open(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    // exclude_kernel makes the counters usable for unprivileged users with
+    // the default perf_event_paranoid setting of 2
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#define _BENCH_HW_CACHE_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+#endif
+
+bool bench_counters_open(BenchCounters *counters)
+{
+    counters->available = false;
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        counters->fds[i] = -1;
+    }
+
+#ifdef __linux__
+    counters->fds[BENCH_COUNTER_CYCLES] = _bench_counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    counters->fds[BENCH_COUNTER_INSTRUCTIONS] = _bench_counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    counters->fds[BENCH_COUNTER_L1D_MISSES] = _bench_counter_open(PERF_TYPE_HW_CACHE, _BENCH_HW_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D));
+    counters->fds[BENCH_COUNTER_LLC_MISSES] = _bench_counter_open(PERF_TYPE_HW_CACHE, _BENCH_HW_CACHE_MISS(PERF_COUNT_HW_CACHE_LL));
+    counters->fds[BENCH_COUNTER_BRANCH_MISSES] = _bench_counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    counters->fds[BENCH_COUNTER_DTLB_MISSES] = _bench_counter_open(PERF_TYPE_HW_CACHE, _BENCH_HW_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB));
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->fds[i] >= 0) {
+            counters->available = true;
+        }
+    }
+#endif
+
+    return counters->available;
+}
+
+void bench_counters_close(BenchCounters *counters)
+{
+#ifdef __linux__
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->fds[i] >= 0) {
+            close(counters->fds[i]);
+            counters->fds[i] = -1;
+        }
+    }
+#endif
+
+    counters->available = false;
+}
+
+void _bench_counters_ioctl(BenchCounters *counters, unsigned long request)
+{
+#ifdef __linux__
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        if (counters->fds[i] >= 0) {
+            ioctl(counters->fds[i], request, 0);
+        }
+    }
+#endif
+}
+
+void bench_counters_reset(BenchCounters *counters)
+{
+#ifdef __linux__
+    _bench_counters_ioctl(counters, PERF_EVENT_IOC_RESET);
+#endif
+}
+
+// Returns the counter value scaled up for the time the kernel had to
+// multiplex it away, or -1 if the counter is not available
+double bench_counters_read(BenchCounters *counters, int counter)
+{
+#ifdef __linux__
+    uint64_t values[3];
+
+    if (counters->fds[counter] < 0) {
+        return -1;
+    }
+
+    if (read(counters->fds[counter], values, sizeof(values)) != sizeof(values)) {
+        return -1;
+    }
+
+    // values: raw count, time enabled, time running
+    if (values[2] == 0) {
+        return values[1] == 0 ? 0 : -1;
+    }
+
+    return (double) values[0] * (double) values[1] / (double) values[2];
+#else
+    return -1;
+#endif
+}
+
+uint64_t bench_now_ns(void)
+{
+#if (defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t) ((double) counter.QuadPart * 1e9 / (double) frequency.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+void bench_pause_timing(BenchState *state)
+{
+    if (!state->_running) {
+        return;
+    }
+
+    state->_elapsed_ns += bench_now_ns() - state->_start_ns;
+    state->_running = false;
+
+#ifdef __linux__
+    if (state->_counters) {
+        _bench_counters_ioctl(state->_counters, PERF_EVENT_IOC_DISABLE);
+    }
+#endif
+}
+
+void bench_resume_timing(BenchState *state)
+{
+    if (state->_running) {
+        return;
+    }
+
+    state->_running = true;
+
+#ifdef __linux__
+    if (state->_counters) {
+        _bench_counters_ioctl(state->_counters, PERF_EVENT_IOC_ENABLE);
+    }
+#endif
+
+    state->_start_ns = bench_now_ns();
+}
+
+uint64_t bench_random(uint64_t *seed)
+{
+    // splitmix64
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+size_t bench_heap_bytes(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+    struct mallinfo info = mallinfo();
+    return (size_t) (unsigned int) info.uordblks + (size_t) (unsigned int) info.hblkhd;
+#elif defined(__APPLE__)
+    malloc_statistics_t stats;
+    malloc_zone_statistics(NULL, &stats);
+    return stats.size_in_use;
+#else
+    return 0;
+#endif
+}
+
+uint64_t _bench_run(const Benchmark *benchmark, uint64_t iterations, uint64_t *items_per_iteration, uint64_t *bytes, BenchCounters *counters)
+{
+    BenchState state;
+
+    state.iterations = iterations;
+    state.arg = benchmark->arg;
+    state.items_per_iteration = 1;
+    state.bytes = 0;
+    state._elapsed_ns = 0;
+    state._running = false;
+    state._counters = counters;
+
+    bench_resume_timing(&state);
+    benchmark->func(&state);
+    bench_pause_timing(&state);
+
+    if (items_per_iteration) {
+        *items_per_iteration = state.items_per_iteration > 0 ? state.items_per_iteration : 1;
+    }
+
+    if (bytes) {
+        *bytes = state.bytes;
+    }
+
+    return state._elapsed_ns;
+}
+
+uint64_t _bench_calibrate(const Benchmark *benchmark, double min_time, uint64_t *items_per_iteration)
+{
+    uint64_t min_ns = (uint64_t) (min_time * 1e9);
+    uint64_t iterations = 1;
+
+    for (;;) {
+        uint64_t elapsed = _bench_run(benchmark, iterations, items_per_iteration, NULL, NULL);
+
+        if (elapsed >= min_ns) {
+            return iterations;
+        }
+
+        // aim a bit above min_time but never grow by more than 10x per round
+        // since the first rounds are dominated by timer resolution
+        uint64_t next = iterations * 10;
+        if (elapsed > 0) {
+            double estimate = (double) iterations * 1.4 * (double) min_ns / (double) elapsed;
+            if (estimate < (double) next) {
+                next = (uint64_t) estimate;
+            }
+        }
+
+        if (next <= iterations) {
+            next = iterations + 1;
+        }
+
+        iterations = next;
+    }
+}
+
+void _bench_format_name(const Benchmark *benchmark, char *buf, size_t buf_size)
+{
+    const char *name = benchmark->name;
+
+    // "bench_" is noise in every line of the report
+    if (strncmp(name, "bench_", 6) == 0) {
+        name += 6;
+    }
+
+    snprintf(buf, buf_size, "%s/%llu", name, (unsigned long long) benchmark->arg);
+}
+
+bool _bench_parse_args(int argc, char **argv, _BenchOptions *options)
+{
+    options->filter = NULL;
+    options->save_file = NULL;
+    options->compare_file = NULL;
+    options->min_time = BENCH_DEFAULT_MIN_TIME;
+    options->repetitions = BENCH_DEFAULT_REPETITIONS;
+    options->warmup = BENCH_DEFAULT_WARMUP;
+    options->list = false;
+    options->counters = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if (strncmp(arg, "--filter=", 9) == 0) {
+            options->filter = arg + 9;
+        } else if (strncmp(arg, "--min-time=", 11) == 0) {
+            options->min_time = atof(arg + 11);
+        } else if (strncmp(arg, "--repetitions=", 14) == 0) {
+            options->repetitions = (unsigned int) atoi(arg + 14);
+        } else if (strncmp(arg, "--warmup=", 9) == 0) {
+            options->warmup = (unsigned int) atoi(arg + 9);
+        } else if (strcmp(arg, "--list") == 0) {
+            options->list = true;
+        } else if (strcmp(arg, "--counters") == 0) {
+            options->counters = true;
+        } else if (strncmp(arg, "--save=", 7) == 0) {
+            options->save_file = arg + 7;
+        } else if (strncmp(arg, "--compare=", 10) == 0) {
+            options->compare_file = arg + 10;
+        } else if (arg[0] != '-') {
+            options->filter = arg;
+        } else {
+            fprintf(stderr, "Usage: %s [--filter=<substring>] [--min-time=<seconds>] "
+                    "[--repetitions=<n>] [--warmup=<n>] [--counters] [--save=<file>] [--compare=<file>] [--list]\n", argv[0]);
+            return false;
+        }
+    }
+
+    if (options->repetitions == 0) {
+        options->repetitions = 1;
+    }
+
+    if (options->repetitions > BENCH_MAX_REPETITIONS) {
+        options->repetitions = BENCH_MAX_REPETITIONS;
+    }
+
+    return true;
+}
+
+size_t _bench_load_results(const char *path, _BenchResult *results, size_t max_results)
+{
+    FILE *file = fopen(path, "r");
+    size_t num_results = 0;
+    char line[256];
+
+    if (file == NULL) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 0;
+    }
+
+    while (num_results < max_results && fgets(line, sizeof(line), file)) {
+        _BenchResult *result = &results[num_results];
+        unsigned long long bytes;
+
+        if (sscanf(line, "%127s %lf %llu", result->name, &result->ns_per_op, &bytes) == 3) {
+            result->bytes = bytes;
+            num_results++;
+        }
+    }
+
+    fclose(file);
+
+    return num_results;
+}
+
+const _BenchResult* _bench_find_result(const _BenchResult *results, size_t num_results, const char *name)
+{
+    for (size_t i = 0; i < num_results; i++) {
+        if (strcmp(results[i].name, name) == 0) {
+            return &results[i];
+        }
+    }
+
+    return NULL;
+}
+
+void _bench_print_comparison(const _BenchResult *base, double ns_per_op, uint64_t bytes)
+{
+    if (base == NULL) {
+        printf(" %14s %8s %12s %8s", "-", "-", "-", "-");
+        return;
+    }
+
+    printf(" %14.2f %7.2fx", base->ns_per_op, base->ns_per_op > 0 ? ns_per_op / base->ns_per_op : 0);
+
+    if (bytes > 0 && base->bytes > 0) {
+        printf(" %12llu %7.2fx", (unsigned long long) base->bytes, (double) bytes / (double) base->bytes);
+    } else {
+        printf(" %12s %8s", "-", "-");
+    }
+}
+
+void _bench_print_counters(BenchCounters *counters, double ops)
+{
+    double values[BENCH_NUM_COUNTERS];
+
+    printf("   ");
+
+    for (int i = 0; i < BENCH_NUM_COUNTERS; i++) {
+        values[i] = bench_counters_read(counters, i);
+
+        if (values[i] < 0) {
+            printf(" %s/op: -", _bench_counter_names[i]);
+        } else {
+            printf(" %s/op: %.2f", _bench_counter_names[i], values[i] / ops);
+        }
+    }
+
+    if (values[BENCH_COUNTER_CYCLES] > 0 && values[BENCH_COUNTER_INSTRUCTIONS] >= 0) {
+        printf(" IPC: %.2f", values[BENCH_COUNTER_INSTRUCTIONS] / values[BENCH_COUNTER_CYCLES]);
+    }
+
+    printf("\n");
+}
+
+int bench_main(int argc, char **argv, const Benchmark *benchmarks, size_t num_benchmarks)
+{
+    _BenchOptions options;
+    BenchCounters hw_counters;
+    BenchCounters *counters = NULL;
+    _BenchResult *baseline = NULL;
+    size_t num_baseline = 0;
+    FILE *save_file = NULL;
+    char name[BENCH_MAX_NAME_LEN];
+    double samples[BENCH_MAX_REPETITIONS];
+
+    if (!_bench_parse_args(argc, argv, &options)) {
+        return 1;
+    }
+
+    if (options.compare_file && !options.list) {
+        baseline = malloc(BENCH_MAX_SAVED_RESULTS * sizeof(_BenchResult));
+        if (baseline == NULL) {
+            fprintf(stderr, "FATAL ERROR: bench_main: Out of memory");
+            exit(1);
+        }
+
+        num_baseline = _bench_load_results(options.compare_file, baseline, BENCH_MAX_SAVED_RESULTS);
+        if (num_baseline == 0) {
+            free(baseline);
+            return 1;
+        }
+    }
+
+    if (options.save_file && !options.list) {
+        save_file = fopen(options.save_file, "w");
+        if (save_file == NULL) {
+            fprintf(stderr, "Failed to open %s for writing\n", options.save_file);
+            free(baseline);
+            return 1;
+        }
+    }
+
+    if (options.counters && !options.list) {
+        if (bench_counters_open(&hw_counters)) {
+            counters = &hw_counters;
+        } else {
+            fprintf(stderr, "Hardware performance counters are not available on this system. "
+                    "Check kernel.perf_event_paranoid.\n");
+        }
+    }
+
+    if (!options.list) {
+        printf("%-40s %12s %14s %10s %14s %12s", "Benchmark", "Iterations", "ns/op", "stddev", "min ns/op", "bytes");
+        if (baseline) {
+            printf(" %14s %8s %12s %8s", "base ns/op", "time", "base bytes", "mem");
+        }
+        printf("\n");
+    }
+
+    for (size_t b = 0; b < num_benchmarks; b++) {
+        const Benchmark *benchmark = &benchmarks[b];
+
+        _bench_format_name(benchmark, name, sizeof(name));
+
+        if (options.filter && strstr(name, options.filter) == NULL) {
+            continue;
+        }
+
+        if (options.list) {
+            printf("%s\n", name);
+            continue;
+        }
+
+        uint64_t items;
+        uint64_t bytes = 0;
+        uint64_t iterations = _bench_calibrate(benchmark, options.min_time, &items);
+
+        for (unsigned int i = 0; i < options.warmup; i++) {
+            _bench_run(benchmark, iterations, NULL, NULL, NULL);
+        }
+
+        if (counters) {
+            bench_counters_reset(counters);
+        }
+
+        double ops = (double) iterations * (double) items;
+        double sum = 0;
+        double min = 0;
+
+        for (unsigned int i = 0; i < options.repetitions; i++) {
+            samples[i] = (double) _bench_run(benchmark, iterations, NULL, &bytes, counters) / ops;
+            sum += samples[i];
+
+            if (i == 0 || samples[i] < min) {
+                min = samples[i];
+            }
+        }
+
+        double mean = sum / options.repetitions;
+        double variance = 0;
+
+        for (unsigned int i = 0; i < options.repetitions; i++) {
+            variance += (samples[i] - mean) * (samples[i] - mean);
+        }
+
+        if (options.repetitions > 1) {
+            variance /= options.repetitions - 1;
+        }
+
+        double stddev_percent = mean > 0 ? sqrt(variance) / mean * 100.0 : 0;
+
+        printf("%-40s %12llu %14.2f %9.2f%% %14.2f", name, (unsigned long long) iterations,
+                mean, stddev_percent, min);
+
+        if (bytes > 0) {
+            printf(" %12llu", (unsigned long long) bytes);
+        } else {
+            printf(" %12s", "-");
+        }
+
+        if (baseline) {
+            _bench_print_comparison(_bench_find_result(baseline, num_baseline, name), mean, bytes);
+        }
+
+        printf("\n");
+
+        if (save_file) {
+            fprintf(save_file, "%s %f %llu\n", name, mean, (unsigned long long) bytes);
+        }
+
+        if (counters) {
+            _bench_print_counters(counters, ops * options.repetitions);
+        }
+
+        fflush(stdout);
+    }
+
+    if (counters) {
+        bench_counters_close(counters);
+    }
+
+    if (save_file) {
+        fclose(save_file);
+    }
+
+    free(baseline);
+
+    return 0;
+}
+
+#endif
+#endif
@@ -0,0 +1,317 @@
+/*
+ * Identical workloads for clib and GLib
+ *
+ * This file is compiled twice: perf_compare_clib uses the clib headers and
+ * perf_compare_glib (PERF_COMPARE_GLIB defined) links against the installed
+ * GLib. Both binaries can't be linked into one executable because clib and
+ * GLib export the same symbols. The perf_compare target runs the GLib binary
+ * first and feeds its results to the clib binary via --compare so the numbers
+ * end up side by side.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef PERF_COMPARE_GLIB
+#include <glib.h>
+
+// clib's g_int_hash hashes the pointer value itself which is what GLib calls
+// g_direct_hash
+#define COMPARE_DIRECT_HASH g_direct_hash
+#define COMPARE_DIRECT_EQUAL g_direct_equal
+#else
+#define _CLIB_IMPL 1
+#include "garray.h"
+#include "ghashtable.h"
+#include "glist.h"
+#include "gstring.h"
+
+#define COMPARE_DIRECT_HASH g_int_hash
+#define COMPARE_DIRECT_EQUAL g_int_equal
+#endif
+
+#define BENCH_IMPL 1
+#include "bench.h"
+
+static int compare_uint32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+static int compare_pointer_value(const void *a, const void *b)
+{
+    uintptr_t x = (uintptr_t) a;
+    uintptr_t y = (uintptr_t) b;
+
+    return (x > y) - (x < y);
+}
+
+static GArray* create_random_array(uint64_t num_elements, uint64_t seed)
+{
+    GArray *array = g_array_new(false, false, sizeof(uint32_t));
+
+    for (uint64_t i = 0; i < num_elements; i++) {
+        uint32_t val = (uint32_t) bench_random(&seed);
+        g_array_append_val(array, val);
+    }
+
+    return array;
+}
+
+static GHashTable* create_table(uint64_t num_elements)
+{
+    GHashTable *htable = g_hash_table_new(COMPARE_DIRECT_HASH, COMPARE_DIRECT_EQUAL);
+
+    for (uint64_t i = 1; i <= num_elements; i++) {
+        g_hash_table_insert(htable, (void*) (uintptr_t) i, (void*) "Hello World");
+    }
+
+    return htable;
+}
+
+void bench_garray_append_val(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        size_t heap_before = bench_heap_bytes();
+        bench_resume_timing(state);
+
+        GArray *array = create_random_array(state->arg, 42);
+
+        bench_pause_timing(state);
+        state->bytes = bench_heap_bytes() - heap_before;
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_sort(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_array(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_sort(array, compare_uint32);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_binary_search(BenchState *state)
+{
+    uint64_t seed = 7;
+    unsigned int match_index;
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    g_array_sort(array, compare_uint32);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (int j = 0; j < 1000; j++) {
+            uint32_t target = ((uint32_t*) array->data)[bench_random(&seed) % array->len];
+            bool found = g_array_binary_search(array, &target, compare_uint32, &match_index);
+            bench_do_not_optimize(found);
+        }
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_ghashtable_insert(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        size_t heap_before = bench_heap_bytes();
+        bench_resume_timing(state);
+
+        GHashTable *htable = create_table(state->arg);
+
+        bench_pause_timing(state);
+        state->bytes = bench_heap_bytes() - heap_before;
+        g_hash_table_destroy(htable);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_ghashtable_lookup_random(BenchState *state)
+{
+    uint64_t seed = 42;
+
+    bench_pause_timing(state);
+    GHashTable *htable = create_table(state->arg);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (uint64_t j = 0; j < state->arg; j++) {
+            uint64_t key = bench_random(&seed) % state->arg + 1;
+            void *value = g_hash_table_lookup(htable, (void*) (uintptr_t) key);
+            bench_do_not_optimize(value);
+        }
+    }
+
+    bench_pause_timing(state);
+    g_hash_table_destroy(htable);
+}
+
+void bench_ghashtable_remove(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GHashTable *htable = create_table(state->arg);
+        bench_resume_timing(state);
+
+        for (uint64_t j = 1; j <= state->arg; j++) {
+            g_hash_table_remove(htable, (void*) (uintptr_t) j);
+        }
+
+        bench_pause_timing(state);
+        g_hash_table_destroy(htable);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_glist_prepend(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GList *list = NULL;
+
+        bench_pause_timing(state);
+        size_t heap_before = bench_heap_bytes();
+        bench_resume_timing(state);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            list = g_list_prepend(list, (void*) (uintptr_t) j);
+        }
+
+        bench_pause_timing(state);
+        state->bytes = bench_heap_bytes() - heap_before;
+        g_list_free(list);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_glist_sort(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        uint64_t seed = i;
+        GList *list = NULL;
+
+        bench_pause_timing(state);
+        for (uint64_t j = 0; j < state->arg; j++) {
+            list = g_list_prepend(list, (void*) (uintptr_t) (bench_random(&seed) & 0xffffffff));
+        }
+        bench_resume_timing(state);
+
+        list = g_list_sort(list, compare_pointer_value);
+
+        bench_pause_timing(state);
+        g_list_free(list);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gstring_append(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        size_t heap_before = bench_heap_bytes();
+        bench_resume_timing(state);
+
+        GString *string = g_string_new(NULL);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_append(string, "Hello World");
+        }
+
+        bench_pause_timing(state);
+        state->bytes = bench_heap_bytes() - heap_before;
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gstring_append_c(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GString *string = g_string_new(NULL);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_append_c(string, 'a' + (j % 26));
+        }
+
+        bench_pause_timing(state);
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gstring_append_printf(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GString *string = g_string_new(NULL);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_append_printf(string, "%d: %s\n", (int) j, "Hello World");
+        }
+
+        bench_pause_timing(state);
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+static const Benchmark benchmarks[] = {
+    BENCHMARK(bench_garray_append_val, 10000),
+    BENCHMARK(bench_garray_append_val, 1000000),
+    BENCHMARK(bench_garray_sort, 10000),
+    BENCHMARK(bench_garray_sort, 1000000),
+    BENCHMARK(bench_garray_binary_search, 1000000),
+    BENCHMARK(bench_ghashtable_insert, 10000),
+    BENCHMARK(bench_ghashtable_insert, 1000000),
+    BENCHMARK(bench_ghashtable_lookup_random, 10000),
+    BENCHMARK(bench_ghashtable_lookup_random, 1000000),
+    BENCHMARK(bench_ghashtable_remove, 10000),
+    BENCHMARK(bench_glist_prepend, 10000),
+    BENCHMARK(bench_glist_prepend, 1000000),
+    BENCHMARK(bench_glist_sort, 10000),
+    BENCHMARK(bench_gstring_append, 10000),
+    BENCHMARK(bench_gstring_append, 1000000),
+    BENCHMARK(bench_gstring_append_c, 1000000),
+    BENCHMARK(bench_gstring_append_printf, 10000),
+};
+
+int main(int argc, char **argv)
+{
+    return bench_main(argc, argv, benchmarks, BENCH_COUNT(benchmarks));
+}
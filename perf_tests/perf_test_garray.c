@@ -0,0 +1,946 @@
+#include <stdio.h>
+
+#define _CLIB_IMPL 1
+#include "garray.h"
+#include "gchunkarray.h"
+#include "gcolumnarray.h"
+#define BENCH_IMPL 1
+#include "bench.h"
+
+static int compare_uint32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    uint64_t key;
+    uint64_t payload;
+} Record;
+
+#define UINT32_LESS(a, b) ((a) < (b))
+#define RECORD_LESS(a, b) ((a).key < (b).key)
+
+CLIB_DEFINE_ARRAY_SORT(sort_uint32, uint32_t, UINT32_LESS)
+CLIB_DEFINE_ARRAY_SORT(sort_records, Record, RECORD_LESS)
+
+static int compare_record(const void *a, const void *b)
+{
+    uint64_t x = ((const Record*) a)->key;
+    uint64_t y = ((const Record*) b)->key;
+
+    return (x > y) - (x < y);
+}
+
+static GArray* create_random_records(uint64_t num_elements, uint64_t seed)
+{
+    GArray *array = g_array_sized_new(false, false, sizeof(Record), (unsigned int) num_elements);
+
+    for (uint64_t i = 0; i < num_elements; i++) {
+        Record rec = {bench_random(&seed), i};
+        g_array_append_val(array, rec);
+    }
+
+    return array;
+}
+
+static GArray* create_random_array(uint64_t num_elements, uint64_t seed)
+{
+    GArray *array = g_array_sized_new(false, false, sizeof(uint32_t), (unsigned int) num_elements);
+
+    for (uint64_t i = 0; i < num_elements; i++) {
+        uint32_t val = (uint32_t) bench_random(&seed);
+        g_array_append_val(array, val);
+    }
+
+    return array;
+}
+
+void bench_garray_append_val(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GArray *array = g_array_new(false, false, sizeof(uint32_t));
+
+        for (uint32_t j = 0; j < state->arg; j++) {
+            g_array_append_val(array, j);
+        }
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gchunkarray_append_val(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GChunkArray *array = g_chunk_array_new(sizeof(uint32_t));
+
+        for (uint32_t j = 0; j < state->arg; j++) {
+            g_chunk_array_append_val(array, j);
+        }
+        bench_do_not_optimize(array->chunks);
+
+        bench_pause_timing(state);
+        g_chunk_array_free(array);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_set_size_clear(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GArray *array = g_array_new(false, true, sizeof(uint32_t));
+
+        g_array_set_size(array, (unsigned int) state->arg);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_tiny(BenchState *state)
+{
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (uint32_t j = 0; j < 1000; j++) {
+            GArray *array = g_array_new(false, false, sizeof(uint32_t));
+
+            for (uint32_t k = 0; k < state->arg; k++) {
+                g_array_append_val(array, k);
+            }
+            bench_do_not_optimize(array->data);
+
+            g_array_free(array, true);
+        }
+    }
+}
+
+void bench_garray_tiny_small(BenchState *state)
+{
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (uint32_t j = 0; j < 1000; j++) {
+            G_ARRAY_SMALL(uint32_t, 8) small = G_ARRAY_SMALL_INITIALIZER(small, false, false);
+            GArray *array = &small.array;
+
+            for (uint32_t k = 0; k < state->arg; k++) {
+                g_array_append_val(array, k);
+            }
+            bench_do_not_optimize(array->data);
+
+            g_array_free(array, true);
+        }
+    }
+}
+
+void bench_garray_prepend_val(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GArray *array = g_array_new(false, false, sizeof(uint32_t));
+
+        for (uint32_t j = 0; j < state->arg; j++) {
+            g_array_prepend_val(array, j);
+        }
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_iterate(BenchState *state)
+{
+    uint64_t sum = 0;
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        uint32_t *data = (uint32_t*) array->data;
+
+        for (unsigned int j = 0; j < array->len; j++) {
+            sum += data[j];
+        }
+        bench_do_not_optimize(sum);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_sort(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_array(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_sort(array, compare_uint32);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_sort_typed(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_array(state->arg, i);
+        bench_resume_timing(state);
+
+        sort_uint32(array);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_sort_records(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_records(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_sort(array, compare_record);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_sort_records_typed(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_records(state->arg, i);
+        bench_resume_timing(state);
+
+        sort_records(array);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_radix_sort(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_array(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_radix_sort(array, 0, sizeof(uint32_t), G_ARRAY_RADIX_UNSIGNED);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_radix_sort_records(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_records(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_radix_sort(array, offsetof(Record, key), sizeof(uint64_t), G_ARRAY_RADIX_UNSIGNED);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_stable_sort(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_records(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_stable_sort(array, compare_record);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+// sorted input with 1% of the elements replaced by random values
+static GArray* create_nearly_sorted_records(uint64_t num_elements, uint64_t seed)
+{
+    GArray *array = create_random_records(num_elements, seed);
+    Record *data = (Record*) array->data;
+
+    for (uint64_t i = 0; i < num_elements; i++) {
+        if (bench_random(&seed) % 100 != 0) {
+            data[i].key = i;
+        }
+    }
+
+    return array;
+}
+
+void bench_garray_sort_nearly_sorted(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_nearly_sorted_records(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_sort(array, compare_record);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_garray_stable_sort_nearly_sorted(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_nearly_sorted_records(state->arg, i);
+        bench_resume_timing(state);
+
+        g_array_stable_sort(array, compare_record);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+// arg is the number of threads, every thread needs at least
+// GARRAY_PARALLEL_SORT_THRESHOLD elements for all of them to run
+void bench_garray_sort_parallel(BenchState *state)
+{
+    const uint64_t num_elements = 8000000;
+
+    state->items_per_iteration = num_elements;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_array(num_elements, i);
+        bench_resume_timing(state);
+
+        g_array_sort_parallel(array, compare_uint32, (unsigned int) state->arg);
+        bench_do_not_optimize(array->data);
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+// Hashes an element a few times to stand in for per-element work like scoring
+static void score_element(void *element, void *user_data)
+{
+    uint32_t value = *(uint32_t*) element;
+
+    for (int i = 0; i < 16; i++) {
+        value = (value ^ (value >> 15)) * 2246822519u;
+    }
+
+    *(uint32_t*) element = value;
+}
+
+static void sum_element(void *accumulator, const void *element, void *user_data)
+{
+    *(uint64_t*) accumulator += *(const uint32_t*) element;
+}
+
+static void combine_sum(void *accumulator, const void *other, void *user_data)
+{
+    *(uint64_t*) accumulator += *(const uint64_t*) other;
+}
+
+// arg is the number of threads of the pool, 1 runs in the calling thread
+void bench_garray_parallel_foreach(BenchState *state)
+{
+    const uint64_t num_elements = 4000000;
+    GArray *array = create_random_array(num_elements, 0);
+    GArrayThreadPool *pool = g_array_thread_pool_new((unsigned int) state->arg);
+
+    state->items_per_iteration = num_elements;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        g_array_parallel_foreach(array, pool, score_element, NULL);
+        bench_do_not_optimize(array->data);
+    }
+
+    g_array_thread_pool_free(pool);
+    g_array_free(array, true);
+}
+
+// arg is the number of threads of the pool, 1 runs in the calling thread
+void bench_garray_parallel_reduce(BenchState *state)
+{
+    const uint64_t num_elements = 4000000;
+    GArray *array = create_random_array(num_elements, 0);
+    GArrayThreadPool *pool = g_array_thread_pool_new((unsigned int) state->arg);
+
+    state->items_per_iteration = num_elements;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        uint64_t sum = 0;
+        g_array_parallel_reduce(array, pool, &sum, sizeof(sum), sum_element, combine_sum, NULL);
+        bench_do_not_optimize(&sum);
+    }
+
+    g_array_thread_pool_free(pool);
+    g_array_free(array, true);
+}
+
+// arg is the number of sorted runs the 1000000 elements are split into,
+// compare with bench_garray_sort/1000000
+void bench_garray_merge_k(BenchState *state)
+{
+    const uint64_t num_elements = 1000000;
+    unsigned int k = (unsigned int) state->arg;
+    GArray **runs = malloc(k * sizeof(GArray*));
+
+    bench_pause_timing(state);
+    for (unsigned int r = 0; r < k; r++) {
+        runs[r] = create_random_array(num_elements / k, r);
+        g_array_sort(runs[r], compare_uint32);
+    }
+    bench_resume_timing(state);
+
+    state->items_per_iteration = num_elements;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GArray *result = g_array_merge_k(runs, k, compare_uint32);
+        bench_do_not_optimize(result->data);
+
+        bench_pause_timing(state);
+        g_array_free(result, true);
+        bench_resume_timing(state);
+    }
+
+    bench_pause_timing(state);
+    for (unsigned int r = 0; r < k; r++) {
+        g_array_free(runs[r], true);
+    }
+    free(runs);
+}
+
+static uint64_t records_released;
+
+static void release_record(void *data)
+{
+    records_released += ((Record*) data)->payload;
+}
+
+static void release_records(void *first, size_t count)
+{
+    const Record *records = first;
+
+    for (size_t i = 0; i < count; i++) {
+        records_released += records[i].payload;
+    }
+}
+
+static void bench_free_records(BenchState *state, bool range)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_records(state->arg, i);
+        if (range) {
+            g_array_set_clear_range_func(array, release_records);
+        } else {
+            g_array_set_clear_func(array, release_record);
+        }
+        bench_resume_timing(state);
+
+        g_array_free(array, true);
+    }
+
+    bench_do_not_optimize(records_released);
+}
+
+void bench_garray_free_clear_func(BenchState *state)
+{
+    bench_free_records(state, false);
+}
+
+void bench_garray_free_clear_range_func(BenchState *state)
+{
+    bench_free_records(state, true);
+}
+
+void bench_garray_binary_search(BenchState *state)
+{
+    uint64_t seed = 7;
+    unsigned int match_index;
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    g_array_sort(array, compare_uint32);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (int j = 0; j < 1000; j++) {
+            uint32_t target = ((uint32_t*) array->data)[bench_random(&seed) % array->len];
+            bool found = g_array_binary_search(array, &target, compare_uint32, &match_index);
+            bench_do_not_optimize(found);
+        }
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_lower_bound(BenchState *state)
+{
+    uint64_t seed = 7;
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    g_array_sort(array, compare_uint32);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (int j = 0; j < 1000; j++) {
+            uint32_t target = (uint32_t) bench_random(&seed);
+            unsigned int pos = g_array_lower_bound(array, &target, compare_uint32);
+            bench_do_not_optimize(pos);
+        }
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_lower_bound_u32(BenchState *state)
+{
+    uint64_t seed = 7;
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    g_array_sort(array, compare_uint32);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (int j = 0; j < 1000; j++) {
+            unsigned int pos = g_array_lower_bound_u32(array, (uint32_t) bench_random(&seed));
+            bench_do_not_optimize(pos);
+        }
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_lower_bound_batch(BenchState *state)
+{
+    uint64_t seed = 7;
+    uint32_t targets[1000];
+    unsigned int positions[1000];
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    g_array_sort(array, compare_uint32);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (int j = 0; j < 1000; j++) {
+            targets[j] = (uint32_t) bench_random(&seed);
+        }
+
+        g_array_lower_bound_batch(array, targets, 1000, compare_uint32, positions);
+        bench_do_not_optimize(positions[999]);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_lower_bound_batch_u32(BenchState *state)
+{
+    uint64_t seed = 7;
+    uint32_t targets[1000];
+    unsigned int positions[1000];
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    g_array_sort(array, compare_uint32);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (int j = 0; j < 1000; j++) {
+            targets[j] = (uint32_t) bench_random(&seed);
+        }
+
+        g_array_lower_bound_batch_u32(array, targets, 1000, positions);
+        bench_do_not_optimize(positions[999]);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_search_index(BenchState *state)
+{
+    uint64_t seed = 7;
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    g_array_sort(array, compare_uint32);
+    GArraySearchIndex *index = g_array_search_index_new(array, compare_uint32);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = 1000;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (int j = 0; j < 1000; j++) {
+            uint32_t target = ((uint32_t*) array->data)[bench_random(&seed) % array->len];
+            unsigned int pos = g_array_search_index_lower_bound(index, &target);
+            bench_do_not_optimize(pos);
+        }
+    }
+
+    bench_pause_timing(state);
+    g_array_search_index_free(index);
+    g_array_free(array, true);
+}
+
+void bench_garray_find_u32(BenchState *state)
+{
+    unsigned int index;
+
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    // the target isn't in the array, so every element is compared
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bool found = g_array_find_u32(array, 0x12345678, &index);
+        bench_do_not_optimize(found);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_count_range_u32(BenchState *state)
+{
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        unsigned int count = g_array_count_range_u32(array, 0, UINT32_MAX / 2);
+        bench_do_not_optimize(count);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_garray_filter_range_u32(BenchState *state)
+{
+    bench_pause_timing(state);
+    GArray *array = create_random_array(state->arg, 42);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    // keeps about every tenth element
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GArray *result = g_array_filter_range_u32(array, 0, UINT32_MAX / 10);
+        bench_do_not_optimize(result->data);
+
+        bench_pause_timing(state);
+        g_array_free(result, true);
+        bench_resume_timing(state);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+static GArray* create_sorted_set(uint64_t num_elements, uint32_t max_gap, uint64_t seed)
+{
+    GArray *array = g_array_sized_new(false, false, sizeof(uint32_t), (unsigned int) num_elements);
+    uint32_t val = 0;
+
+    for (uint64_t i = 0; i < num_elements; i++) {
+        val += 1 + (uint32_t) (bench_random(&seed) % max_gap);
+        g_array_append_val(array, val);
+    }
+
+    return array;
+}
+
+static void bench_sorted_intersect(BenchState *state, uint64_t len_a, uint64_t len_b, bool typed)
+{
+    bench_pause_timing(state);
+    // gaps of 1 to 8 in the larger set, so two sets of the same size overlap
+    // in about a quarter of their elements, and proportionally larger gaps in
+    // the smaller one to cover the same range
+    GArray *a = create_sorted_set(len_a, (uint32_t) (8 * len_b / len_a), 42);
+    GArray *b = create_sorted_set(len_b, 8, 43);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = len_a + len_b;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GArray *result = typed ? g_array_sorted_intersect_u32(a, b) : g_array_sorted_intersect(a, b, compare_uint32);
+        bench_do_not_optimize(result->data);
+
+        bench_pause_timing(state);
+        g_array_free(result, true);
+        bench_resume_timing(state);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(a, true);
+    g_array_free(b, true);
+}
+
+void bench_garray_sorted_intersect(BenchState *state)
+{
+    bench_sorted_intersect(state, state->arg, state->arg, false);
+}
+
+void bench_garray_sorted_intersect_u32(BenchState *state)
+{
+    bench_sorted_intersect(state, state->arg, state->arg, true);
+}
+
+// a small list against one that is 1000 times larger
+void bench_garray_sorted_intersect_u32_skewed(BenchState *state)
+{
+    bench_sorted_intersect(state, state->arg / 1000, state->arg, true);
+}
+
+typedef struct {
+    uint64_t id;
+    uint32_t price;
+    uint32_t quantity;
+    char padding[48];
+} WideRecord;
+
+void bench_garray_scan_field(BenchState *state)
+{
+    GArray *array;
+    uint64_t seed = 42;
+
+    bench_pause_timing(state);
+    array = g_array_sized_new(false, true, sizeof(WideRecord), (unsigned int) state->arg);
+    g_array_set_size(array, (unsigned int) state->arg);
+    for (uint64_t i = 0; i < state->arg; i++) {
+        ((WideRecord*) array->data)[i].price = (uint32_t) bench_random(&seed);
+    }
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        uint64_t sum = 0;
+
+        for (unsigned int j = 0; j < array->len; j++) {
+            sum += ((WideRecord*) array->data)[j].price;
+        }
+        bench_do_not_optimize(sum);
+    }
+
+    bench_pause_timing(state);
+    g_array_free(array, true);
+}
+
+void bench_gcolumnarray_scan_column(BenchState *state)
+{
+    const unsigned int sizes[] = {sizeof(uint64_t), sizeof(uint32_t), sizeof(uint32_t), 48};
+    GColumnArray *array;
+    GArray *prices;
+    uint64_t seed = 42;
+
+    bench_pause_timing(state);
+    array = g_column_array_sized_new(4, sizes, (unsigned int) state->arg);
+    g_column_array_set_size(array, (unsigned int) state->arg);
+    prices = g_column_array_get_column(array, 1);
+    for (uint64_t i = 0; i < state->arg; i++) {
+        ((uint32_t*) prices->data)[i] = (uint32_t) bench_random(&seed);
+    }
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        uint64_t sum = 0;
+
+        for (unsigned int j = 0; j < prices->len; j++) {
+            sum += ((uint32_t*) prices->data)[j];
+        }
+        bench_do_not_optimize(sum);
+    }
+
+    bench_pause_timing(state);
+    g_column_array_free(array);
+}
+
+void bench_garray_remove_index_fast(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GArray *array = create_random_array(state->arg, 42);
+        bench_resume_timing(state);
+
+        while (array->len > 0) {
+            g_array_remove_index_fast(array, 0);
+        }
+
+        bench_pause_timing(state);
+        g_array_free(array, true);
+        bench_resume_timing(state);
+    }
+}
+
+static const Benchmark benchmarks[] = {
+    BENCHMARK(bench_garray_append_val, 100),
+    BENCHMARK(bench_garray_append_val, 10000),
+    BENCHMARK(bench_garray_append_val, 1000000),
+    BENCHMARK(bench_garray_append_val, 100000000),
+    BENCHMARK(bench_garray_tiny, 6),
+    BENCHMARK(bench_garray_tiny_small, 6),
+    BENCHMARK(bench_garray_set_size_clear, 1000000),
+    BENCHMARK(bench_garray_set_size_clear, 100000000),
+    BENCHMARK(bench_gchunkarray_append_val, 1000000),
+    BENCHMARK(bench_gchunkarray_append_val, 100000000),
+    BENCHMARK(bench_garray_prepend_val, 100),
+    BENCHMARK(bench_garray_prepend_val, 10000),
+    BENCHMARK(bench_garray_iterate, 1000000),
+    BENCHMARK(bench_garray_sort, 100),
+    BENCHMARK(bench_garray_sort, 10000),
+    BENCHMARK(bench_garray_sort, 1000000),
+    BENCHMARK(bench_garray_sort_typed, 100),
+    BENCHMARK(bench_garray_sort_typed, 10000),
+    BENCHMARK(bench_garray_sort_typed, 1000000),
+    BENCHMARK(bench_garray_sort_records, 1000000),
+    BENCHMARK(bench_garray_sort_records_typed, 1000000),
+    BENCHMARK(bench_garray_stable_sort, 1000000),
+    BENCHMARK(bench_garray_sort_nearly_sorted, 1000000),
+    BENCHMARK(bench_garray_stable_sort_nearly_sorted, 1000000),
+    BENCHMARK(bench_garray_sort_parallel, 1),
+    BENCHMARK(bench_garray_sort_parallel, 2),
+    BENCHMARK(bench_garray_sort_parallel, 4),
+    BENCHMARK(bench_garray_sort_parallel, 8),
+    BENCHMARK(bench_garray_sort_parallel, 16),
+    BENCHMARK(bench_garray_sort_parallel, 32),
+    BENCHMARK(bench_garray_sort_parallel, 64),
+    BENCHMARK(bench_garray_parallel_foreach, 1),
+    BENCHMARK(bench_garray_parallel_foreach, 2),
+    BENCHMARK(bench_garray_parallel_foreach, 4),
+    BENCHMARK(bench_garray_parallel_foreach, 8),
+    BENCHMARK(bench_garray_parallel_reduce, 1),
+    BENCHMARK(bench_garray_parallel_reduce, 4),
+    BENCHMARK(bench_garray_radix_sort, 100),
+    BENCHMARK(bench_garray_radix_sort, 10000),
+    BENCHMARK(bench_garray_radix_sort, 1000000),
+    BENCHMARK(bench_garray_radix_sort_records, 1000000),
+    BENCHMARK(bench_garray_merge_k, 16),
+    BENCHMARK(bench_garray_merge_k, 256),
+    BENCHMARK(bench_garray_binary_search, 1000),
+    BENCHMARK(bench_garray_binary_search, 1000000),
+    BENCHMARK(bench_garray_binary_search, 10000000),
+    BENCHMARK(bench_garray_lower_bound, 1000),
+    BENCHMARK(bench_garray_lower_bound, 10000000),
+    BENCHMARK(bench_garray_lower_bound_u32, 1000),
+    BENCHMARK(bench_garray_lower_bound_u32, 10000000),
+    BENCHMARK(bench_garray_lower_bound_batch, 10000000),
+    BENCHMARK(bench_garray_lower_bound_batch_u32, 1000),
+    BENCHMARK(bench_garray_lower_bound_batch_u32, 10000000),
+    BENCHMARK(bench_garray_search_index, 1000),
+    BENCHMARK(bench_garray_search_index, 1000000),
+    BENCHMARK(bench_garray_search_index, 10000000),
+    BENCHMARK(bench_garray_remove_index_fast, 10000),
+    BENCHMARK(bench_garray_free_clear_func, 10000000),
+    BENCHMARK(bench_garray_free_clear_range_func, 10000000),
+    BENCHMARK(bench_garray_find_u32, 1000000),
+    BENCHMARK(bench_garray_count_range_u32, 1000000),
+    BENCHMARK(bench_garray_filter_range_u32, 1000000),
+    BENCHMARK(bench_garray_sorted_intersect, 1000000),
+    BENCHMARK(bench_garray_sorted_intersect_u32, 1000000),
+    BENCHMARK(bench_garray_sorted_intersect_u32_skewed, 1000000),
+    BENCHMARK(bench_garray_scan_field, 10000000),
+    BENCHMARK(bench_gcolumnarray_scan_column, 10000000),
+};
+
+int main(int argc, char **argv)
+{
+    return bench_main(argc, argv, benchmarks, BENCH_COUNT(benchmarks));
+}
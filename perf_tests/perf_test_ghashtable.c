@@ -1,76 +1,152 @@
 #include <stdio.h>
-#include <time.h>
 
 #define _CLIB_IMPL 1
 #include "ghashtable.h"
+#define BENCH_IMPL 1
+#include "bench.h"
 
-#define CALC_SECONDS(start, end) (double) (end - start) / CLOCKS_PER_SEC
-
-void measure_insert(uint32_t num_inserts)
+static GHashTable* create_table(uint64_t num_elements)
 {
     GHashTable *htable = g_hash_table_new(g_int_hash, g_int_equal);
 
-    int start_time = clock();
+    for (uint64_t i = 0; i < num_elements; i++) {
+        g_hash_table_insert(htable, (void*) (i + 1), (void*) "Hello World");
+    }
 
-    for (uint32_t i = 0; i < num_inserts; i++) {
-        g_hash_table_insert(htable, (void*) (uint64_t) i, (void*) "Hello World");
+    return htable;
+}
+
+void bench_ghashtable_insert(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GHashTable *htable = create_table(state->arg);
+
+        bench_pause_timing(state);
+        g_hash_table_destroy(htable);
+        bench_resume_timing(state);
     }
+}
 
-    int end_time = clock();
-    g_hash_table_destroy(htable);
+void bench_ghashtable_lookup(BenchState *state)
+{
+    bench_pause_timing(state);
+    GHashTable *htable = create_table(state->arg);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
 
-    printf("Inserting %-7d elements: %fs\n", num_inserts, CALC_SECONDS(start_time, end_time));
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (uint64_t j = 1; j <= state->arg; j++) {
+            void *value = g_hash_table_lookup(htable, (void*) j);
+            bench_do_not_optimize(value);
+        }
+    }
+
+    bench_pause_timing(state);
+    g_hash_table_destroy(htable);
 }
 
-void measure_lookup(uint32_t num_lookups)
+void bench_ghashtable_lookup_random(BenchState *state)
 {
-    GHashTable *htable = g_hash_table_new(g_int_hash, g_int_equal);
+    uint64_t seed = 42;
+
+    bench_pause_timing(state);
+    GHashTable *htable = create_table(state->arg);
+    bench_resume_timing(state);
 
-    for (uint32_t i = 0; i < num_lookups; i++) {
-        g_hash_table_insert(htable, (void*) (uint64_t) i, (void*) "Hello World");
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (uint64_t j = 0; j < state->arg; j++) {
+            uint64_t key = bench_random(&seed) % state->arg + 1;
+            void *value = g_hash_table_lookup(htable, (void*) key);
+            bench_do_not_optimize(value);
+        }
     }
 
-    int start_time = clock();
+    bench_pause_timing(state);
+    g_hash_table_destroy(htable);
+}
+
+void bench_ghashtable_lookup_miss(BenchState *state)
+{
+    bench_pause_timing(state);
+    GHashTable *htable = create_table(state->arg);
+    bench_resume_timing(state);
 
-    for (uint32_t i = 0; i < num_lookups; i++) {
-        g_hash_table_lookup(htable, (void*) (uint64_t) i);
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (uint64_t j = 1; j <= state->arg; j++) {
+            void *value = g_hash_table_lookup(htable, (void*) (j + state->arg));
+            bench_do_not_optimize(value);
+        }
     }
 
-    int end_time = clock();
+    bench_pause_timing(state);
     g_hash_table_destroy(htable);
+}
+
+void bench_ghashtable_remove(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GHashTable *htable = create_table(state->arg);
+        bench_resume_timing(state);
+
+        for (uint64_t j = 1; j <= state->arg; j++) {
+            g_hash_table_remove(htable, (void*) j);
+        }
 
-    printf("Looking up %-7d elements: %fs\n", num_lookups, CALC_SECONDS(start_time, end_time));
+        bench_pause_timing(state);
+        g_hash_table_destroy(htable);
+        bench_resume_timing(state);
+    }
 }
 
-void perf_test_insert()
+static void count_entry(void *key, void *value, void *user_data)
 {
-    printf("= perf_test_insert =\n\n");
-
-    measure_insert(10);
-    measure_insert(100);
-    measure_insert(1000);
-    measure_insert(10000);
-    measure_insert(100000);
-    measure_insert(1000000);
+    (*(uint64_t*) user_data)++;
 }
 
-void perf_test_lookup()
+void bench_ghashtable_foreach(BenchState *state)
 {
-    printf("= perf_test_lookup =\n\n");
-
-    measure_lookup(10);
-    measure_lookup(100);
-    measure_lookup(1000);
-    measure_lookup(10000);
-    measure_lookup(100000);
-    measure_lookup(1000000);
+    uint64_t count = 0;
+
+    bench_pause_timing(state);
+    GHashTable *htable = create_table(state->arg);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        g_hash_table_foreach(htable, count_entry, &count);
+    }
+    bench_do_not_optimize(count);
+
+    bench_pause_timing(state);
+    g_hash_table_destroy(htable);
 }
 
+static const Benchmark benchmarks[] = {
+    BENCHMARK(bench_ghashtable_insert, 100),
+    BENCHMARK(bench_ghashtable_insert, 10000),
+    BENCHMARK(bench_ghashtable_insert, 1000000),
+    BENCHMARK(bench_ghashtable_lookup, 100),
+    BENCHMARK(bench_ghashtable_lookup, 10000),
+    BENCHMARK(bench_ghashtable_lookup, 1000000),
+    BENCHMARK(bench_ghashtable_lookup_random, 10000),
+    BENCHMARK(bench_ghashtable_lookup_random, 1000000),
+    BENCHMARK(bench_ghashtable_lookup_miss, 10000),
+    BENCHMARK(bench_ghashtable_remove, 10000),
+    BENCHMARK(bench_ghashtable_foreach, 10000),
+};
+
 int main(int argc, char **argv)
 {
-    perf_test_insert();
-    printf("\n\n");
-    perf_test_lookup();
-
-    return 0;
+    return bench_main(argc, argv, benchmarks, BENCH_COUNT(benchmarks));
 }
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define _CLIB_IMPL 1
+#include "glist.h"
+#define BENCH_IMPL 1
+#include "bench.h"
+
+static int compare_uint(const void *a, const void *b)
+{
+    uintptr_t x = (uintptr_t) a;
+    uintptr_t y = (uintptr_t) b;
+
+    return (x > y) - (x < y);
+}
+
+static GList* create_random_list(uint64_t num_elements, uint64_t seed)
+{
+    GList *list = NULL;
+
+    for (uint64_t i = 0; i < num_elements; i++) {
+        list = g_list_prepend(list, (void*) (uintptr_t) (bench_random(&seed) & 0xffffffff));
+    }
+
+    return list;
+}
+
+void bench_glist_prepend(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GList *list = NULL;
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            list = g_list_prepend(list, (void*) (uintptr_t) j);
+        }
+
+        bench_pause_timing(state);
+        g_list_free(list);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_glist_append(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GList *list = NULL;
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            list = g_list_append(list, (void*) (uintptr_t) j);
+        }
+
+        bench_pause_timing(state);
+        g_list_free(list);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_glist_iterate(BenchState *state)
+{
+    uintptr_t sum = 0;
+
+    bench_pause_timing(state);
+    GList *list = create_random_list(state->arg, 42);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        for (GList *cur = list; cur; cur = cur->next) {
+            sum += (uintptr_t) cur->data;
+        }
+        bench_do_not_optimize(sum);
+    }
+
+    bench_pause_timing(state);
+    g_list_free(list);
+}
+
+void bench_glist_sort(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GList *list = create_random_list(state->arg, i);
+        bench_resume_timing(state);
+
+        list = g_list_sort(list, compare_uint);
+        bench_do_not_optimize(list);
+
+        bench_pause_timing(state);
+        g_list_free(list);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_glist_reverse(BenchState *state)
+{
+    bench_pause_timing(state);
+    GList *list = create_random_list(state->arg, 42);
+    bench_resume_timing(state);
+
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        list = g_list_reverse(list);
+        bench_do_not_optimize(list);
+    }
+
+    bench_pause_timing(state);
+    g_list_free(list);
+}
+
+void bench_glist_find(BenchState *state)
+{
+    uint64_t seed = 7;
+
+    bench_pause_timing(state);
+    GList *list = create_random_list(state->arg, 42);
+    bench_resume_timing(state);
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        void *data = g_list_nth_data(list, (uint32_t) (bench_random(&seed) % state->arg));
+        GList *found = g_list_find(list, data);
+        bench_do_not_optimize(found);
+    }
+
+    bench_pause_timing(state);
+    g_list_free(list);
+}
+
+static const Benchmark benchmarks[] = {
+    BENCHMARK(bench_glist_prepend, 100),
+    BENCHMARK(bench_glist_prepend, 10000),
+    BENCHMARK(bench_glist_prepend, 1000000),
+    BENCHMARK(bench_glist_append, 100),
+    BENCHMARK(bench_glist_append, 10000),
+    BENCHMARK(bench_glist_iterate, 1000000),
+    BENCHMARK(bench_glist_sort, 100),
+    BENCHMARK(bench_glist_sort, 10000),
+    BENCHMARK(bench_glist_sort, 1000000),
+    BENCHMARK(bench_glist_reverse, 10000),
+    BENCHMARK(bench_glist_find, 1000),
+    BENCHMARK(bench_glist_find, 100000),
+};
+
+int main(int argc, char **argv)
+{
+    return bench_main(argc, argv, benchmarks, BENCH_COUNT(benchmarks));
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+
+#define _CLIB_IMPL 1
+#include "gstring.h"
+#define BENCH_IMPL 1
+#include "bench.h"
+
+void bench_gstring_append(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GString *string = g_string_new(NULL);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_append(string, "Hello World");
+        }
+        bench_do_not_optimize(string->str);
+
+        bench_pause_timing(state);
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gstring_append_c(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GString *string = g_string_new(NULL);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_append_c(string, 'a' + (j % 26));
+        }
+        bench_do_not_optimize(string->str);
+
+        bench_pause_timing(state);
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gstring_prepend(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GString *string = g_string_new(NULL);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_prepend(string, "Hello World");
+        }
+        bench_do_not_optimize(string->str);
+
+        bench_pause_timing(state);
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gstring_append_printf(BenchState *state)
+{
+    state->items_per_iteration = state->arg;
+
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        GString *string = g_string_new(NULL);
+
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_append_printf(string, "%d: %s\n", (int) j, "Hello World");
+        }
+        bench_do_not_optimize(string->str);
+
+        bench_pause_timing(state);
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+void bench_gstring_replace(BenchState *state)
+{
+    for (uint64_t i = 0; i < state->iterations; i++) {
+        bench_pause_timing(state);
+        GString *string = g_string_new(NULL);
+        for (uint64_t j = 0; j < state->arg; j++) {
+            g_string_append(string, "Hello World ");
+        }
+        bench_resume_timing(state);
+
+        unsigned int replaced = g_string_replace(string, "World", "Universe", 0);
+        bench_do_not_optimize(replaced);
+
+        bench_pause_timing(state);
+        g_string_free(string, true);
+        bench_resume_timing(state);
+    }
+}
+
+static const Benchmark benchmarks[] = {
+    BENCHMARK(bench_gstring_append, 100),
+    BENCHMARK(bench_gstring_append, 10000),
+    BENCHMARK(bench_gstring_append, 1000000),
+    BENCHMARK(bench_gstring_append_c, 100),
+    BENCHMARK(bench_gstring_append_c, 1000000),
+    BENCHMARK(bench_gstring_prepend, 100),
+    BENCHMARK(bench_gstring_prepend, 10000),
+    BENCHMARK(bench_gstring_append_printf, 10000),
+    BENCHMARK(bench_gstring_replace, 100),
+    BENCHMARK(bench_gstring_replace, 10000),
+};
+
+int main(int argc, char **argv)
+{
+    return bench_main(argc, argv, benchmarks, BENCH_COUNT(benchmarks));
+}
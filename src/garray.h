@@ -38,14 +38,108 @@ void qsort_r(void *base, size_t nmemb, size_t size, int (*compar)(const void *,
 #include <search.h>
 #endif
 
+// Parallel functions use threads unless GARRAY_NO_THREADS is defined. Link
+// with -pthread on POSIX systems.
+#if defined(_CLIB_IMPL) && !defined(GARRAY_NO_THREADS)
+#if (defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
+// Vector instructions for the typed linear searches. AVX2 is used if the
+// compiler targets it (e.g. -mavx2 or -march=native). Define GARRAY_NO_SIMD to
+// use plain C only.
+#if defined(_CLIB_IMPL) && !defined(GARRAY_NO_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define _G_ARRAY_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define _G_ARRAY_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define _G_ARRAY_NEON
+#endif
+#endif
+
+// Needed for file-backed arrays
+#if defined(_CLIB_IMPL) && !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
 #include <string.h>
 
+#include "gmem.h"
+
+// Capacity grows by at least this factor when an array runs out of space so
+// that appending is amortized O(1)
+#ifndef GARRAY_GROWTH_FACTOR
+#define GARRAY_GROWTH_FACTOR 2.0
+#endif
+
+// Every thread of g_array_sort_parallel gets at least this many elements, so
+// smaller arrays are sorted by a single thread
+#ifndef GARRAY_PARALLEL_SORT_THRESHOLD
+#define GARRAY_PARALLEL_SORT_THRESHOLD 100000
+#endif
+
+// Upper limit for the number of threads the caller asks for in
+// g_array_sort_parallel and g_array_thread_pool_new. Passing 0 uses one
+// thread per CPU instead
+#ifndef GARRAY_MAX_THREADS
+#define GARRAY_MAX_THREADS 256
+#endif
+
+// g_array_parallel_foreach and g_array_parallel_reduce hand out the elements
+// in chunks of about this many bytes. Smaller chunks balance uneven work
+// better, larger ones take less bookkeeping
+#ifndef GARRAY_PARALLEL_CHUNK_SIZE
+#define GARRAY_PARALLEL_CHUNK_SIZE 16384
+#endif
+
+// Arrays with fewer elements are processed by the calling thread in
+// g_array_parallel_foreach and g_array_parallel_reduce
+#ifndef GARRAY_PARALLEL_FOREACH_THRESHOLD
+#define GARRAY_PARALLEL_FOREACH_THRESHOLD 1024
+#endif
+
+// The set operations on sorted arrays switch from walking both arrays to
+// searching the larger one if it has more than this many times the elements
+// of the smaller one
+#ifndef GARRAY_GALLOP_RATIO
+#define GARRAY_GALLOP_RATIO 32
+#endif
+
+// Define GARRAY_GROW_POW2 to additionally round the capacity up to the next
+// power of two like GLib does
+
 typedef int(*GCompareFunc) (const void *a, const void *b);
 typedef int(*GCompareDataFunc) (const void *a, const void *b, void *user_data);
 typedef void (*GDestroyNotify)(void *data);
+typedef void (*GDestroyRangeNotify)(void *first, size_t count);
+typedef bool (*GArrayPredicateFunc)(const void *element, void *user_data);
+typedef void (*GArrayForeachFunc)(void *element, void *user_data);
+typedef void (*GArrayReduceFunc)(void *accumulator, const void *element, void *user_data);
+typedef void (*GArrayCombineFunc)(void *accumulator, const void *other, void *user_data);
+
+typedef enum GArrayRadixFlags {
+    G_ARRAY_RADIX_UNSIGNED = 0,
+    G_ARRAY_RADIX_SIGNED = 1 << 0, // two's complement integer keys
+    G_ARRAY_RADIX_FLOAT = 1 << 1, // IEEE 754 float (width 4) or double (width 8) keys
+    G_ARRAY_RADIX_DESCENDING = 1 << 2
+} GArrayRadixFlags;
 
 typedef struct GArray {
     char *data;
@@ -53,14 +147,86 @@ typedef struct GArray {
     unsigned int _allocated_elements;
     bool _zero_terminated;
     bool _clear;
+    bool _mapped; // data is mapped by gmem.h instead of allocated
+    bool _inline; // data is the inline storage of a G_ARRAY_SMALL
+    bool _embedded; // the GArray is part of a G_ARRAY_SMALL and not allocated
+    bool _file_writable;
+    unsigned int _dirty_elements; // with _clear: elements from here on are still zero
+    int _fd; // file mapped to data by g_array_new_from_file or -1
     unsigned int _element_size;
     GDestroyNotify _clear_func;
+    GDestroyRangeNotify _clear_range_func; // replaces _clear_func if set
 } GArray;
 
+// Copy of a sorted array in Eytzinger (BFS) order for fast searches
+typedef struct GArraySearchIndex {
+    char *data; // element i of the tree is at data[i * element_size], 1-based
+    unsigned int len;
+    unsigned int _element_size;
+    unsigned int _full_levels; // levels of the tree without the last partial one
+    size_t _last_level_len;
+    GCompareFunc _compare_func;
+} GArraySearchIndex;
+
+// Range of len elements starting at data; the elements belong to an array
+typedef struct GArrayView {
+    char *data;
+    unsigned int len;
+    unsigned int element_size;
+} GArrayView;
+
+// State of a k-way merge of sorted arrays, see g_array_merger_new
+typedef struct GArrayMerger {
+    GArray **arrays;
+    unsigned int k;
+    size_t remaining; // elements that haven't been returned yet
+    unsigned int _element_size;
+    const char **_heads; // next element of each array, NULL once it's used up
+    const char **_ends;
+    unsigned int *_tree; // winner in 0, losers of the matches in 1 to k - 1
+    GCompareFunc _compare_func;
+} GArrayMerger;
+
+// Worker threads for g_array_parallel_foreach and g_array_parallel_reduce
+typedef struct GArrayThreadPool GArrayThreadPool;
+
+/*
+ * G_ARRAY_SMALL(type, n) is a GArray with inline storage for n elements (for
+ * zero-terminated arrays including the terminator). It lives on the stack or
+ * inside another struct and only allocates memory once it grows beyond n
+ * elements:
+ *
+ *   G_ARRAY_SMALL(int, 8) small = G_ARRAY_SMALL_INITIALIZER(small, false, false);
+ *   GArray *array = &small.array;
+ *   ...
+ *   g_array_free(array, true); // releases heap storage only
+ *
+ * g_array_small_init(&small, zero_terminated, clear) does the same at runtime.
+ */
+#define G_ARRAY_SMALL(type, n) struct { GArray array; type inline_data[n]; }
+#define G_ARRAY_SMALL_INITIALIZER(small, zero_terminated, clear) {\
+    .array = {\
+        .data = (char*) (small).inline_data,\
+        ._allocated_elements = sizeof((small).inline_data) / sizeof((small).inline_data[0]),\
+        ._zero_terminated = (zero_terminated),\
+        ._clear = (clear),\
+        ._inline = true,\
+        ._embedded = true,\
+        ._fd = -1,\
+        ._element_size = sizeof((small).inline_data[0])\
+    }\
+}
+#define g_array_small_init(small, zero_terminated, clear) _g_array_small_init(&(small)->array, zero_terminated, clear,\
+    sizeof((small)->inline_data[0]), (small)->inline_data, sizeof((small)->inline_data) / sizeof((small)->inline_data[0]))
+GArray* _g_array_small_init(GArray *array, bool zero_terminated, bool clear, unsigned int element_size,
+    void *inline_data, unsigned int inline_elements);
+
 GArray* g_array_new(bool zero_terminated, bool clear, unsigned int element_size);
 void* g_array_steal(GArray *array, size_t *len);
 GArray* g_array_sized_new(bool zero_terminated, bool clear, unsigned int element_size, unsigned int reserved_size);
 GArray* g_array_copy(GArray *array);
+GArray* g_array_new_from_file(const char *filename, unsigned int element_size, bool writable);
+bool g_array_sync(GArray *array);
 unsigned int g_array_get_element_size(GArray *array);
 #define g_array_append_val(a, v) g_array_append_vals(a, &v, 1);
 GArray* g_array_append_vals (GArray *array, const void *data, unsigned int len);
@@ -71,15 +237,298 @@ GArray* g_array_insert_vals (GArray *array, unsigned int index, const void *data
 GArray* g_array_remove_index(GArray *array, unsigned int index);
 GArray* g_array_remove_index_fast(GArray *array, unsigned int index);
 GArray* g_array_remove_range(GArray *array, unsigned int index, unsigned int length);
+GArray* g_array_truncate(GArray *array, unsigned int length);
 void g_array_sort(GArray *array, GCompareFunc compare_func);
 void g_array_sort_with_data(GArray *array, GCompareDataFunc compare_func, void *user_data);
+void g_array_stable_sort(GArray *array, GCompareFunc compare_func);
+void g_array_stable_sort_with_data(GArray *array, GCompareDataFunc compare_func, void *user_data);
+void g_array_stable_sort_with_buffer(GArray *array, GCompareFunc compare_func, GArray *scratch);
+void g_array_radix_sort(GArray *array, size_t key_offset, unsigned int key_width, GArrayRadixFlags flags);
+void g_array_sort_parallel(GArray *array, GCompareFunc compare_func, unsigned int num_threads);
+void g_array_sort_parallel_with_data(GArray *array, GCompareDataFunc compare_func, void *user_data, unsigned int num_threads);
+void g_array_foreach(GArray *array, GArrayForeachFunc func, void *user_data);
+void g_array_parallel_foreach(GArray *array, GArrayThreadPool *pool, GArrayForeachFunc func, void *user_data);
+void g_array_parallel_reduce(GArray *array, GArrayThreadPool *pool, void *result, size_t result_size,
+    GArrayReduceFunc reduce_func, GArrayCombineFunc combine_func, void *user_data);
 bool g_array_binary_search(GArray *array, const void *target, GCompareFunc compare_func, unsigned int *out_match_index);
+unsigned int g_array_lower_bound(GArray *array, const void *target, GCompareFunc compare_func);
+unsigned int g_array_upper_bound(GArray *array, const void *target, GCompareFunc compare_func);
+bool g_array_equal_range(GArray *array, const void *target, GCompareFunc compare_func, unsigned int *out_begin, unsigned int *out_end);
+void g_array_lower_bound_batch(GArray *array, const void *targets, unsigned int num_targets, GCompareFunc compare_func, unsigned int *out_positions);
+void g_array_upper_bound_batch(GArray *array, const void *targets, unsigned int num_targets, GCompareFunc compare_func, unsigned int *out_positions);
+unsigned int g_array_lower_bound_u32(GArray *array, uint32_t target);
+unsigned int g_array_upper_bound_u32(GArray *array, uint32_t target);
+void g_array_lower_bound_batch_u32(GArray *array, const uint32_t *targets, unsigned int num_targets, unsigned int *out_positions);
+void g_array_upper_bound_batch_u32(GArray *array, const uint32_t *targets, unsigned int num_targets, unsigned int *out_positions);
+unsigned int g_array_lower_bound_i32(GArray *array, int32_t target);
+unsigned int g_array_upper_bound_i32(GArray *array, int32_t target);
+void g_array_lower_bound_batch_i32(GArray *array, const int32_t *targets, unsigned int num_targets, unsigned int *out_positions);
+void g_array_upper_bound_batch_i32(GArray *array, const int32_t *targets, unsigned int num_targets, unsigned int *out_positions);
+unsigned int g_array_lower_bound_u64(GArray *array, uint64_t target);
+unsigned int g_array_upper_bound_u64(GArray *array, uint64_t target);
+void g_array_lower_bound_batch_u64(GArray *array, const uint64_t *targets, unsigned int num_targets, unsigned int *out_positions);
+void g_array_upper_bound_batch_u64(GArray *array, const uint64_t *targets, unsigned int num_targets, unsigned int *out_positions);
+unsigned int g_array_lower_bound_i64(GArray *array, int64_t target);
+unsigned int g_array_upper_bound_i64(GArray *array, int64_t target);
+void g_array_lower_bound_batch_i64(GArray *array, const int64_t *targets, unsigned int num_targets, unsigned int *out_positions);
+void g_array_upper_bound_batch_i64(GArray *array, const int64_t *targets, unsigned int num_targets, unsigned int *out_positions);
+bool g_array_find_u32(GArray *array, uint32_t target, unsigned int *out_index);
+bool g_array_find_u64(GArray *array, uint64_t target, unsigned int *out_index);
+bool g_array_find_f32(GArray *array, float target, unsigned int *out_index);
+unsigned int g_array_count_if(GArray *array, GArrayPredicateFunc predicate, void *user_data);
+unsigned int g_array_count_range_u32(GArray *array, uint32_t min, uint32_t max);
+GArray* g_array_filter(GArray *array, GArrayPredicateFunc predicate, void *user_data);
+GArray* g_array_filter_range_u32(GArray *array, uint32_t min, uint32_t max);
+GArray* g_array_sorted_intersect(GArray *a, GArray *b, GCompareFunc compare_func);
+GArray* g_array_sorted_union(GArray *a, GArray *b, GCompareFunc compare_func);
+GArray* g_array_sorted_difference(GArray *a, GArray *b, GCompareFunc compare_func);
+GArray* g_array_sorted_merge(GArray *a, GArray *b, GCompareFunc compare_func);
+GArray* g_array_sorted_intersect_u32(GArray *a, GArray *b);
+GArray* g_array_sorted_union_u32(GArray *a, GArray *b);
+GArray* g_array_sorted_difference_u32(GArray *a, GArray *b);
+GArray* g_array_sorted_merge_u32(GArray *a, GArray *b);
+GArray* g_array_sorted_intersect_i32(GArray *a, GArray *b);
+GArray* g_array_sorted_union_i32(GArray *a, GArray *b);
+GArray* g_array_sorted_difference_i32(GArray *a, GArray *b);
+GArray* g_array_sorted_merge_i32(GArray *a, GArray *b);
+GArray* g_array_sorted_intersect_u64(GArray *a, GArray *b);
+GArray* g_array_sorted_union_u64(GArray *a, GArray *b);
+GArray* g_array_sorted_difference_u64(GArray *a, GArray *b);
+GArray* g_array_sorted_merge_u64(GArray *a, GArray *b);
+GArray* g_array_sorted_intersect_i64(GArray *a, GArray *b);
+GArray* g_array_sorted_union_i64(GArray *a, GArray *b);
+GArray* g_array_sorted_difference_i64(GArray *a, GArray *b);
+GArray* g_array_sorted_merge_i64(GArray *a, GArray *b);
 #define g_array_index(a, t, i) (t) a->data[i * a->_element_size]
 GArray* g_array_set_size(GArray *array, unsigned int length);
+GArray* g_array_reserve(GArray *array, unsigned int length);
+GArray* g_array_shrink_to_fit(GArray *array);
 void g_array_set_clear_func(GArray *array, GDestroyNotify clear_func);
+void g_array_set_clear_range_func(GArray *array, GDestroyRangeNotify clear_range_func);
+void g_array_memory_usage(GArray *array, GMemUsage *usage);
 
 char* g_array_free(GArray *array, bool free_segment);
 
+GArraySearchIndex* g_array_search_index_new(GArray *array, GCompareFunc compare_func);
+unsigned int g_array_search_index_lower_bound(GArraySearchIndex *index, const void *target);
+unsigned int g_array_search_index_upper_bound(GArraySearchIndex *index, const void *target);
+bool g_array_search_index_equal_range(GArraySearchIndex *index, const void *target, unsigned int *out_begin, unsigned int *out_end);
+void g_array_search_index_free(GArraySearchIndex *index);
+
+GArrayThreadPool* g_array_thread_pool_new(unsigned int num_threads);
+unsigned int g_array_thread_pool_get_num_threads(GArrayThreadPool *pool);
+void g_array_thread_pool_free(GArrayThreadPool *pool);
+
+GArray* g_array_merge_k(GArray **arrays, unsigned int k, GCompareFunc compare_func);
+GArrayMerger* g_array_merger_new(GArray **arrays, unsigned int k, GCompareFunc compare_func);
+unsigned int g_array_merger_next(GArrayMerger *merger, void *buffer, unsigned int max_elements);
+void g_array_merger_free(GArrayMerger *merger);
+
+GArrayView g_array_view(GArray *array, unsigned int index, unsigned int len);
+GArrayView g_array_view_slice(GArrayView view, unsigned int index, unsigned int len);
+#define g_array_view_index(v, t, i) (((t*) (void*) (v).data)[i])
+GArray* g_array_view_copy(GArrayView view);
+void g_array_view_sort(GArrayView view, GCompareFunc compare_func);
+void g_array_view_sort_with_data(GArrayView view, GCompareDataFunc compare_func, void *user_data);
+void g_array_view_stable_sort(GArrayView view, GCompareFunc compare_func);
+bool g_array_view_binary_search(GArrayView view, const void *target, GCompareFunc compare_func, unsigned int *out_match_index);
+unsigned int g_array_view_lower_bound(GArrayView view, const void *target, GCompareFunc compare_func);
+unsigned int g_array_view_upper_bound(GArrayView view, const void *target, GCompareFunc compare_func);
+bool g_array_view_find_u32(GArrayView view, uint32_t target, unsigned int *out_index);
+bool g_array_view_find_u64(GArrayView view, uint64_t target, unsigned int *out_index);
+bool g_array_view_find_f32(GArrayView view, float target, unsigned int *out_index);
+GArray* g_array_view_sorted_intersect(GArrayView a, GArrayView b, GCompareFunc compare_func);
+GArray* g_array_view_sorted_union(GArrayView a, GArrayView b, GCompareFunc compare_func);
+GArray* g_array_view_sorted_difference(GArrayView a, GArrayView b, GCompareFunc compare_func);
+GArray* g_array_view_sorted_merge(GArrayView a, GArrayView b, GCompareFunc compare_func);
+GArray* g_array_view_sorted_intersect_u32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_union_u32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_difference_u32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_merge_u32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_intersect_i32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_union_i32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_difference_i32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_merge_i32(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_intersect_u64(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_union_u64(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_difference_u64(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_merge_u64(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_intersect_i64(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_union_i64(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_difference_i64(GArrayView a, GArrayView b);
+GArray* g_array_view_sorted_merge_i64(GArrayView a, GArrayView b);
+
+#if defined(__GNUC__) || defined(__clang__)
+#define _G_ARRAY_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define _G_ARRAY_PREFETCH(addr) ((void) 0)
+#endif
+
+/*
+ * CLIB_DEFINE_ARRAY_SORT(name, type, less) defines a sort specialized for
+ * arrays of type:
+ *
+ *   void name(GArray *array);
+ *   void name##_data(type *data, size_t len);
+ *
+ * less(a, b) is called with two lvalues of type and has to return true if a
+ * must be sorted before b. It can be a macro so the comparison gets inlined.
+ * The sort is an introsort (quicksort with a median-of-three or ninther pivot,
+ * insertion sort for small ranges and heap sort if the recursion gets too
+ * deep) and is not stable.
+ *
+ *   #define POINT_LESS(a, b) ((a).x < (b).x)
+ *   CLIB_DEFINE_ARRAY_SORT(sort_points, struct point, POINT_LESS)
+ *   ...
+ *   sort_points(array);
+ */
+#define _GARRAY_SORT_INSERTION_THRESHOLD 16
+#define _GARRAY_SORT_NINTHER_THRESHOLD 128
+
+#define CLIB_DEFINE_ARRAY_SORT(name, type, less)\
+static inline void name##_swap(type *a, type *b)\
+{\
+    type tmp = *a;\
+    *a = *b;\
+    *b = tmp;\
+}\
+\
+static inline void name##_insertion_sort(type *data, size_t len)\
+{\
+    for (size_t i = 1; i < len; i++) {\
+        if (less(data[i], data[i - 1])) {\
+            type tmp = data[i];\
+            size_t j = i;\
+\
+            do {\
+                data[j] = data[j - 1];\
+                j--;\
+            } while (j > 0 && less(tmp, data[j - 1]));\
+\
+            data[j] = tmp;\
+        }\
+    }\
+}\
+\
+static inline void name##_sift_down(type *data, size_t root, size_t len)\
+{\
+    for (;;) {\
+        size_t child = 2 * root + 1;\
+\
+        if (child >= len) {\
+            break;\
+        }\
+\
+        if (child + 1 < len && less(data[child], data[child + 1])) {\
+            child++;\
+        }\
+\
+        if (!less(data[root], data[child])) {\
+            break;\
+        }\
+\
+        name##_swap(&data[root], &data[child]);\
+        root = child;\
+    }\
+}\
+\
+static inline void name##_heap_sort(type *data, size_t len)\
+{\
+    for (size_t i = len / 2; i > 0; i--) {\
+        name##_sift_down(data, i - 1, len);\
+    }\
+\
+    for (size_t i = len - 1; i > 0; i--) {\
+        name##_swap(&data[0], &data[i]);\
+        name##_sift_down(data, 0, i);\
+    }\
+}\
+\
+static inline void name##_sort3(type *a, type *b, type *c)\
+{\
+    if (less(*b, *a)) {\
+        name##_swap(a, b);\
+    }\
+\
+    if (less(*c, *b)) {\
+        name##_swap(b, c);\
+\
+        if (less(*b, *a)) {\
+            name##_swap(a, b);\
+        }\
+    }\
+}\
+\
+static inline void name##_introsort(type *data, size_t len, unsigned int depth_limit)\
+{\
+    while (len > _GARRAY_SORT_INSERTION_THRESHOLD) {\
+        size_t mid = len / 2;\
+        size_t i = 0;\
+        size_t j = len;\
+\
+        if (depth_limit == 0) {\
+            name##_heap_sort(data, len);\
+            return;\
+        }\
+        depth_limit--;\
+\
+        /* the maximum of every sampled triple ends up behind the pivot and\
+           stops the scan of i, the pivot itself stops the scan of j */\
+        name##_sort3(&data[0], &data[mid], &data[len - 1]);\
+        if (len > _GARRAY_SORT_NINTHER_THRESHOLD) {\
+            name##_sort3(&data[1], &data[mid - 1], &data[len - 2]);\
+            name##_sort3(&data[2], &data[mid + 1], &data[len - 3]);\
+            name##_sort3(&data[mid - 1], &data[mid], &data[mid + 1]);\
+        }\
+        name##_swap(&data[0], &data[mid]);\
+\
+        for (;;) {\
+            do {\
+                i++;\
+            } while (less(data[i], data[0]));\
+\
+            do {\
+                j--;\
+            } while (less(data[0], data[j]));\
+\
+            if (i >= j) {\
+                break;\
+            }\
+\
+            name##_swap(&data[i], &data[j]);\
+        }\
+        name##_swap(&data[0], &data[j]);\
+\
+        /* recurse into the smaller partition to bound the stack depth */\
+        if (j < len - j - 1) {\
+            name##_introsort(data, j, depth_limit);\
+            data += j + 1;\
+            len -= j + 1;\
+        } else {\
+            name##_introsort(&data[j + 1], len - j - 1, depth_limit);\
+            len = j;\
+        }\
+    }\
+\
+    name##_insertion_sort(data, len);\
+}\
+\
+static inline void name##_data(type *data, size_t len)\
+{\
+    unsigned int depth_limit = 0;\
+\
+    for (size_t n = len; n > 1; n >>= 1) {\
+        depth_limit += 2;\
+    }\
+\
+    name##_introsort(data, len, depth_limit);\
+}\
+\
+static inline void name(GArray *array)\
+{\
+    name##_data((type*) array->data, array->len);\
+}
+
 #ifdef _CLIB_IMPL
 struct _garray_qsort_r_data
 {
@@ -98,31 +547,221 @@ void _g_array_zero_terminate(GArray *array)
     memset(&array->data[array->len * array->_element_size], 0, array->_element_size);
 }
 
+size_t _g_array_nearest_pow(size_t num)
+{
+    size_t n = num - 1;
+
+    n |= n >> 1;
+    n |= n >> 2;
+    n |= n >> 4;
+    n |= n >> 8;
+    n |= n >> 16;
+#if SIZE_MAX > 0xffffffff
+    n |= n >> 32;
+#endif
+
+    return n + 1;
+}
+
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+// Unmaps and closes the file of a file-backed array, the unused capacity at
+// the end of a writable file is cut off again
+void _g_array_file_close(GArray *array)
+{
+    if (array->data != NULL) {
+        munmap(array->data, (size_t) array->_allocated_elements * array->_element_size);
+    }
+
+    if (array->_file_writable) {
+        if (ftruncate(array->_fd, (off_t) array->len * array->_element_size) != 0) {
+            fprintf(stderr, "Critical: g_array_free: Failed to truncate file to %zu bytes\n",
+                (size_t) array->len * array->_element_size);
+        }
+    }
+
+    close(array->_fd);
+    array->_fd = -1;
+}
+
+void _g_array_file_set_capacity(GArray *array, unsigned int capacity)
+{
+    size_t old_size = (size_t) array->_allocated_elements * array->_element_size;
+    size_t new_size = (size_t) capacity * array->_element_size;
+    size_t used = (size_t) array->len * array->_element_size;
+    char *data;
+
+    _g_mem_stats_realloc(G_MEM_STATS_ARRAY, old_size, new_size);
+
+    if (!array->_file_writable) {
+        // changes of a read-only file stay in memory, so from now on it is a
+        // normal array
+        data = _g_mem_buffer_alloc(new_size, false, &array->_mapped);
+        if (data != NULL) {
+            memcpy(data, array->data, used < new_size ? used : new_size);
+        }
+
+        _g_array_file_close(array);
+        array->data = data;
+        array->_allocated_elements = capacity;
+
+        return;
+    }
+
+    // the pages stay in the page cache, so remapping doesn't copy anything
+    if (array->data != NULL) {
+        munmap(array->data, old_size);
+        array->data = NULL;
+    }
+
+    // like running out of memory for other arrays there is no way to report
+    // this to the caller of an append, e.g. when the disk is full
+    if (ftruncate(array->_fd, (off_t) new_size) != 0) {
+        fprintf(stderr, "FATAL ERROR: _g_array_file_set_capacity: Failed to resize the file to %zu bytes: %s\n",
+            new_size, strerror(errno));
+        exit(1);
+    }
+
+    if (new_size > 0) {
+        array->data = mmap(NULL, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, array->_fd, 0);
+        if (array->data == MAP_FAILED) {
+            fprintf(stderr, "FATAL ERROR: _g_array_file_set_capacity: Failed to map %zu bytes of the file: %s\n",
+                new_size, strerror(errno));
+            exit(1);
+        }
+    }
+
+    array->_allocated_elements = capacity;
+}
+#endif
+
+void _g_array_set_capacity(GArray *array, unsigned int capacity)
+{
+    size_t old_size = (size_t) array->_allocated_elements * array->_element_size;
+    size_t new_size = (size_t) capacity * array->_element_size;
+
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+    if (array->_fd >= 0) {
+        _g_array_file_set_capacity(array, capacity);
+        return;
+    }
+#endif
+
+    if (array->_inline) {
+        // the inline storage can't shrink, when growing it spills to the heap
+        if (capacity > array->_allocated_elements) {
+            char *data = _g_mem_buffer_alloc(new_size, array->_clear, &array->_mapped);
+
+            _g_mem_stats_alloc(G_MEM_STATS_ARRAY, new_size);
+            memcpy(data, array->data, old_size);
+
+            array->data = data;
+            array->_inline = false;
+            array->_allocated_elements = capacity;
+        }
+
+        return;
+    }
+
+    if (array->data == NULL) {
+        _g_mem_stats_alloc(G_MEM_STATS_ARRAY, new_size);
+    } else if (capacity == 0) {
+        _g_mem_stats_free(G_MEM_STATS_ARRAY, old_size);
+    } else {
+        _g_mem_stats_realloc(G_MEM_STATS_ARRAY, old_size, new_size);
+    }
+
+    if (array->_clear) {
+        array->data = _g_mem_buffer_realloc0(array->data, old_size, (size_t) array->len * array->_element_size,
+            new_size, &array->_mapped);
+    } else {
+        array->data = _g_mem_buffer_realloc(array->data, old_size, new_size, &array->_mapped);
+    }
+
+    if (array->_dirty_elements > capacity) {
+        array->_dirty_elements = capacity;
+    }
+
+    array->_allocated_elements = capacity;
+}
+
 void _g_array_resize_if_needed(GArray *array, unsigned int new_elements)
 {
-    unsigned int new_len = array->len + new_elements;
-    unsigned int needed = new_len;
+    size_t needed = (size_t) array->len + new_elements;
+    size_t capacity;
+
+    // lengths and capacities are unsigned ints and would wrap around
+    if (new_elements > UINT_MAX - array->len - (array->_zero_terminated ? 1 : 0)) {
+        fprintf(stderr, "FATAL ERROR: _g_array_resize_if_needed: %u more elements exceed the maximum length of %u",
+            new_elements, UINT_MAX);
+        exit(1);
+    }
 
     if (array->_zero_terminated) {
         needed++;
     }
 
+    // every element below the highest length so far may have been written
+    if (needed > array->_dirty_elements) {
+        array->_dirty_elements = (unsigned int) needed;
+    }
+
     if (needed <= array->_allocated_elements) {
         return;
     }
 
-    array->data = realloc(array->data, needed * array->_element_size);
-    if (array->data == NULL) {
-        fprintf(stderr, "FATAL ERROR: _g_array_resize_if_needed: Out of memory");
-        exit(1);
+    capacity = (size_t) (array->_allocated_elements * GARRAY_GROWTH_FACTOR);
+    if (capacity < needed) {
+        capacity = needed;
     }
 
-    if (array->_clear) {
-        memset(&array->data[array->_allocated_elements * array->_element_size], 0,
-                (needed - array->_allocated_elements) * array->_element_size);
+#ifdef GARRAY_GROW_POW2
+    capacity = _g_array_nearest_pow(capacity);
+#endif
+
+    // growing by the factor may overshoot even though needed fits
+    if (capacity > UINT_MAX) {
+        capacity = UINT_MAX;
+    }
+
+    _g_array_set_capacity(array, (unsigned int) capacity);
+}
+
+GArray* _g_array_small_init(GArray *array, bool zero_terminated, bool clear, unsigned int element_size,
+    void *inline_data, unsigned int inline_elements)
+{
+    memset(array, 0, sizeof(GArray));
+
+    array->data = inline_data;
+    array->_allocated_elements = inline_elements;
+    array->_zero_terminated = zero_terminated;
+    array->_clear = clear;
+    array->_inline = true;
+    array->_embedded = true;
+    array->_fd = -1;
+    array->_element_size = element_size;
+
+    if (clear || zero_terminated) {
+        memset(array->data, 0, (size_t) inline_elements * element_size);
     }
 
-    array->_allocated_elements = needed;
+    return array;
+}
+
+// Makes array an embedded array over the elements of view, so the view can be
+// passed to the functions for arrays. It must not grow or be freed.
+GArray* _g_array_view_header(GArray *array, GArrayView view)
+{
+    memset(array, 0, sizeof(GArray));
+
+    array->data = view.data;
+    array->len = view.len;
+    array->_allocated_elements = view.len;
+    array->_inline = true;
+    array->_embedded = true;
+    array->_fd = -1;
+    array->_element_size = view.element_size;
+
+    return array;
 }
 
 GArray* g_array_new(bool zero_terminated, bool clear, unsigned int element_size)
@@ -130,28 +769,59 @@ GArray* g_array_new(bool zero_terminated, bool clear, unsigned int element_size)
     return g_array_sized_new(zero_terminated, clear, element_size, 0);
 }
 
+// Returns the data in memory the caller can release with g_free()
+char* _g_array_steal_data(GArray *array)
+{
+    size_t used = (size_t) (array->len + array->_zero_terminated) * array->_element_size;
+    char *data;
+
+    // file mappings and inline storage can't be handed over
+    if (array->_fd >= 0 || array->_inline) {
+        data = g_malloc(used);
+        if (used > 0) {
+            memcpy(data, array->data, used);
+        }
+
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+        if (array->_fd >= 0) {
+            _g_array_file_close(array);
+        }
+#endif
+        array->_inline = false;
+
+        return data;
+    }
+
+    return _g_mem_buffer_steal(array->data, (size_t) array->_allocated_elements * array->_element_size,
+        used, array->_mapped);
+}
+
 void* g_array_steal(GArray *array, size_t *len)
 {
     void *data;
 
     *len = array->len;
 
-    data = array->data;
+    // the caller owns the data from now on
+    if (array->data != NULL && !array->_inline) {
+        _g_mem_stats_free(G_MEM_STATS_ARRAY, (size_t) array->_allocated_elements * array->_element_size);
+    }
+
+    data = _g_array_steal_data(array);
     array->data = NULL;
     array->len = 0;
     array->_allocated_elements = 0;
+    array->_mapped = false;
+    array->_dirty_elements = 0;
 
     if (array->_zero_terminated) {
         if (array->_clear) {
-            array->data = calloc(array->_element_size, 1);
+            array->data = g_malloc0(array->_element_size);
         } else {
-            array->data = malloc(array->_element_size);
+            array->data = g_malloc(array->_element_size);
         }
 
-        if (array->data == NULL) {
-            fprintf(stderr, "FATAL ERROR: g_array_steal: Out of memory");
-            exit(1);
-        }
+        _g_mem_stats_alloc(G_MEM_STATS_ARRAY, array->_element_size);
 
         array->_allocated_elements = 1;
 
@@ -165,19 +835,24 @@ GArray* g_array_sized_new(bool zero_terminated, bool clear, unsigned int element
 {
     GArray *array;
 
-    array = malloc(sizeof(GArray));
-    if (array == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_array_sized_new: Out of memory");
-        exit(1);
-    }
+    array = g_malloc(sizeof(GArray));
+
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, sizeof(GArray));
 
     array->data = NULL;
     array->len = 0;
     array->_allocated_elements = reserved_size;
     array->_zero_terminated = zero_terminated;
     array->_clear = clear;
+    array->_mapped = false;
+    array->_inline = false;
+    array->_embedded = false;
+    array->_file_writable = false;
+    array->_dirty_elements = 0;
+    array->_fd = -1;
     array->_element_size = element_size;
     array->_clear_func = NULL;
+    array->_clear_range_func = NULL;
 
     if (zero_terminated) {
         array->_allocated_elements++;
@@ -187,16 +862,9 @@ GArray* g_array_sized_new(bool zero_terminated, bool clear, unsigned int element
         return array;
     }
 
-    if (clear) {
-        array->data = calloc(array->_allocated_elements * array->_element_size, 1);
-    } else {
-        array->data = malloc(array->_allocated_elements * array->_element_size);
-    }
+    array->data = _g_mem_buffer_alloc((size_t) array->_allocated_elements * array->_element_size, clear, &array->_mapped);
 
-    if (array->data == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_array_sized_new: Out of memory");
-        exit(1);
-    }
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, (size_t) array->_allocated_elements * array->_element_size);
 
     if (!clear && zero_terminated) {
         _g_array_zero_terminate(array);
@@ -213,25 +881,90 @@ GArray* g_array_copy(GArray *array)
         return NULL;
     }
 
-    copy = malloc(sizeof(GArray));
-    if (copy == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_array_copy: Out of memory");
-        exit(1);
-    }
-
+    copy = g_malloc(sizeof(GArray));
     memcpy(copy, array, sizeof(GArray));
+    copy->_inline = false;
+    copy->_embedded = false;
+    copy->_file_writable = false;
+    copy->_fd = -1;
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, sizeof(GArray));
 
-    copy->data = malloc(copy->_allocated_elements * copy->_element_size);
-    if (copy->data == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_array_copy: Out of memory");
-        exit(1);
+    if (array->data == NULL) {
+        return copy;
     }
 
-    memcpy(copy->data, array->data, copy->_allocated_elements);
+    copy->data = _g_mem_buffer_alloc((size_t) copy->_allocated_elements * copy->_element_size, false, &copy->_mapped);
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, (size_t) copy->_allocated_elements * copy->_element_size);
+
+    memcpy(copy->data, array->data, (size_t) copy->_allocated_elements * copy->_element_size);
 
     return copy;
 }
 
+GArray* g_array_new_from_file(const char *filename, unsigned int element_size, bool writable)
+{
+#if (defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+    return NULL;
+#else
+    GArray *array;
+    struct stat st;
+    int fd;
+
+    if (element_size == 0) {
+        fprintf(stderr, "Critical: g_array_new_from_file: element size is 0\n");
+        return NULL;
+    }
+
+    fd = open(filename, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size % element_size != 0 ||
+            (uint64_t) st.st_size / element_size > UINT_MAX) {
+        close(fd);
+        return NULL;
+    }
+
+    array = g_array_new(false, false, element_size);
+    array->_fd = fd;
+    array->_file_writable = writable;
+    array->len = (unsigned int) (st.st_size / element_size);
+    array->_allocated_elements = array->len;
+
+    if (st.st_size > 0) {
+        // a read-only file is mapped copy-on-write, so the array can still be
+        // sorted or changed without touching the file
+        array->data = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE,
+            writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        if (array->data == MAP_FAILED) {
+            close(fd);
+            array->_fd = -1;
+            array->data = NULL;
+            array->len = 0;
+            array->_allocated_elements = 0;
+            g_array_free(array, true);
+            return NULL;
+        }
+
+        _g_mem_stats_alloc(G_MEM_STATS_ARRAY, (size_t) st.st_size);
+    }
+
+    return array;
+#endif
+}
+
+bool g_array_sync(GArray *array)
+{
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+    if (array->_fd >= 0 && array->_file_writable && array->data != NULL) {
+        return msync(array->data, (size_t) array->_allocated_elements * array->_element_size, MS_SYNC) == 0;
+    }
+#endif
+
+    return true;
+}
+
 unsigned int g_array_get_element_size(GArray *array)
 {
     return array->_element_size;
@@ -267,6 +1000,7 @@ GArray* g_array_prepend_vals(GArray *array, const void *data, unsigned int len)
 GArray* g_array_insert_vals(GArray *array, unsigned int index, const void *data, unsigned int len)
 {
     unsigned int needed = len;
+    unsigned int dirty = 0;
 
     // we need to allocate extra bytes if the index to insert at is outside of
     // the array
@@ -274,8 +1008,18 @@ GArray* g_array_insert_vals(GArray *array, unsigned int index, const void *data,
         needed += index - array->len;
     }
 
+    if (array->_clear && index > array->len) {
+        // the gap up to index is cleared like in g_array_set_size
+        dirty = array->_dirty_elements < index ? array->_dirty_elements : index;
+    }
+
     _g_array_resize_if_needed(array, needed);
 
+    if (dirty > array->len) {
+        memset(&array->data[(size_t) array->len * array->_element_size], 0,
+            (size_t) (dirty - array->len) * array->_element_size);
+    }
+
     if (index < array->len) {
         memmove(&array->data[(index + len) * array->_element_size], &array->data[index * array->_element_size], (array->len - index) * array->_element_size);
     }
@@ -289,12 +1033,29 @@ GArray* g_array_insert_vals(GArray *array, unsigned int index, const void *data,
     return array;
 }
 
-GArray* g_array_remove_index(GArray *array, unsigned int index)
+// Calls the clear function on count elements starting at index, all at once
+// if it's a range function
+void _g_array_clear_elements(GArray *array, unsigned int index, unsigned int count)
 {
-    if (array->_clear_func) {
-        array->_clear_func(&array->data[index]);
+    size_t es = array->_element_size;
+
+    if (count == 0) {
+        return;
     }
 
+    if (array->_clear_range_func) {
+        array->_clear_range_func(&array->data[index * es], count);
+    } else if (array->_clear_func) {
+        for (size_t i = index; i < (size_t) index + count; i++) {
+            array->_clear_func(&array->data[i * es]);
+        }
+    }
+}
+
+GArray* g_array_remove_index(GArray *array, unsigned int index)
+{
+    _g_array_clear_elements(array, index, 1);
+
     // do we need to move other elements back?
     if (array->len > 1 && index < (array->len - 1)) {
         memmove(&array->data[index * array->_element_size], &array->data[(index + 1) * array->_element_size], (array->len - index - 1) * array->_element_size);
@@ -311,9 +1072,7 @@ GArray* g_array_remove_index(GArray *array, unsigned int index)
 
 GArray* g_array_remove_index_fast(GArray *array, unsigned int index)
 {
-    if (array->_clear_func) {
-        array->_clear_func(&array->data[index]);
-    }
+    _g_array_clear_elements(array, index, 1);
 
     if (array->len > 1 && index < (array->len - 1)) {
         memcpy(&array->data[index * array->_element_size], &array->data[(array->len - 1) * array->_element_size], array->_element_size);
@@ -330,12 +1089,12 @@ GArray* g_array_remove_index_fast(GArray *array, unsigned int index)
 
 GArray* g_array_remove_range(GArray *array, unsigned int index, unsigned int length)
 {
-    if (array->_clear_func) {
-        for (int i = index; i < (index + length - 1); i++) {
-            array->_clear_func(&array->data[i]);
-        }
+    if (index + length == array->len) {
+        return g_array_truncate(array, index);
     }
 
+    _g_array_clear_elements(array, index, length);
+
     // do we need to move other elements back?
     if (array->len > 1 && index < (array->len - length)) {
         memmove(&array->data[index * array->_element_size], &array->data[(index + length) * array->_element_size], (array->len - index - length) * array->_element_size);
@@ -350,95 +1109,2516 @@ GArray* g_array_remove_range(GArray *array, unsigned int index, unsigned int len
     return array;
 }
 
+GArray* g_array_truncate(GArray *array, unsigned int length)
+{
+    if (length >= array->len) {
+        return array;
+    }
+
+    _g_array_clear_elements(array, length, array->len - length);
+    array->len = length;
+
+    if (array->_zero_terminated) {
+        _g_array_zero_terminate(array);
+    }
+
+    return array;
+}
+
 void g_array_sort(GArray *array, GCompareFunc compare_func)
 {
+    if (array->len < 2) {
+        return;
+    }
+
     qsort(array->data, array->len, array->_element_size, compare_func);
 }
 
-void g_array_sort_with_data(GArray *array, GCompareDataFunc compare_func, void *user_data)
+void _g_array_sort_with_data(char *data, size_t len, unsigned int element_size, GCompareDataFunc compare_func, void *user_data)
 {
 #if (defined __linux__)
-    qsort_r(array->data, array->len, array->_element_size, compare_func, user_data);
+    qsort_r(data, len, element_size, compare_func, user_data);
 #elif (defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
     struct _garray_qsort_r_data tmp;
     tmp.user_data = user_data;
     tmp.compare_func = compare_func;
-    qsort_s(array->data, array->len, array->_element_size, &_garray_qsort_r_arg_swap, &tmp);
+    qsort_s(data, len, element_size, &_garray_qsort_r_arg_swap, &tmp);
 #else
     // BSD / macOS
     struct _garray_qsort_r_data tmp;
     tmp.user_data = user_data;
     tmp.compare_func = compare_func;
-    qsort_r(array->data, array->len, array->_element_size, &tmp, &_garray_qsort_r_arg_swap);
+    qsort_r(data, len, element_size, &tmp, &_garray_qsort_r_arg_swap);
 #endif
 }
 
-bool g_array_binary_search(GArray *array, const void *target, GCompareFunc compare_func, unsigned int *out_match_index)
+void g_array_sort_with_data(GArray *array, GCompareDataFunc compare_func, void *user_data)
 {
-    if (array == NULL) {
-        return false;
+    if (array->len < 2) {
+        return;
     }
 
-    if (target == NULL) {
-        return false;
+    _g_array_sort_with_data(array->data, array->len, array->_element_size, compare_func, user_data);
+}
+
+// Maps the key to an unsigned integer with the same sort order
+uint64_t _g_array_radix_key(const char *element, unsigned int key_width, GArrayRadixFlags flags)
+{
+    uint64_t key;
+    uint64_t sign_bit = (uint64_t) 1 << (key_width * 8 - 1);
+
+    switch (key_width) {
+        case 1: { uint8_t k; memcpy(&k, element, 1); key = k; break; }
+        case 2: { uint16_t k; memcpy(&k, element, 2); key = k; break; }
+        case 4: { uint32_t k; memcpy(&k, element, 4); key = k; break; }
+        default: { uint64_t k; memcpy(&k, element, 8); key = k; break; }
     }
 
-    if (array->len <= 0) {
-        return false;
+    if (flags & G_ARRAY_RADIX_FLOAT) {
+        // negative floats sort in reverse order of their bits
+        key = (key & sign_bit) ? ~key : key | sign_bit;
+    } else if (flags & G_ARRAY_RADIX_SIGNED) {
+        key ^= sign_bit;
     }
 
-    int l = 0;
-    int r = array->len - 1;
-    unsigned int m = 0;
+    if (flags & G_ARRAY_RADIX_DESCENDING) {
+        key = ~key;
+    }
 
-    while (l <= r) {
-        m = (r - l) / 2 + l; // (l + r) / 2 but prevent overflow
+    return key;
+}
 
-        if (compare_func(&array->data[m * array->_element_size], target) < 0) {
-            l = m + 1;
-        } else if (compare_func(&array->data[m * array->_element_size], target) > 0) {
-            r = m - 1;
-        } else {
-            // ensure we always return the left-most element
-            while (m > 0) {
-                if (compare_func(&array->data[m * array->_element_size], &array->data[(m - 1) * array->_element_size]) != 0) {
-                    break;
-                }
-                m--;
-            }
+#define _G_ARRAY_RADIX_SCATTER(element_size)\
+    for (size_t i = 0; i < len; i++) {\
+        const char *element = &src[i * (element_size)];\
+        unsigned int digit = (_g_array_radix_key(element + key_offset, key_width, flags) >> shift) & 0xff;\
+        memcpy(&dst[offsets[digit]++ * (element_size)], element, (element_size));\
+    }
 
-            if (out_match_index) {
-                *out_match_index = m;
+void g_array_radix_sort(GArray *array, size_t key_offset, unsigned int key_width, GArrayRadixFlags flags)
+{
+    // one histogram per byte of the key, all filled in a single pass; 16 KB
+    // so they stay in the L1 cache
+    size_t counts[8][256];
+    size_t offsets[256];
+    size_t len = array->len;
+    unsigned int element_size = array->_element_size;
+    char *src = array->data;
+    char *dst;
+    char *buffer;
+
+    if (key_width != 1 && key_width != 2 && key_width != 4 && key_width != 8) {
+        fprintf(stderr, "Critical: g_array_radix_sort: key width is %u instead of 1, 2, 4 or 8\n", key_width);
+        return;
+    }
+
+    if (key_offset + key_width > element_size) {
+        fprintf(stderr, "Critical: g_array_radix_sort: key at offset %zu with width %u is outside of the element size %u\n",
+            key_offset, key_width, element_size);
+        return;
+    }
+
+    if ((flags & G_ARRAY_RADIX_FLOAT) && key_width != 4 && key_width != 8) {
+        fprintf(stderr, "Critical: g_array_radix_sort: float keys have width 4 or 8, not %u\n", key_width);
+        return;
+    }
+
+    if (len < 2) {
+        return;
+    }
+
+    memset(counts, 0, sizeof(counts[0]) * key_width);
+
+    for (size_t i = 0; i < len; i++) {
+        uint64_t key = _g_array_radix_key(&src[i * element_size + key_offset], key_width, flags);
+
+        for (unsigned int pass = 0; pass < key_width; pass++) {
+            counts[pass][(key >> (pass * 8)) & 0xff]++;
+        }
+    }
+
+    buffer = g_malloc(len * element_size);
+    dst = buffer;
+
+    for (unsigned int pass = 0; pass < key_width; pass++) {
+        unsigned int shift = pass * 8;
+        size_t sum = 0;
+
+        // all keys share this byte, the pass wouldn't change the order
+        unsigned int first_digit = (_g_array_radix_key(&src[key_offset], key_width, flags) >> shift) & 0xff;
+        if (counts[pass][first_digit] == len) {
+            continue;
+        }
+
+        for (unsigned int digit = 0; digit < 256; digit++) {
+            offsets[digit] = sum;
+            sum += counts[pass][digit];
+        }
+
+        // constant sizes let the compiler inline the copies
+        switch (element_size) {
+            case 4: _G_ARRAY_RADIX_SCATTER(4); break;
+            case 8: _G_ARRAY_RADIX_SCATTER(8); break;
+            case 16: _G_ARRAY_RADIX_SCATTER(16); break;
+            default: _G_ARRAY_RADIX_SCATTER(element_size); break;
+        }
+
+        char *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != array->data) {
+        memcpy(array->data, src, len * element_size);
+    }
+
+    g_free(buffer);
+}
+
+/*
+ * Threads
+ *
+ * _g_array_run_tasks() calls func for every task, each one in its own thread.
+ * The calling thread runs the first task itself. Without thread support, or if
+ * a thread can't be created, the tasks run in the calling thread.
+ *
+ * The mutexes, condition variables and the atomic counter are used by the
+ * thread pool of the parallel foreach and reduce.
+ */
+typedef void (*_GArrayTaskFunc)(void *task);
+
+struct _g_array_thread_start {
+    _GArrayTaskFunc func;
+    void *task;
+};
+
+#if !defined(GARRAY_NO_THREADS) && (defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+typedef HANDLE _GArrayThread;
+
+DWORD WINAPI _g_array_thread_main(LPVOID arg)
+{
+    struct _g_array_thread_start *start = (struct _g_array_thread_start*) arg;
+    start->func(start->task);
+    return 0;
+}
+
+bool _g_array_thread_create(_GArrayThread *thread, struct _g_array_thread_start *start)
+{
+    *thread = CreateThread(NULL, 0, _g_array_thread_main, start, 0, NULL);
+    return *thread != NULL;
+}
+
+void _g_array_thread_join(_GArrayThread thread)
+{
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+unsigned int _g_array_num_cpus(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+typedef CRITICAL_SECTION _GArrayMutex;
+typedef CONDITION_VARIABLE _GArrayCond;
+
+void _g_array_mutex_init(_GArrayMutex *mutex)
+{
+    InitializeCriticalSection(mutex);
+}
+
+void _g_array_mutex_destroy(_GArrayMutex *mutex)
+{
+    DeleteCriticalSection(mutex);
+}
+
+void _g_array_mutex_lock(_GArrayMutex *mutex)
+{
+    EnterCriticalSection(mutex);
+}
+
+void _g_array_mutex_unlock(_GArrayMutex *mutex)
+{
+    LeaveCriticalSection(mutex);
+}
+
+void _g_array_cond_init(_GArrayCond *cond)
+{
+    InitializeConditionVariable(cond);
+}
+
+void _g_array_cond_destroy(_GArrayCond *cond)
+{
+    (void) cond;
+}
+
+void _g_array_cond_wait(_GArrayCond *cond, _GArrayMutex *mutex)
+{
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+void _g_array_cond_signal(_GArrayCond *cond)
+{
+    WakeConditionVariable(cond);
+}
+
+void _g_array_cond_broadcast(_GArrayCond *cond)
+{
+    WakeAllConditionVariable(cond);
+}
+
+// Returns the value before the increment
+long _g_array_atomic_fetch_inc(volatile long *value)
+{
+    return InterlockedIncrement(value) - 1;
+}
+#elif !defined(GARRAY_NO_THREADS)
+typedef pthread_t _GArrayThread;
+
+void* _g_array_thread_main(void *arg)
+{
+    struct _g_array_thread_start *start = (struct _g_array_thread_start*) arg;
+    start->func(start->task);
+    return NULL;
+}
+
+bool _g_array_thread_create(_GArrayThread *thread, struct _g_array_thread_start *start)
+{
+    return pthread_create(thread, NULL, _g_array_thread_main, start) == 0;
+}
+
+void _g_array_thread_join(_GArrayThread thread)
+{
+    pthread_join(thread, NULL);
+}
+
+unsigned int _g_array_num_cpus(void)
+{
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return num_cpus > 0 ? (unsigned int) num_cpus : 1;
+}
+
+typedef pthread_mutex_t _GArrayMutex;
+typedef pthread_cond_t _GArrayCond;
+
+void _g_array_mutex_init(_GArrayMutex *mutex)
+{
+    pthread_mutex_init(mutex, NULL);
+}
+
+void _g_array_mutex_destroy(_GArrayMutex *mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+void _g_array_mutex_lock(_GArrayMutex *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+void _g_array_mutex_unlock(_GArrayMutex *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+void _g_array_cond_init(_GArrayCond *cond)
+{
+    pthread_cond_init(cond, NULL);
+}
+
+void _g_array_cond_destroy(_GArrayCond *cond)
+{
+    pthread_cond_destroy(cond);
+}
+
+void _g_array_cond_wait(_GArrayCond *cond, _GArrayMutex *mutex)
+{
+    pthread_cond_wait(cond, mutex);
+}
+
+void _g_array_cond_signal(_GArrayCond *cond)
+{
+    pthread_cond_signal(cond);
+}
+
+void _g_array_cond_broadcast(_GArrayCond *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+
+// Returns the value before the increment
+long _g_array_atomic_fetch_inc(volatile long *value)
+{
+    return __atomic_fetch_add(value, 1, __ATOMIC_RELAXED);
+}
+#else
+unsigned int _g_array_num_cpus(void)
+{
+    return 1;
+}
+
+long _g_array_atomic_fetch_inc(volatile long *value)
+{
+    return (*value)++;
+}
+#endif
+
+void _g_array_run_tasks(_GArrayTaskFunc func, void *tasks, size_t task_size, unsigned int num_tasks)
+{
+#ifndef GARRAY_NO_THREADS
+    _GArrayThread *threads;
+    struct _g_array_thread_start *starts;
+    bool *started;
+
+    if (num_tasks > 1) {
+        threads = g_malloc(sizeof(_GArrayThread) * num_tasks);
+        starts = g_malloc(sizeof(struct _g_array_thread_start) * num_tasks);
+        started = g_malloc(sizeof(bool) * num_tasks);
+
+        for (unsigned int i = 1; i < num_tasks; i++) {
+            starts[i].func = func;
+            starts[i].task = (char*) tasks + i * task_size;
+            started[i] = _g_array_thread_create(&threads[i], &starts[i]);
+        }
+
+        func(tasks);
+
+        for (unsigned int i = 1; i < num_tasks; i++) {
+            if (started[i]) {
+                _g_array_thread_join(threads[i]);
+            } else {
+                func((char*) tasks + i * task_size);
+            }
+        }
+
+        g_free(threads);
+        g_free(starts);
+        g_free(started);
+        return;
+    }
+#endif
+
+    for (unsigned int i = 0; i < num_tasks; i++) {
+        func((char*) tasks + i * task_size);
+    }
+}
+
+/*
+ * Parallel sort
+ *
+ * Every thread sorts one chunk of the array with qsort. The sorted chunks are
+ * then merged pair-wise until one run is left. To keep all threads busy while
+ * there are fewer pairs than threads, each merge is split into slices of the
+ * output that are merged independently. The start of a slice in both inputs
+ * is found by a binary search along the merge path.
+ */
+struct _g_array_compare {
+    GCompareFunc func;
+    GCompareDataFunc data_func;
+    void *user_data;
+};
+
+int _g_array_compare(const struct _g_array_compare *compare, const void *a, const void *b)
+{
+    if (compare->data_func) {
+        return compare->data_func(a, b, compare->user_data);
+    }
+
+    return compare->func(a, b);
+}
+
+struct _g_array_sort_task {
+    char *data;
+    size_t len;
+    unsigned int element_size;
+    const struct _g_array_compare *compare;
+};
+
+struct _g_array_merge_task {
+    const char *a;
+    size_t len_a;
+    const char *b;
+    size_t len_b;
+    char *dst; // output of the whole merge
+    size_t begin; // slice of the output this task produces
+    size_t end;
+    unsigned int element_size;
+    const struct _g_array_compare *compare;
+};
+
+void _g_array_sort_task(void *arg)
+{
+    struct _g_array_sort_task *task = (struct _g_array_sort_task*) arg;
+
+    if (task->compare->data_func) {
+        _g_array_sort_with_data(task->data, task->len, task->element_size, task->compare->data_func, task->compare->user_data);
+    } else {
+        qsort(task->data, task->len, task->element_size, task->compare->func);
+    }
+}
+
+// Number of elements from a among the first k elements of the merged output
+size_t _g_array_merge_path(struct _g_array_merge_task *task, size_t k)
+{
+    unsigned int es = task->element_size;
+    size_t lo = k > task->len_b ? k - task->len_b : 0;
+    size_t hi = k < task->len_a ? k : task->len_a;
+
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+
+        if (_g_array_compare(task->compare, &task->a[i * es], &task->b[(k - i - 1) * es]) <= 0) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+
+    return lo;
+}
+
+void _g_array_merge_task(void *arg)
+{
+    struct _g_array_merge_task *task = (struct _g_array_merge_task*) arg;
+    unsigned int es = task->element_size;
+    size_t i = _g_array_merge_path(task, task->begin);
+    size_t j = task->begin - i;
+    size_t end_i = _g_array_merge_path(task, task->end);
+    size_t end_j = task->end - end_i;
+    char *dst = &task->dst[task->begin * es];
+
+    while (i < end_i && j < end_j) {
+        if (_g_array_compare(task->compare, &task->a[i * es], &task->b[j * es]) <= 0) {
+            memcpy(dst, &task->a[i * es], es);
+            i++;
+        } else {
+            memcpy(dst, &task->b[j * es], es);
+            j++;
+        }
+        dst += es;
+    }
+
+    memcpy(dst, &task->a[i * es], (end_i - i) * es);
+    dst += (end_i - i) * es;
+    memcpy(dst, &task->b[j * es], (end_j - j) * es);
+}
+
+void _g_array_sort_parallel(GArray *array, const struct _g_array_compare *compare, unsigned int num_threads)
+{
+    size_t len = array->len;
+    unsigned int es = array->_element_size;
+    size_t *runs;
+    unsigned int num_runs;
+    struct _g_array_sort_task *sort_tasks;
+    struct _g_array_merge_task *merge_tasks;
+    char *src = array->data;
+    char *dst;
+    char *buffer;
+
+    runs = g_malloc(sizeof(size_t) * (num_threads + 1));
+    sort_tasks = g_malloc(sizeof(struct _g_array_sort_task) * num_threads);
+    // each pair gets at least one task, an odd run out is copied by one more
+    merge_tasks = g_malloc(sizeof(struct _g_array_merge_task) * (num_threads + 1));
+
+    for (unsigned int i = 0; i <= num_threads; i++) {
+        runs[i] = len * i / num_threads;
+    }
+
+    for (unsigned int i = 0; i < num_threads; i++) {
+        sort_tasks[i].data = &src[runs[i] * es];
+        sort_tasks[i].len = runs[i + 1] - runs[i];
+        sort_tasks[i].element_size = es;
+        sort_tasks[i].compare = compare;
+    }
+
+    _g_array_run_tasks(_g_array_sort_task, sort_tasks, sizeof(struct _g_array_sort_task), num_threads);
+
+    buffer = g_malloc(len * es);
+    dst = buffer;
+
+    for (num_runs = num_threads; num_runs > 1; num_runs = (num_runs + 1) / 2) {
+        unsigned int num_pairs = num_runs / 2;
+        unsigned int slices = num_threads / num_pairs;
+        unsigned int num_tasks = 0;
+
+        for (unsigned int pair = 0; pair < (num_runs + 1) / 2; pair++) {
+            size_t start = runs[2 * pair];
+            size_t mid = runs[2 * pair + 1];
+            size_t end = 2 * pair + 2 <= num_runs ? runs[2 * pair + 2] : mid;
+            unsigned int num_slices = 2 * pair + 2 <= num_runs ? slices : 1;
+
+            for (unsigned int slice = 0; slice < num_slices; slice++) {
+                struct _g_array_merge_task *task = &merge_tasks[num_tasks++];
+
+                task->a = &src[start * es];
+                task->len_a = mid - start;
+                task->b = &src[mid * es];
+                task->len_b = end - mid;
+                task->dst = &dst[start * es];
+                task->begin = (end - start) * slice / num_slices;
+                task->end = (end - start) * (slice + 1) / num_slices;
+                task->element_size = es;
+                task->compare = compare;
+            }
+
+            runs[pair] = start;
+        }
+        runs[(num_runs + 1) / 2] = len;
+
+        _g_array_run_tasks(_g_array_merge_task, merge_tasks, sizeof(struct _g_array_merge_task), num_tasks);
+
+        char *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != array->data) {
+        memcpy(array->data, src, len * es);
+    }
+
+    g_free(buffer);
+    g_free(runs);
+    g_free(sort_tasks);
+    g_free(merge_tasks);
+}
+
+// Every thread gets at least GARRAY_PARALLEL_SORT_THRESHOLD elements. More
+// threads than CPUs are allowed, e.g. to test the merging on small machines
+unsigned int _g_array_sort_parallel_threads(GArray *array, unsigned int num_threads)
+{
+    unsigned int max_threads = array->len / GARRAY_PARALLEL_SORT_THRESHOLD;
+
+    if (num_threads == 0) {
+        num_threads = _g_array_num_cpus();
+    } else if (num_threads > GARRAY_MAX_THREADS) {
+        num_threads = GARRAY_MAX_THREADS;
+    }
+
+    if (num_threads > max_threads) {
+        num_threads = max_threads;
+    }
+
+    return num_threads;
+}
+
+void g_array_sort_parallel(GArray *array, GCompareFunc compare_func, unsigned int num_threads)
+{
+    struct _g_array_compare compare = {compare_func, NULL, NULL};
+
+    num_threads = _g_array_sort_parallel_threads(array, num_threads);
+
+    if (num_threads <= 1) {
+        g_array_sort(array, compare_func);
+        return;
+    }
+
+    _g_array_sort_parallel(array, &compare, num_threads);
+}
+
+void g_array_sort_parallel_with_data(GArray *array, GCompareDataFunc compare_func, void *user_data, unsigned int num_threads)
+{
+    struct _g_array_compare compare = {NULL, compare_func, user_data};
+
+    num_threads = _g_array_sort_parallel_threads(array, num_threads);
+
+    if (num_threads <= 1) {
+        g_array_sort_with_data(array, compare_func, user_data);
+        return;
+    }
+
+    _g_array_sort_parallel(array, &compare, num_threads);
+}
+
+/*
+ * Parallel foreach and reduce
+ *
+ * A job splits the array into chunks. All chunks but the first start at a
+ * cache line (if the element size allows it) so that threads writing to
+ * neighbouring chunks don't share lines. Each thread of the pool starts with
+ * its own range of chunks and takes them one by one with an atomic counter.
+ * Once its range is used up it steals the remaining chunks of the other
+ * ranges, so chunks that take longer than others don't leave threads idle.
+ *
+ * The workers of a pool wait on a condition variable between jobs. The
+ * calling thread works on the job as well and returns once all workers are
+ * done with it.
+ */
+#define _G_ARRAY_CACHE_LINE 64
+
+// Range of chunks one thread starts with; padded so that the counters of
+// different threads don't share a cache line
+struct _g_array_chunk_queue {
+    volatile long next;
+    long end;
+    char _padding[_G_ARRAY_CACHE_LINE - sizeof(long) * 2];
+};
+
+struct _g_array_job {
+    char *data;
+    size_t len;
+    size_t element_size;
+    size_t head; // elements before the first cache line, added to chunk 0
+    size_t chunk_len;
+    long num_chunks;
+    struct _g_array_chunk_queue *queues;
+    unsigned int num_queues;
+    GArrayForeachFunc foreach_func;
+    GArrayReduceFunc reduce_func;
+    const char *initial; // value every chunk of a reduce starts with
+    char *results; // result of every chunk of a reduce, each on its own cache lines
+    size_t result_size;
+    size_t result_stride;
+    void *user_data;
+};
+
+#ifndef GARRAY_NO_THREADS
+struct _g_array_pool_worker {
+    GArrayThreadPool *pool;
+    unsigned int index;
+    _GArrayThread thread;
+    struct _g_array_thread_start start;
+};
+#endif
+
+struct GArrayThreadPool {
+    unsigned int num_threads; // including the thread that runs a job
+#ifndef GARRAY_NO_THREADS
+    struct _g_array_pool_worker *_workers; // 1 to num_threads - 1 are started
+    unsigned int _num_workers;
+    _GArrayMutex _run_lock; // held while a job runs
+    _GArrayMutex _lock;
+    _GArrayCond _work_ready;
+    _GArrayCond _work_done;
+    struct _g_array_job *_job;
+    unsigned long _generation; // incremented for every job
+    unsigned int _active; // workers that haven't finished the job yet
+    bool _shutdown;
+#endif
+};
+
+void _g_array_job_run_chunk(struct _g_array_job *job, long chunk)
+{
+    size_t es = job->element_size;
+    size_t begin = chunk == 0 ? 0 : job->head + (size_t) chunk * job->chunk_len;
+    size_t end = job->head + ((size_t) chunk + 1) * job->chunk_len;
+    char *element;
+    char *end_element;
+
+    if (end > job->len) {
+        end = job->len;
+    }
+
+    element = job->data + begin * es;
+    end_element = job->data + end * es;
+
+    if (job->foreach_func != NULL) {
+        for (; element < end_element; element += es) {
+            job->foreach_func(element, job->user_data);
+        }
+    } else {
+        char *accumulator = job->results + (size_t) chunk * job->result_stride;
+
+        memcpy(accumulator, job->initial, job->result_size);
+
+        for (; element < end_element; element += es) {
+            job->reduce_func(accumulator, element, job->user_data);
+        }
+    }
+}
+
+// Works on the own range of chunks first and then steals from the others
+void _g_array_job_run(struct _g_array_job *job, unsigned int index)
+{
+    for (unsigned int i = 0; i < job->num_queues; i++) {
+        struct _g_array_chunk_queue *queue = &job->queues[(index + i) % job->num_queues];
+        long chunk;
+
+        while ((chunk = _g_array_atomic_fetch_inc(&queue->next)) < queue->end) {
+            _g_array_job_run_chunk(job, chunk);
+        }
+    }
+}
+
+#ifndef GARRAY_NO_THREADS
+void _g_array_pool_worker_main(void *arg)
+{
+    struct _g_array_pool_worker *worker = (struct _g_array_pool_worker*) arg;
+    GArrayThreadPool *pool = worker->pool;
+    unsigned long generation = 0;
+    struct _g_array_job *job;
+
+    _g_array_mutex_lock(&pool->_lock);
+
+    for (;;) {
+        while (!pool->_shutdown && pool->_generation == generation) {
+            _g_array_cond_wait(&pool->_work_ready, &pool->_lock);
+        }
+
+        if (pool->_shutdown) {
+            break;
+        }
+
+        generation = pool->_generation;
+        job = pool->_job;
+        _g_array_mutex_unlock(&pool->_lock);
+
+        _g_array_job_run(job, worker->index);
+
+        _g_array_mutex_lock(&pool->_lock);
+        pool->_active--;
+        if (pool->_active == 0) {
+            _g_array_cond_signal(&pool->_work_done);
+        }
+    }
+
+    _g_array_mutex_unlock(&pool->_lock);
+}
+#endif
+
+GArrayThreadPool* g_array_thread_pool_new(unsigned int num_threads)
+{
+    GArrayThreadPool *pool = g_malloc(sizeof(GArrayThreadPool));
+
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, sizeof(GArrayThreadPool));
+
+    if (num_threads == 0) {
+        num_threads = _g_array_num_cpus();
+    } else if (num_threads > GARRAY_MAX_THREADS) {
+        num_threads = GARRAY_MAX_THREADS;
+    }
+
+    pool->num_threads = 1;
+
+#ifndef GARRAY_NO_THREADS
+    pool->_num_workers = num_threads;
+    pool->_workers = g_malloc(sizeof(struct _g_array_pool_worker) * num_threads);
+    pool->_job = NULL;
+    pool->_generation = 0;
+    pool->_active = 0;
+    pool->_shutdown = false;
+
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, sizeof(struct _g_array_pool_worker) * num_threads);
+
+    _g_array_mutex_init(&pool->_run_lock);
+    _g_array_mutex_init(&pool->_lock);
+    _g_array_cond_init(&pool->_work_ready);
+    _g_array_cond_init(&pool->_work_done);
+
+    // if a thread can't be created the pool makes do with the ones it has
+    while (pool->num_threads < num_threads) {
+        struct _g_array_pool_worker *worker = &pool->_workers[pool->num_threads];
+
+        worker->pool = pool;
+        worker->index = pool->num_threads;
+        worker->start.func = _g_array_pool_worker_main;
+        worker->start.task = worker;
+
+        if (!_g_array_thread_create(&worker->thread, &worker->start)) {
+            break;
+        }
+
+        pool->num_threads++;
+    }
+#endif
+
+    return pool;
+}
+
+unsigned int g_array_thread_pool_get_num_threads(GArrayThreadPool *pool)
+{
+    return pool->num_threads;
+}
+
+void g_array_thread_pool_free(GArrayThreadPool *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+#ifndef GARRAY_NO_THREADS
+    _g_array_mutex_lock(&pool->_lock);
+    pool->_shutdown = true;
+    _g_array_cond_broadcast(&pool->_work_ready);
+    _g_array_mutex_unlock(&pool->_lock);
+
+    for (unsigned int i = 1; i < pool->num_threads; i++) {
+        _g_array_thread_join(pool->_workers[i].thread);
+    }
+
+    _g_array_cond_destroy(&pool->_work_done);
+    _g_array_cond_destroy(&pool->_work_ready);
+    _g_array_mutex_destroy(&pool->_lock);
+    _g_array_mutex_destroy(&pool->_run_lock);
+
+    _g_mem_stats_free(G_MEM_STATS_ARRAY, sizeof(struct _g_array_pool_worker) * pool->_num_workers);
+    g_free(pool->_workers);
+#endif
+
+    _g_mem_stats_free(G_MEM_STATS_ARRAY, sizeof(GArrayThreadPool));
+    g_free(pool);
+}
+
+// Splits the array into chunks. With a single thread, or for small arrays, the
+// whole array is one chunk.
+void _g_array_job_split(struct _g_array_job *job, GArray *array, unsigned int num_threads)
+{
+    size_t es = array->_element_size;
+    size_t len = array->len;
+    size_t line_elements;
+    size_t misalignment;
+
+    job->data = array->data;
+    job->len = len;
+    job->element_size = es;
+    job->head = 0;
+    job->chunk_len = len;
+
+    if (num_threads > 1 && len >= GARRAY_PARALLEL_FOREACH_THRESHOLD) {
+        // the fewest elements that fill whole cache lines
+        line_elements = es & (~es + 1);
+        line_elements = _G_ARRAY_CACHE_LINE / (line_elements < _G_ARRAY_CACHE_LINE ? line_elements : _G_ARRAY_CACHE_LINE);
+
+        // at least 8 chunks per thread so that stealing can even out the work
+        job->chunk_len = GARRAY_PARALLEL_CHUNK_SIZE / es;
+        if (job->chunk_len > len / ((size_t) num_threads * 8)) {
+            job->chunk_len = len / ((size_t) num_threads * 8);
+        }
+        job->chunk_len = (job->chunk_len + line_elements - 1) / line_elements * line_elements;
+        if (job->chunk_len == 0) {
+            job->chunk_len = line_elements;
+        }
+
+        misalignment = (uintptr_t) array->data % _G_ARRAY_CACHE_LINE;
+        for (size_t i = 1; misalignment != 0 && i < line_elements; i++) {
+            if ((misalignment + i * es) % _G_ARRAY_CACHE_LINE == 0) {
+                job->head = i;
+                break;
+            }
+        }
+    }
+
+    job->num_chunks = len > job->head ? (long) ((len - job->head + job->chunk_len - 1) / job->chunk_len) : 1;
+    job->num_queues = job->num_chunks < (long) num_threads ? (unsigned int) job->num_chunks : num_threads;
+}
+
+// Gives every thread its range of chunks and runs the job on the pool
+void _g_array_job_dispatch(struct _g_array_job *job, GArrayThreadPool *pool)
+{
+    char *queues_buffer = g_malloc(sizeof(struct _g_array_chunk_queue) * (job->num_queues + 1));
+
+    job->queues = (struct _g_array_chunk_queue*) (((uintptr_t) queues_buffer + _G_ARRAY_CACHE_LINE - 1)
+        & ~(uintptr_t) (_G_ARRAY_CACHE_LINE - 1));
+
+    for (unsigned int i = 0; i < job->num_queues; i++) {
+        job->queues[i].next = (long) ((size_t) job->num_chunks * i / job->num_queues);
+        job->queues[i].end = (long) ((size_t) job->num_chunks * (i + 1) / job->num_queues);
+    }
+
+#ifndef GARRAY_NO_THREADS
+    if (job->num_queues > 1) {
+        // one job at a time per pool
+        _g_array_mutex_lock(&pool->_run_lock);
+
+        _g_array_mutex_lock(&pool->_lock);
+        pool->_job = job;
+        pool->_active = pool->num_threads - 1;
+        pool->_generation++;
+        _g_array_cond_broadcast(&pool->_work_ready);
+        _g_array_mutex_unlock(&pool->_lock);
+
+        _g_array_job_run(job, 0);
+
+        _g_array_mutex_lock(&pool->_lock);
+        while (pool->_active > 0) {
+            _g_array_cond_wait(&pool->_work_done, &pool->_lock);
+        }
+        pool->_job = NULL;
+        _g_array_mutex_unlock(&pool->_lock);
+
+        _g_array_mutex_unlock(&pool->_run_lock);
+    } else {
+        _g_array_job_run(job, 0);
+    }
+#else
+    (void) pool;
+    _g_array_job_run(job, 0);
+#endif
+
+    g_free(queues_buffer);
+}
+
+void g_array_foreach(GArray *array, GArrayForeachFunc func, void *user_data)
+{
+    size_t es = array->_element_size;
+    char *end = array->data + (size_t) array->len * es;
+
+    for (char *element = array->data; element < end; element += es) {
+        func(element, user_data);
+    }
+}
+
+void g_array_parallel_foreach(GArray *array, GArrayThreadPool *pool, GArrayForeachFunc func, void *user_data)
+{
+    struct _g_array_job job;
+
+    if (array->len == 0) {
+        return;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.foreach_func = func;
+    job.user_data = user_data;
+
+    _g_array_job_split(&job, array, pool != NULL ? pool->num_threads : 1);
+    _g_array_job_dispatch(&job, pool);
+}
+
+void g_array_parallel_reduce(GArray *array, GArrayThreadPool *pool, void *result, size_t result_size,
+    GArrayReduceFunc reduce_func, GArrayCombineFunc combine_func, void *user_data)
+{
+    struct _g_array_job job;
+    char *results_buffer;
+
+    if (array->len == 0) {
+        return;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.reduce_func = reduce_func;
+    job.initial = (const char*) result;
+    job.result_size = result_size;
+    job.result_stride = (result_size + _G_ARRAY_CACHE_LINE - 1) & ~(size_t) (_G_ARRAY_CACHE_LINE - 1);
+    job.user_data = user_data;
+
+    _g_array_job_split(&job, array, pool != NULL ? pool->num_threads : 1);
+
+    results_buffer = g_malloc(job.result_stride * (size_t) job.num_chunks + _G_ARRAY_CACHE_LINE);
+    job.results = (char*) (((uintptr_t) results_buffer + _G_ARRAY_CACHE_LINE - 1)
+        & ~(uintptr_t) (_G_ARRAY_CACHE_LINE - 1));
+
+    _g_array_job_dispatch(&job, pool);
+
+    // combine the results in the order of the chunks
+    memcpy(result, job.results, result_size);
+    for (long i = 1; i < job.num_chunks; i++) {
+        combine_func(result, job.results + (size_t) i * job.result_stride, user_data);
+    }
+
+    g_free(results_buffer);
+}
+
+/*
+ * Stable sort
+ *
+ * An adaptive merge sort in the spirit of timsort: the array is split into
+ * runs that are already ascending (or strictly descending and get reversed).
+ * Runs shorter than the minimum run length are extended with a binary
+ * insertion sort. The runs are kept on a stack and merged so that their
+ * lengths stay balanced. Before merging two runs, the elements that are
+ * already in their final place are skipped, so nearly sorted arrays need
+ * little more than one pass.
+ */
+#define _G_ARRAY_MAX_RUNS 128
+
+struct _g_array_stable_sort {
+    char *data;
+    unsigned int element_size;
+    const struct _g_array_compare *compare;
+    char *buffer;
+    size_t run_base[_G_ARRAY_MAX_RUNS];
+    size_t run_len[_G_ARRAY_MAX_RUNS];
+    unsigned int num_runs;
+};
+
+size_t _g_array_min_run(size_t len)
+{
+    size_t r = 0;
+
+    while (len >= 64) {
+        r |= len & 1;
+        len >>= 1;
+    }
+
+    return len + r;
+}
+
+void _g_array_reverse(char *data, size_t len, unsigned int element_size, char *tmp)
+{
+    char *lo = data;
+    char *hi = &data[(len - 1) * element_size];
+
+    while (lo < hi) {
+        memcpy(tmp, lo, element_size);
+        memcpy(lo, hi, element_size);
+        memcpy(hi, tmp, element_size);
+        lo += element_size;
+        hi -= element_size;
+    }
+}
+
+// Sorts data[0..len) where data[0..start) is already sorted
+void _g_array_binary_insertion_sort(struct _g_array_stable_sort *sort, char *data, size_t len, size_t start)
+{
+    unsigned int es = sort->element_size;
+
+    for (size_t i = start; i < len; i++) {
+        size_t lo = 0;
+        size_t hi = i;
+
+        // insert after all equal elements to keep the sort stable
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (_g_array_compare(sort->compare, &data[i * es], &data[mid * es]) < 0) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+
+        if (lo < i) {
+            memcpy(sort->buffer, &data[i * es], es);
+            memmove(&data[(lo + 1) * es], &data[lo * es], (i - lo) * es);
+            memcpy(&data[lo * es], sort->buffer, es);
+        }
+    }
+}
+
+size_t _g_array_count_run(struct _g_array_stable_sort *sort, char *data, size_t len)
+{
+    unsigned int es = sort->element_size;
+    size_t n = 2;
+
+    if (len < 2) {
+        return len;
+    }
+
+    // only strictly descending runs can be reversed without breaking stability
+    if (_g_array_compare(sort->compare, &data[es], &data[0]) < 0) {
+        while (n < len && _g_array_compare(sort->compare, &data[n * es], &data[(n - 1) * es]) < 0) {
+            n++;
+        }
+        _g_array_reverse(data, n, es, sort->buffer);
+    } else {
+        while (n < len && _g_array_compare(sort->compare, &data[n * es], &data[(n - 1) * es]) >= 0) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+// Number of elements in data that are <= key
+size_t _g_array_count_le(struct _g_array_stable_sort *sort, const char *data, size_t len, const char *key)
+{
+    size_t lo = 0;
+    size_t hi = len;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (_g_array_compare(sort->compare, key, &data[mid * sort->element_size]) < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    return lo;
+}
+
+// Number of elements in data that are < key
+size_t _g_array_count_lt(struct _g_array_stable_sort *sort, const char *data, size_t len, const char *key)
+{
+    size_t lo = 0;
+    size_t hi = len;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (_g_array_compare(sort->compare, &data[mid * sort->element_size], key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+void _g_array_merge_runs(struct _g_array_stable_sort *sort, char *a, size_t len_a, size_t len_b)
+{
+    unsigned int es = sort->element_size;
+    char *b = &a[len_a * es];
+    char *buf = sort->buffer;
+    size_t skip;
+
+    // elements of a that are <= b[0] are already in place
+    skip = _g_array_count_le(sort, a, len_a, b);
+    a += skip * es;
+    len_a -= skip;
+    if (len_a == 0) {
+        return;
+    }
+
+    // so are the elements of b that are >= the last element of a
+    len_b = _g_array_count_lt(sort, b, len_b, &a[(len_a - 1) * es]);
+    if (len_b == 0) {
+        return;
+    }
+
+    if (len_a <= len_b) {
+        // merge from the front with a in the buffer
+        char *dst = a;
+        size_t i = 0;
+        size_t j = 0;
+
+        memcpy(buf, a, len_a * es);
+
+        while (i < len_a && j < len_b) {
+            if (_g_array_compare(sort->compare, &b[j * es], &buf[i * es]) < 0) {
+                memcpy(dst, &b[j * es], es);
+                j++;
+            } else {
+                memcpy(dst, &buf[i * es], es);
+                i++;
+            }
+            dst += es;
+        }
+
+        // the rest of b is already in place
+        memcpy(dst, &buf[i * es], (len_a - i) * es);
+    } else {
+        // merge from the back with b in the buffer
+        char *dst = &b[len_b * es];
+        size_t i = len_a;
+        size_t j = len_b;
+
+        memcpy(buf, b, len_b * es);
+
+        while (i > 0 && j > 0) {
+            dst -= es;
+
+            if (_g_array_compare(sort->compare, &buf[(j - 1) * es], &a[(i - 1) * es]) < 0) {
+                memcpy(dst, &a[(i - 1) * es], es);
+                i--;
+            } else {
+                memcpy(dst, &buf[(j - 1) * es], es);
+                j--;
+            }
+        }
+
+        // the rest of a is already in place
+        memcpy(a, buf, j * es);
+    }
+}
+
+void _g_array_merge_at(struct _g_array_stable_sort *sort, unsigned int n)
+{
+    _g_array_merge_runs(sort, &sort->data[sort->run_base[n] * sort->element_size], sort->run_len[n], sort->run_len[n + 1]);
+
+    sort->run_len[n] += sort->run_len[n + 1];
+    if (n + 2 < sort->num_runs) {
+        sort->run_base[n + 1] = sort->run_base[n + 2];
+        sort->run_len[n + 1] = sort->run_len[n + 2];
+    }
+    sort->num_runs--;
+}
+
+// Restores the invariants len[n - 2] > len[n - 1] + len[n] and
+// len[n - 1] > len[n] on the run stack
+void _g_array_merge_collapse(struct _g_array_stable_sort *sort)
+{
+    size_t *len = sort->run_len;
+
+    while (sort->num_runs > 1) {
+        unsigned int n = sort->num_runs - 2;
+
+        if ((n > 0 && len[n - 1] <= len[n] + len[n + 1]) || (n > 1 && len[n - 2] <= len[n - 1] + len[n])) {
+            if (len[n - 1] < len[n + 1]) {
+                n--;
+            }
+        } else if (len[n] > len[n + 1]) {
+            break;
+        }
+
+        _g_array_merge_at(sort, n);
+    }
+}
+
+// Merges in scratch if it isn't NULL, growing it as needed, and in a buffer
+// of its own otherwise
+void _g_array_stable_sort(GArray *array, const struct _g_array_compare *compare, GArray *scratch)
+{
+    struct _g_array_stable_sort sort;
+    size_t len = array->len;
+    unsigned int es = array->_element_size;
+    size_t min_run = _g_array_min_run(len);
+    size_t pos = 0;
+
+    if (len < 2) {
+        return;
+    }
+
+    sort.data = array->data;
+    sort.element_size = es;
+    sort.compare = compare;
+    sort.num_runs = 0;
+
+    // a merge never buffers more than half of the array
+    if (scratch != NULL) {
+        if (scratch->len < len / 2 + 1) {
+            g_array_set_size(scratch, (unsigned int) (len / 2 + 1));
+        }
+        sort.buffer = scratch->data;
+    } else {
+        sort.buffer = g_malloc((len / 2 + 1) * es);
+    }
+
+    while (pos < len) {
+        size_t remaining = len - pos;
+        size_t run_len = _g_array_count_run(&sort, &sort.data[pos * es], remaining);
+
+        if (run_len < min_run) {
+            size_t forced = remaining < min_run ? remaining : min_run;
+            _g_array_binary_insertion_sort(&sort, &sort.data[pos * es], forced, run_len);
+            run_len = forced;
+        }
+
+        sort.run_base[sort.num_runs] = pos;
+        sort.run_len[sort.num_runs] = run_len;
+        sort.num_runs++;
+        pos += run_len;
+
+        _g_array_merge_collapse(&sort);
+    }
+
+    while (sort.num_runs > 1) {
+        unsigned int n = sort.num_runs - 2;
+
+        if (n > 0 && sort.run_len[n - 1] < sort.run_len[n + 1]) {
+            n--;
+        }
+
+        _g_array_merge_at(&sort, n);
+    }
+
+    if (scratch == NULL) {
+        g_free(sort.buffer);
+    }
+}
+
+void g_array_stable_sort(GArray *array, GCompareFunc compare_func)
+{
+    struct _g_array_compare compare = {compare_func, NULL, NULL};
+    _g_array_stable_sort(array, &compare, NULL);
+}
+
+void g_array_stable_sort_with_data(GArray *array, GCompareDataFunc compare_func, void *user_data)
+{
+    struct _g_array_compare compare = {NULL, compare_func, user_data};
+    _g_array_stable_sort(array, &compare, NULL);
+}
+
+void g_array_stable_sort_with_buffer(GArray *array, GCompareFunc compare_func, GArray *scratch)
+{
+    struct _g_array_compare compare = {compare_func, NULL, NULL};
+
+    if (scratch != NULL && scratch->_element_size != array->_element_size) {
+        fprintf(stderr, "Critical: g_array_stable_sort_with_buffer: element sizes %u and %u don't match\n",
+            array->_element_size, scratch->_element_size);
+        return;
+    }
+
+    _g_array_stable_sort(array, &compare, scratch);
+}
+
+/*
+ * Bounds
+ *
+ * The searches halve the range without branching on the comparison: the
+ * result only decides how far the base moves, which compiles to a conditional
+ * move. That avoids a misprediction on every second step. The batch variants
+ * run many searches in lockstep and prefetch the elements all of them compare
+ * next before comparing any, so the cache misses of the searches overlap.
+ */
+#define _G_ARRAY_BOUND_BATCH_SIZE 16
+
+size_t _g_array_bound(const char *data, size_t len, unsigned int element_size, const void *target, GCompareFunc compare_func, int upper)
+{
+    size_t base = 0;
+
+    if (len == 0) {
+        return 0;
+    }
+
+    while (len > 1) {
+        size_t half = len / 2;
+        base += (compare_func(&data[(base + half - 1) * element_size], target) < upper) * half;
+        len -= half;
+    }
+
+    return base + (compare_func(&data[base * element_size], target) < upper);
+}
+
+void _g_array_bound_batch(const char *data, size_t len, unsigned int element_size, const char *targets,
+        unsigned int num_targets, GCompareFunc compare_func, int upper, unsigned int *out_positions)
+{
+    size_t base[_G_ARRAY_BOUND_BATCH_SIZE];
+
+    for (unsigned int first = 0; first < num_targets; first += _G_ARRAY_BOUND_BATCH_SIZE) {
+        unsigned int count = num_targets - first < _G_ARRAY_BOUND_BATCH_SIZE ? num_targets - first : _G_ARRAY_BOUND_BATCH_SIZE;
+        const char *batch_targets = &targets[(size_t) first * element_size];
+        size_t n = len;
+
+        if (len == 0) {
+            memset(&out_positions[first], 0, count * sizeof(unsigned int));
+            continue;
+        }
+
+        for (unsigned int i = 0; i < count; i++) {
+            base[i] = 0;
+        }
+
+        while (n > 1) {
+            size_t half = n / 2;
+
+            for (unsigned int i = 0; i < count; i++) {
+                _G_ARRAY_PREFETCH(&data[(base[i] + half - 1) * element_size]);
+            }
+
+            for (unsigned int i = 0; i < count; i++) {
+                const void *target = &batch_targets[i * element_size];
+                base[i] += (compare_func(&data[(base[i] + half - 1) * element_size], target) < upper) * half;
+            }
+
+            n -= half;
+        }
+
+        for (unsigned int i = 0; i < count; i++) {
+            const void *target = &batch_targets[i * element_size];
+            out_positions[first + i] = (unsigned int) (base[i] + (compare_func(&data[base[i] * element_size], target) < upper));
+        }
+    }
+}
+
+unsigned int g_array_lower_bound(GArray *array, const void *target, GCompareFunc compare_func)
+{
+    return (unsigned int) _g_array_bound(array->data, array->len, array->_element_size, target, compare_func, 0);
+}
+
+unsigned int g_array_upper_bound(GArray *array, const void *target, GCompareFunc compare_func)
+{
+    return (unsigned int) _g_array_bound(array->data, array->len, array->_element_size, target, compare_func, 1);
+}
+
+bool g_array_equal_range(GArray *array, const void *target, GCompareFunc compare_func, unsigned int *out_begin, unsigned int *out_end)
+{
+    unsigned int begin = g_array_lower_bound(array, target, compare_func);
+    unsigned int end = begin;
+
+    if (begin < array->len && compare_func(&array->data[begin * array->_element_size], target) == 0) {
+        // the upper bound can only be behind the lower bound
+        end = begin + (unsigned int) _g_array_bound(&array->data[begin * array->_element_size], array->len - begin,
+                array->_element_size, target, compare_func, 1);
+    }
+
+    if (out_begin) {
+        *out_begin = begin;
+    }
+
+    if (out_end) {
+        *out_end = end;
+    }
+
+    return begin < end;
+}
+
+void g_array_lower_bound_batch(GArray *array, const void *targets, unsigned int num_targets, GCompareFunc compare_func, unsigned int *out_positions)
+{
+    _g_array_bound_batch(array->data, array->len, array->_element_size, targets, num_targets, compare_func, 0, out_positions);
+}
+
+void g_array_upper_bound_batch(GArray *array, const void *targets, unsigned int num_targets, GCompareFunc compare_func, unsigned int *out_positions)
+{
+    _g_array_bound_batch(array->data, array->len, array->_element_size, targets, num_targets, compare_func, 1, out_positions);
+}
+
+// The typed bounds compare the elements directly instead of calling a compare
+// function. lower uses a < target, upper !(target < a).
+#define _G_ARRAY_DEFINE_TYPED_BOUNDS(suffix, type)\
+unsigned int _g_array_bound_##suffix(const type *data, size_t len, type target, bool upper)\
+{\
+    size_t base = 0;\
+\
+    if (len == 0) {\
+        return 0;\
+    }\
+\
+    while (len > 1) {\
+        size_t half = len / 2;\
+        type val = data[base + half - 1];\
+        base += (upper ? !(target < val) : val < target) * half;\
+        len -= half;\
+    }\
+\
+    return (unsigned int) (base + (upper ? !(target < data[base]) : data[base] < target));\
+}\
+\
+void _g_array_bound_batch_##suffix(const type *data, size_t len, const type *targets, unsigned int num_targets, bool upper, unsigned int *out_positions)\
+{\
+    size_t base[_G_ARRAY_BOUND_BATCH_SIZE];\
+\
+    for (unsigned int first = 0; first < num_targets; first += _G_ARRAY_BOUND_BATCH_SIZE) {\
+        unsigned int count = num_targets - first < _G_ARRAY_BOUND_BATCH_SIZE ? num_targets - first : _G_ARRAY_BOUND_BATCH_SIZE;\
+        const type *batch_targets = &targets[first];\
+        size_t n = len;\
+\
+        if (len == 0) {\
+            memset(&out_positions[first], 0, count * sizeof(unsigned int));\
+            continue;\
+        }\
+\
+        for (unsigned int i = 0; i < count; i++) {\
+            base[i] = 0;\
+        }\
+\
+        while (n > 1) {\
+            size_t half = n / 2;\
+\
+            for (unsigned int i = 0; i < count; i++) {\
+                _G_ARRAY_PREFETCH(&data[base[i] + half - 1]);\
+            }\
+\
+            for (unsigned int i = 0; i < count; i++) {\
+                type val = data[base[i] + half - 1];\
+                base[i] += (upper ? !(batch_targets[i] < val) : val < batch_targets[i]) * half;\
+            }\
+\
+            n -= half;\
+        }\
+\
+        for (unsigned int i = 0; i < count; i++) {\
+            type val = data[base[i]];\
+            out_positions[first + i] = (unsigned int) (base[i] + (upper ? !(batch_targets[i] < val) : val < batch_targets[i]));\
+        }\
+    }\
+}\
+\
+unsigned int g_array_lower_bound_##suffix(GArray *array, type target)\
+{\
+    return _g_array_bound_##suffix((const type*) array->data, array->len, target, false);\
+}\
+\
+unsigned int g_array_upper_bound_##suffix(GArray *array, type target)\
+{\
+    return _g_array_bound_##suffix((const type*) array->data, array->len, target, true);\
+}\
+\
+void g_array_lower_bound_batch_##suffix(GArray *array, const type *targets, unsigned int num_targets, unsigned int *out_positions)\
+{\
+    _g_array_bound_batch_##suffix((const type*) array->data, array->len, targets, num_targets, false, out_positions);\
+}\
+\
+void g_array_upper_bound_batch_##suffix(GArray *array, const type *targets, unsigned int num_targets, unsigned int *out_positions)\
+{\
+    _g_array_bound_batch_##suffix((const type*) array->data, array->len, targets, num_targets, true, out_positions);\
+}
+
+_G_ARRAY_DEFINE_TYPED_BOUNDS(u32, uint32_t)
+_G_ARRAY_DEFINE_TYPED_BOUNDS(i32, int32_t)
+_G_ARRAY_DEFINE_TYPED_BOUNDS(u64, uint64_t)
+_G_ARRAY_DEFINE_TYPED_BOUNDS(i64, int64_t)
+
+/*
+ * Linear search and filtering
+ *
+ * The typed functions compare several elements at once with SSE2 or AVX2 on
+ * x86 and NEON on AArch64. A block that contains a match is searched again
+ * element by element, so the vector code only has to tell if there is one.
+ */
+#if defined(_G_ARRAY_AVX2) || defined(_G_ARRAY_NEON)
+// Byte shuffles that move the 32 bit lanes set in a 4 bit mask to the front
+const uint8_t _g_array_compress_u32[16][16] = {
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {4, 5, 6, 7, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 4, 5, 6, 7, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {4, 5, 6, 7, 8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 0x80, 0x80, 0x80, 0x80},
+    {12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {4, 5, 6, 7, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 4, 5, 6, 7, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80},
+    {8, 9, 10, 11, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 8, 9, 10, 11, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80},
+    {4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0x80, 0x80, 0x80, 0x80},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}
+};
+
+const uint8_t _g_array_compress_count[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+#endif
+
+bool _g_array_check_element_size(GArray *array, unsigned int element_size, const char *func)
+{
+    if (array->_element_size != element_size) {
+        fprintf(stderr, "Critical: %s: element size is %u instead of %u\n", func, array->_element_size, element_size);
+        return false;
+    }
+
+    return true;
+}
+
+bool g_array_find_u32(GArray *array, uint32_t target, unsigned int *out_index)
+{
+    const uint32_t *data = (const uint32_t*) array->data;
+    unsigned int len = array->len;
+    unsigned int i = 0;
+
+    if (!_g_array_check_element_size(array, sizeof(uint32_t), "g_array_find_u32")) {
+        return false;
+    }
+
+#if defined(_G_ARRAY_AVX2)
+    __m256i t = _mm256_set1_epi32((int) target);
+    for (; i + 16 <= len; i += 16) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) &data[i]), t);
+        __m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) &data[i + 8]), t);
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) {
+            break;
+        }
+    }
+#elif defined(_G_ARRAY_SSE2)
+    __m128i t = _mm_set1_epi32((int) target);
+    for (; i + 8 <= len; i += 8) {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) &data[i]), t);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) &data[i + 4]), t);
+        if (_mm_movemask_epi8(_mm_or_si128(a, b))) {
+            break;
+        }
+    }
+#elif defined(_G_ARRAY_NEON)
+    uint32x4_t t = vdupq_n_u32(target);
+    for (; i + 8 <= len; i += 8) {
+        uint32x4_t a = vceqq_u32(vld1q_u32(&data[i]), t);
+        uint32x4_t b = vceqq_u32(vld1q_u32(&data[i + 4]), t);
+        if (vmaxvq_u32(vorrq_u32(a, b))) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (data[i] == target) {
+            if (out_index) {
+                *out_index = i;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool g_array_find_u64(GArray *array, uint64_t target, unsigned int *out_index)
+{
+    const uint64_t *data = (const uint64_t*) array->data;
+    unsigned int len = array->len;
+    unsigned int i = 0;
+
+    if (!_g_array_check_element_size(array, sizeof(uint64_t), "g_array_find_u64")) {
+        return false;
+    }
+
+#if defined(_G_ARRAY_AVX2)
+    __m256i t = _mm256_set1_epi64x((long long) target);
+    for (; i + 8 <= len; i += 8) {
+        __m256i a = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) &data[i]), t);
+        __m256i b = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) &data[i + 4]), t);
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) {
+            break;
+        }
+    }
+#elif defined(_G_ARRAY_SSE2)
+    // SSE2 has no 64 bit compare: both 32 bit halves have to be equal
+    __m128i t = _mm_set1_epi64x((long long) target);
+    for (; i + 4 <= len; i += 4) {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) &data[i]), t);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) &data[i + 2]), t);
+        a = _mm_and_si128(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(2, 3, 0, 1)));
+        b = _mm_and_si128(b, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 3, 0, 1)));
+        if (_mm_movemask_epi8(_mm_or_si128(a, b))) {
+            break;
+        }
+    }
+#elif defined(_G_ARRAY_NEON)
+    uint64x2_t t = vdupq_n_u64(target);
+    for (; i + 4 <= len; i += 4) {
+        uint64x2_t a = vceqq_u64(vld1q_u64(&data[i]), t);
+        uint64x2_t b = vceqq_u64(vld1q_u64(&data[i + 2]), t);
+        if (vmaxvq_u32(vreinterpretq_u32_u64(vorrq_u64(a, b)))) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (data[i] == target) {
+            if (out_index) {
+                *out_index = i;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool g_array_find_f32(GArray *array, float target, unsigned int *out_index)
+{
+    const float *data = (const float*) array->data;
+    unsigned int len = array->len;
+    unsigned int i = 0;
+
+    if (!_g_array_check_element_size(array, sizeof(float), "g_array_find_f32")) {
+        return false;
+    }
+
+#if defined(_G_ARRAY_AVX2)
+    __m256 t = _mm256_set1_ps(target);
+    for (; i + 16 <= len; i += 16) {
+        __m256 a = _mm256_cmp_ps(_mm256_loadu_ps(&data[i]), t, _CMP_EQ_OQ);
+        __m256 b = _mm256_cmp_ps(_mm256_loadu_ps(&data[i + 8]), t, _CMP_EQ_OQ);
+        if (_mm256_movemask_ps(_mm256_or_ps(a, b))) {
+            break;
+        }
+    }
+#elif defined(_G_ARRAY_SSE2)
+    __m128 t = _mm_set1_ps(target);
+    for (; i + 8 <= len; i += 8) {
+        __m128 a = _mm_cmpeq_ps(_mm_loadu_ps(&data[i]), t);
+        __m128 b = _mm_cmpeq_ps(_mm_loadu_ps(&data[i + 4]), t);
+        if (_mm_movemask_ps(_mm_or_ps(a, b))) {
+            break;
+        }
+    }
+#elif defined(_G_ARRAY_NEON)
+    float32x4_t t = vdupq_n_f32(target);
+    for (; i + 8 <= len; i += 8) {
+        uint32x4_t a = vceqq_f32(vld1q_f32(&data[i]), t);
+        uint32x4_t b = vceqq_f32(vld1q_f32(&data[i + 4]), t);
+        if (vmaxvq_u32(vorrq_u32(a, b))) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < len; i++) {
+        if (data[i] == target) {
+            if (out_index) {
+                *out_index = i;
             }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unsigned int g_array_count_if(GArray *array, GArrayPredicateFunc predicate, void *user_data)
+{
+    unsigned int count = 0;
+
+    for (unsigned int i = 0; i < array->len; i++) {
+        count += predicate(&array->data[(size_t) i * array->_element_size], user_data) ? 1 : 0;
+    }
+
+    return count;
+}
+
+// Creates the result of a filter with room for all elements of array
+GArray* _g_array_filter_new(GArray *array)
+{
+    return g_array_sized_new(array->_zero_terminated, array->_clear, array->_element_size, array->len);
+}
+
+// Sets the length of a filter result and gives back the memory if most
+// elements were dropped
+GArray* _g_array_filter_finish(GArray *result, unsigned int len)
+{
+    result->len = len;
+    // the filters write behind len as well
+    result->_dirty_elements = result->_allocated_elements;
+
+    if (result->_zero_terminated) {
+        _g_array_zero_terminate(result);
+    }
+
+    if (len < result->_allocated_elements / 2) {
+        g_array_shrink_to_fit(result);
+    }
+
+    return result;
+}
+
+GArray* g_array_filter(GArray *array, GArrayPredicateFunc predicate, void *user_data)
+{
+    GArray *result = _g_array_filter_new(array);
+    size_t es = array->_element_size;
+    unsigned int n = 0;
+
+    // every element is copied and only kept if the predicate is true, so
+    // there is no branch on its result
+    for (unsigned int i = 0; i < array->len; i++) {
+        const char *element = &array->data[i * es];
+
+        memcpy(&result->data[n * es], element, es);
+        n += predicate(element, user_data) ? 1 : 0;
+    }
+
+    return _g_array_filter_finish(result, n);
+}
+
+unsigned int g_array_count_range_u32(GArray *array, uint32_t min, uint32_t max)
+{
+    const uint32_t *data = (const uint32_t*) array->data;
+    unsigned int len = array->len;
+    unsigned int count = 0;
+    unsigned int i = 0;
+    // x is in [min, max] if x - min <= max - min without sign
+    uint32_t span = max - min;
+
+    if (!_g_array_check_element_size(array, sizeof(uint32_t), "g_array_count_range_u32") || min > max) {
+        return 0;
+    }
+
+#if defined(_G_ARRAY_AVX2)
+    // there is no unsigned compare, flipping the sign bit makes the signed one
+    // work
+    __m256i vmin = _mm256_set1_epi32((int) min);
+    __m256i sign = _mm256_set1_epi32(INT_MIN);
+    __m256i limit = _mm256_set1_epi32((int) (span ^ 0x80000000u));
+    __m256i outside = _mm256_setzero_si256();
+    unsigned int lanes[8];
+    unsigned int blocks = 0;
+
+    for (; i + 8 <= len; i += 8) {
+        __m256i d = _mm256_xor_si256(_mm256_sub_epi32(_mm256_loadu_si256((const __m256i*) &data[i]), vmin), sign);
+        outside = _mm256_sub_epi32(outside, _mm256_cmpgt_epi32(d, limit));
+        blocks++;
+    }
+
+    _mm256_storeu_si256((__m256i*) lanes, outside);
+    count = blocks * 8;
+    for (int j = 0; j < 8; j++) {
+        count -= lanes[j];
+    }
+#elif defined(_G_ARRAY_SSE2)
+    __m128i vmin = _mm_set1_epi32((int) min);
+    __m128i sign = _mm_set1_epi32(INT_MIN);
+    __m128i limit = _mm_set1_epi32((int) (span ^ 0x80000000u));
+    __m128i outside = _mm_setzero_si128();
+    unsigned int lanes[4];
+    unsigned int blocks = 0;
+
+    for (; i + 4 <= len; i += 4) {
+        __m128i d = _mm_xor_si128(_mm_sub_epi32(_mm_loadu_si128((const __m128i*) &data[i]), vmin), sign);
+        outside = _mm_sub_epi32(outside, _mm_cmpgt_epi32(d, limit));
+        blocks++;
+    }
+
+    _mm_storeu_si128((__m128i*) lanes, outside);
+    count = blocks * 4;
+    for (int j = 0; j < 4; j++) {
+        count -= lanes[j];
+    }
+#elif defined(_G_ARRAY_NEON)
+    uint32x4_t vmin = vdupq_n_u32(min);
+    uint32x4_t limit = vdupq_n_u32(span);
+    uint32x4_t inside = vdupq_n_u32(0);
+
+    for (; i + 4 <= len; i += 4) {
+        uint32x4_t d = vsubq_u32(vld1q_u32(&data[i]), vmin);
+        inside = vsubq_u32(inside, vcleq_u32(d, limit));
+    }
+
+    count = vaddvq_u32(inside);
+#endif
+
+    for (; i < len; i++) {
+        count += (data[i] - min <= span) ? 1 : 0;
+    }
+
+    return count;
+}
+
+GArray* g_array_filter_range_u32(GArray *array, uint32_t min, uint32_t max)
+{
+    const uint32_t *data = (const uint32_t*) array->data;
+    unsigned int len = array->len;
+    unsigned int n = 0;
+    unsigned int i = 0;
+    uint32_t span = max - min;
+    GArray *result;
+    uint32_t *out;
+
+    if (!_g_array_check_element_size(array, sizeof(uint32_t), "g_array_filter_range_u32") || min > max) {
+        return g_array_sized_new(array->_zero_terminated, array->_clear, array->_element_size, 0);
+    }
+
+    result = _g_array_filter_new(array);
+    out = (uint32_t*) result->data;
+
+    // n <= i, so storing all lanes of a block at out[n] stays within the
+    // array and the ones that don't match are overwritten later. SSE2 has no
+    // byte shuffle to move the matches together, there the scalar loop is
+    // faster.
+#if defined(_G_ARRAY_AVX2)
+    __m256i vmin = _mm256_set1_epi32((int) min);
+    __m256i sign = _mm256_set1_epi32(INT_MIN);
+    __m256i limit = _mm256_set1_epi32((int) (span ^ 0x80000000u));
+
+    for (; i + 8 <= len; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) &data[i]);
+        __m256i d = _mm256_xor_si256(_mm256_sub_epi32(v, vmin), sign);
+        unsigned int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(d, limit))) & 0xff;
+        __m128i lo = _mm256_castsi256_si128(v);
+        __m128i hi = _mm256_extracti128_si256(v, 1);
+
+        lo = _mm_shuffle_epi8(lo, _mm_loadu_si128((const __m128i*) _g_array_compress_u32[mask & 0xf]));
+        _mm_storeu_si128((__m128i*) &out[n], lo);
+        n += _g_array_compress_count[mask & 0xf];
+
+        hi = _mm_shuffle_epi8(hi, _mm_loadu_si128((const __m128i*) _g_array_compress_u32[mask >> 4]));
+        _mm_storeu_si128((__m128i*) &out[n], hi);
+        n += _g_array_compress_count[mask >> 4];
+    }
+#elif defined(_G_ARRAY_NEON)
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    uint32x4_t vbits = vld1q_u32(lane_bits);
+    uint32x4_t vmin = vdupq_n_u32(min);
+    uint32x4_t limit = vdupq_n_u32(span);
+
+    for (; i + 4 <= len; i += 4) {
+        uint32x4_t v = vld1q_u32(&data[i]);
+        unsigned int mask = vaddvq_u32(vandq_u32(vcleq_u32(vsubq_u32(v, vmin), limit), vbits));
+        uint8x16_t shuffled = vqtbl1q_u8(vreinterpretq_u8_u32(v), vld1q_u8(_g_array_compress_u32[mask]));
+
+        vst1q_u32(&out[n], vreinterpretq_u32_u8(shuffled));
+        n += _g_array_compress_count[mask];
+    }
+#endif
+
+    for (; i < len; i++) {
+        out[n] = data[i];
+        n += (data[i] - min <= span) ? 1 : 0;
+    }
+
+    return _g_array_filter_finish(result, n);
+}
+
+/*
+ * Set operations on sorted arrays
+ *
+ * The arrays are sorted and, except for g_array_sorted_merge, free of
+ * duplicates. Arrays of similar size are walked in lockstep without branching
+ * on the comparisons. If one is more than GARRAY_GALLOP_RATIO times larger,
+ * each element of the small one is looked up in the large one with an
+ * exponential search from the previous position instead, and the runs in
+ * between are copied in one piece.
+ */
+#define _G_ARRAY_SET_INTERSECT 0
+#define _G_ARRAY_SET_UNION 1
+#define _G_ARRAY_SET_DIFFERENCE 2
+#define _G_ARRAY_SET_MERGE 3
+
+GArray* _g_array_set_result_new(GArray *a, GArray *b, unsigned int element_size, int op, const char *func)
+{
+    size_t capacity;
+
+    if (a->_element_size != element_size || b->_element_size != element_size) {
+        fprintf(stderr, "Critical: %s: element sizes %u and %u don't match %u\n", func,
+            a->_element_size, b->_element_size, element_size);
+        return NULL;
+    }
+
+    if (op == _G_ARRAY_SET_INTERSECT) {
+        capacity = a->len < b->len ? a->len : b->len;
+    } else if (op == _G_ARRAY_SET_DIFFERENCE) {
+        capacity = a->len;
+    } else {
+        capacity = (size_t) a->len + b->len;
+    }
+
+    if (capacity >= UINT_MAX) {
+        fprintf(stderr, "Critical: %s: the result can have more than %u elements\n", func, UINT_MAX - 1);
+        return NULL;
+    }
+
+    return g_array_sized_new(a->_zero_terminated, a->_clear, element_size, (unsigned int) capacity);
+}
+
+bool _g_array_set_gallops(size_t na, size_t nb)
+{
+    size_t small = na < nb ? na : nb;
+    size_t large = na < nb ? nb : na;
+
+    return small * GARRAY_GALLOP_RATIO < large;
+}
+
+// Returns the lower (or upper) bound of target in data[begin, len) by probing
+// begin, begin + 1, begin + 3, begin + 7, ... and searching the last step
+size_t _g_array_gallop(const char *data, size_t begin, size_t len, size_t element_size, const void *target,
+    GCompareFunc compare_func, int upper)
+{
+    size_t lo = begin;
+    size_t hi = begin;
+    size_t step = 1;
+
+    while (hi < len && compare_func(&data[hi * element_size], target) < upper) {
+        lo = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+
+    if (hi > len) {
+        hi = len;
+    }
+
+    return lo + _g_array_bound(&data[lo * element_size], hi - lo, element_size, target, compare_func, upper);
+}
+
+size_t _g_array_set_linear(const char *a, size_t na, const char *b, size_t nb, size_t es, GCompareFunc compare_func,
+    int op, char *out)
+{
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    switch (op) {
+    case _G_ARRAY_SET_INTERSECT:
+        while (i < na && j < nb) {
+            int cmp = compare_func(&a[i * es], &b[j * es]);
+            memcpy(&out[n * es], &a[i * es], es);
+            n += cmp == 0;
+            i += cmp <= 0;
+            j += cmp >= 0;
+        }
+        break;
+    case _G_ARRAY_SET_UNION:
+        while (i < na && j < nb) {
+            int cmp = compare_func(&a[i * es], &b[j * es]);
+            memcpy(&out[n * es], cmp <= 0 ? &a[i * es] : &b[j * es], es);
+            n++;
+            i += cmp <= 0;
+            j += cmp >= 0;
+        }
+        break;
+    case _G_ARRAY_SET_DIFFERENCE:
+        while (i < na && j < nb) {
+            int cmp = compare_func(&a[i * es], &b[j * es]);
+            memcpy(&out[n * es], &a[i * es], es);
+            n += cmp < 0;
+            i += cmp <= 0;
+            j += cmp >= 0;
+        }
+        break;
+    default:
+        // equal elements of a go first
+        while (i < na && j < nb) {
+            bool take_b = compare_func(&a[i * es], &b[j * es]) > 0;
+            memcpy(&out[n * es], take_b ? &b[j * es] : &a[i * es], es);
+            n++;
+            i += !take_b;
+            j += take_b;
+        }
+        break;
+    }
+
+    if (op != _G_ARRAY_SET_INTERSECT) {
+        memcpy(&out[n * es], &a[i * es], (na - i) * es);
+        n += na - i;
+    }
+
+    if (op == _G_ARRAY_SET_UNION || op == _G_ARRAY_SET_MERGE) {
+        memcpy(&out[n * es], &b[j * es], (nb - j) * es);
+        n += nb - j;
+    }
+
+    return n;
+}
+
+size_t _g_array_set_gallop(const char *a, size_t na, const char *b, size_t nb, size_t es, GCompareFunc compare_func,
+    int op, char *out)
+{
+    bool a_small = na <= nb;
+    const char *s = a_small ? a : b;
+    const char *l = a_small ? b : a;
+    size_t ns = a_small ? na : nb;
+    size_t nl = a_small ? nb : na;
+    // the elements of the large array between two elements of the small one
+    // are all part of the result or none are
+    bool copy_l = op == _G_ARRAY_SET_UNION || op == _G_ARRAY_SET_MERGE || (op == _G_ARRAY_SET_DIFFERENCE && !a_small);
+    // when merging, elements of a go before equal ones of b
+    int upper = op == _G_ARRAY_SET_MERGE && !a_small;
+    size_t pos = 0;
+    size_t n = 0;
+
+    for (size_t k = 0; k < ns; k++) {
+        const char *x = &s[k * es];
+        size_t next = _g_array_gallop(l, pos, nl, es, x, compare_func, upper);
+        bool match;
+
+        if (copy_l) {
+            memcpy(&out[n * es], &l[pos * es], (next - pos) * es);
+            n += next - pos;
+        }
+
+        pos = next;
+        match = op != _G_ARRAY_SET_MERGE && pos < nl && compare_func(&l[pos * es], x) == 0;
+
+        // results that are in both arrays are taken from a
+        if ((op == _G_ARRAY_SET_INTERSECT && match) || op == _G_ARRAY_SET_UNION) {
+            memcpy(&out[n * es], match && !a_small ? &l[pos * es] : x, es);
+            n++;
+        } else if (op == _G_ARRAY_SET_MERGE || (op == _G_ARRAY_SET_DIFFERENCE && a_small && !match)) {
+            memcpy(&out[n * es], x, es);
+            n++;
+        }
+
+        pos += match;
+    }
+
+    if (copy_l) {
+        memcpy(&out[n * es], &l[pos * es], (nl - pos) * es);
+        n += nl - pos;
+    }
+
+    return n;
+}
+
+GArray* _g_array_sorted_set_op(GArray *a, GArray *b, GCompareFunc compare_func, int op, const char *func)
+{
+    GArray *result = _g_array_set_result_new(a, b, a->_element_size, op, func);
+    size_t n;
+
+    if (result == NULL) {
+        return NULL;
+    }
+
+    if (_g_array_set_gallops(a->len, b->len)) {
+        n = _g_array_set_gallop(a->data, a->len, b->data, b->len, a->_element_size, compare_func, op, result->data);
+    } else {
+        n = _g_array_set_linear(a->data, a->len, b->data, b->len, a->_element_size, compare_func, op, result->data);
+    }
+
+    return _g_array_filter_finish(result, (unsigned int) n);
+}
+
+GArray* g_array_sorted_intersect(GArray *a, GArray *b, GCompareFunc compare_func)
+{
+    return _g_array_sorted_set_op(a, b, compare_func, _G_ARRAY_SET_INTERSECT, "g_array_sorted_intersect");
+}
+
+GArray* g_array_sorted_union(GArray *a, GArray *b, GCompareFunc compare_func)
+{
+    return _g_array_sorted_set_op(a, b, compare_func, _G_ARRAY_SET_UNION, "g_array_sorted_union");
+}
+
+GArray* g_array_sorted_difference(GArray *a, GArray *b, GCompareFunc compare_func)
+{
+    return _g_array_sorted_set_op(a, b, compare_func, _G_ARRAY_SET_DIFFERENCE, "g_array_sorted_difference");
+}
+
+GArray* g_array_sorted_merge(GArray *a, GArray *b, GCompareFunc compare_func)
+{
+    return _g_array_sorted_set_op(a, b, compare_func, _G_ARRAY_SET_MERGE, "g_array_sorted_merge");
+}
+
+// The typed set operations follow the ones above with the comparisons
+// written out. g_array_sorted_intersect_u32 additionally compares blocks of
+// elements with SIMD.
+#define _G_ARRAY_DEFINE_TYPED_SET_OPS(suffix, type)\
+size_t _g_array_gallop_##suffix(const type *data, size_t begin, size_t len, type target, bool upper)\
+{\
+    size_t lo = begin;\
+    size_t hi = begin;\
+    size_t step = 1;\
+\
+    while (hi < len && (upper ? !(target < data[hi]) : data[hi] < target)) {\
+        lo = hi + 1;\
+        hi += step;\
+        step *= 2;\
+    }\
+\
+    if (hi > len) {\
+        hi = len;\
+    }\
+\
+    return lo + _g_array_bound_##suffix(&data[lo], hi - lo, target, upper);\
+}\
+\
+size_t _g_array_set_linear_##suffix(const type *a, size_t na, const type *b, size_t nb, int op, type *out)\
+{\
+    size_t i = 0;\
+    size_t j = 0;\
+    size_t n = 0;\
+\
+    switch (op) {\
+    case _G_ARRAY_SET_INTERSECT:\
+        while (i < na && j < nb) {\
+            type x = a[i];\
+            type y = b[j];\
+            out[n] = x;\
+            n += x == y;\
+            i += !(y < x);\
+            j += !(x < y);\
+        }\
+        break;\
+    case _G_ARRAY_SET_UNION:\
+        while (i < na && j < nb) {\
+            type x = a[i];\
+            type y = b[j];\
+            out[n++] = y < x ? y : x;\
+            i += !(y < x);\
+            j += !(x < y);\
+        }\
+        break;\
+    case _G_ARRAY_SET_DIFFERENCE:\
+        while (i < na && j < nb) {\
+            type x = a[i];\
+            type y = b[j];\
+            out[n] = x;\
+            n += x < y;\
+            i += !(y < x);\
+            j += !(x < y);\
+        }\
+        break;\
+    default:\
+        while (i < na && j < nb) {\
+            type x = a[i];\
+            type y = b[j];\
+            bool take_b = y < x;\
+            out[n++] = take_b ? y : x;\
+            i += !take_b;\
+            j += take_b;\
+        }\
+        break;\
+    }\
+\
+    if (op != _G_ARRAY_SET_INTERSECT) {\
+        memcpy(&out[n], &a[i], (na - i) * sizeof(type));\
+        n += na - i;\
+    }\
+\
+    if (op == _G_ARRAY_SET_UNION || op == _G_ARRAY_SET_MERGE) {\
+        memcpy(&out[n], &b[j], (nb - j) * sizeof(type));\
+        n += nb - j;\
+    }\
+\
+    return n;\
+}\
+\
+size_t _g_array_set_gallop_##suffix(const type *a, size_t na, const type *b, size_t nb, int op, type *out)\
+{\
+    bool a_small = na <= nb;\
+    const type *s = a_small ? a : b;\
+    const type *l = a_small ? b : a;\
+    size_t ns = a_small ? na : nb;\
+    size_t nl = a_small ? nb : na;\
+    bool copy_l = op == _G_ARRAY_SET_UNION || op == _G_ARRAY_SET_MERGE || (op == _G_ARRAY_SET_DIFFERENCE && !a_small);\
+    bool upper = op == _G_ARRAY_SET_MERGE && !a_small;\
+    size_t pos = 0;\
+    size_t n = 0;\
+\
+    for (size_t k = 0; k < ns; k++) {\
+        type x = s[k];\
+        size_t next = _g_array_gallop_##suffix(l, pos, nl, x, upper);\
+        bool match;\
+\
+        if (copy_l) {\
+            memcpy(&out[n], &l[pos], (next - pos) * sizeof(type));\
+            n += next - pos;\
+        }\
+\
+        pos = next;\
+        match = op != _G_ARRAY_SET_MERGE && pos < nl && l[pos] == x;\
+\
+        if ((op == _G_ARRAY_SET_INTERSECT && match) || op == _G_ARRAY_SET_UNION || op == _G_ARRAY_SET_MERGE ||\
+                (op == _G_ARRAY_SET_DIFFERENCE && a_small && !match)) {\
+            out[n++] = x;\
+        }\
+\
+        pos += match;\
+    }\
+\
+    if (copy_l) {\
+        memcpy(&out[n], &l[pos], (nl - pos) * sizeof(type));\
+        n += nl - pos;\
+    }\
+\
+    return n;\
+}\
+\
+size_t _g_array_set_op_##suffix(const type *a, size_t na, const type *b, size_t nb, int op, type *out)\
+{\
+    if (_g_array_set_gallops(na, nb)) {\
+        return _g_array_set_gallop_##suffix(a, na, b, nb, op, out);\
+    }\
+\
+    return _g_array_set_linear_##suffix(a, na, b, nb, op, out);\
+}
+
+#define _G_ARRAY_DEFINE_TYPED_SET_FUNCS(suffix, type, intersect_func)\
+GArray* _g_array_sorted_set_op_##suffix(GArray *a, GArray *b, int op, const char *func)\
+{\
+    GArray *result = _g_array_set_result_new(a, b, sizeof(type), op, func);\
+    size_t n;\
+\
+    if (result == NULL) {\
+        return NULL;\
+    }\
+\
+    if (op == _G_ARRAY_SET_INTERSECT) {\
+        n = intersect_func((const type*) a->data, a->len, (const type*) b->data, b->len, (type*) result->data);\
+    } else {\
+        n = _g_array_set_op_##suffix((const type*) a->data, a->len, (const type*) b->data, b->len, op,\
+                (type*) result->data);\
+    }\
+\
+    return _g_array_filter_finish(result, (unsigned int) n);\
+}\
+\
+GArray* g_array_sorted_intersect_##suffix(GArray *a, GArray *b)\
+{\
+    return _g_array_sorted_set_op_##suffix(a, b, _G_ARRAY_SET_INTERSECT, "g_array_sorted_intersect_" #suffix);\
+}\
+\
+GArray* g_array_sorted_union_##suffix(GArray *a, GArray *b)\
+{\
+    return _g_array_sorted_set_op_##suffix(a, b, _G_ARRAY_SET_UNION, "g_array_sorted_union_" #suffix);\
+}\
+\
+GArray* g_array_sorted_difference_##suffix(GArray *a, GArray *b)\
+{\
+    return _g_array_sorted_set_op_##suffix(a, b, _G_ARRAY_SET_DIFFERENCE, "g_array_sorted_difference_" #suffix);\
+}\
+\
+GArray* g_array_sorted_merge_##suffix(GArray *a, GArray *b)\
+{\
+    return _g_array_sorted_set_op_##suffix(a, b, _G_ARRAY_SET_MERGE, "g_array_sorted_merge_" #suffix);\
+}\
+\
+GArray* g_array_view_sorted_intersect_##suffix(GArrayView a, GArrayView b)\
+{\
+    GArray array_a;\
+    GArray array_b;\
+\
+    return _g_array_sorted_set_op_##suffix(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b),\
+        _G_ARRAY_SET_INTERSECT, "g_array_view_sorted_intersect_" #suffix);\
+}\
+\
+GArray* g_array_view_sorted_union_##suffix(GArrayView a, GArrayView b)\
+{\
+    GArray array_a;\
+    GArray array_b;\
+\
+    return _g_array_sorted_set_op_##suffix(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b),\
+        _G_ARRAY_SET_UNION, "g_array_view_sorted_union_" #suffix);\
+}\
+\
+GArray* g_array_view_sorted_difference_##suffix(GArrayView a, GArrayView b)\
+{\
+    GArray array_a;\
+    GArray array_b;\
+\
+    return _g_array_sorted_set_op_##suffix(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b),\
+        _G_ARRAY_SET_DIFFERENCE, "g_array_view_sorted_difference_" #suffix);\
+}\
+\
+GArray* g_array_view_sorted_merge_##suffix(GArrayView a, GArrayView b)\
+{\
+    GArray array_a;\
+    GArray array_b;\
+\
+    return _g_array_sorted_set_op_##suffix(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b),\
+        _G_ARRAY_SET_MERGE, "g_array_view_sorted_merge_" #suffix);\
+}
+
+#define _G_ARRAY_DEFINE_TYPED_INTERSECT(suffix, type)\
+size_t _g_array_intersect_##suffix(const type *a, size_t na, const type *b, size_t nb, type *out)\
+{\
+    return _g_array_set_op_##suffix(a, na, b, nb, _G_ARRAY_SET_INTERSECT, out);\
+}
+
+_G_ARRAY_DEFINE_TYPED_SET_OPS(u32, uint32_t)
+_G_ARRAY_DEFINE_TYPED_SET_OPS(i32, int32_t)
+_G_ARRAY_DEFINE_TYPED_SET_OPS(u64, uint64_t)
+_G_ARRAY_DEFINE_TYPED_SET_OPS(i64, int64_t)
+_G_ARRAY_DEFINE_TYPED_INTERSECT(i32, int32_t)
+_G_ARRAY_DEFINE_TYPED_INTERSECT(u64, uint64_t)
+_G_ARRAY_DEFINE_TYPED_INTERSECT(i64, int64_t)
+
+// Compares a block of a with a block of b, all pairs at once, and keeps the
+// elements of a that are in b. The block with the smaller last element can't
+// have more matches and is skipped, both if the last elements are equal. A
+// whole block is stored at out[n], but out only holds min(na, nb) elements
+// and n can catch up with i or j, so the blocks stop when one might not fit
+// and the scalar loop finishes the rest. With duplicates in the inputs a
+// block keeps every copy that has a match, so the scalar loop also stops
+// when out is full.
+size_t _g_array_intersect_u32(const uint32_t *a, size_t na, const uint32_t *b, size_t nb, uint32_t *out)
+{
+    size_t capacity = na < nb ? na : nb;
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    if (_g_array_set_gallops(na, nb)) {
+        return _g_array_set_gallop_u32(a, na, b, nb, _G_ARRAY_SET_INTERSECT, out);
+    }
+
+#if defined(_G_ARRAY_AVX2)
+    while (i + 8 <= na && j + 8 <= nb && n + 8 <= capacity) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) &a[i]);
+        __m256i vb = _mm256_loadu_si256((const __m256i*) &b[j]);
+        // the rotations within each half and of the swapped halves together
+        // put every element of b next to every element of a once
+        __m256i vs = _mm256_permute2x128_si256(vb, vb, 1);
+        __m256i eq = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, vb), _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x39))),
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x4e)),
+                    _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x93)))),
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, vs), _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x39))),
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x4e)),
+                    _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x93)))));
+        unsigned int mask = (unsigned int) _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        uint32_t a_last = a[i + 7];
+        uint32_t b_last = b[j + 7];
+        __m128i lo = _mm_shuffle_epi8(_mm256_castsi256_si128(va),
+            _mm_loadu_si128((const __m128i*) _g_array_compress_u32[mask & 0xf]));
+        __m128i hi = _mm_shuffle_epi8(_mm256_extracti128_si256(va, 1),
+            _mm_loadu_si128((const __m128i*) _g_array_compress_u32[mask >> 4]));
+
+        _mm_storeu_si128((__m128i*) &out[n], lo);
+        n += _g_array_compress_count[mask & 0xf];
+        _mm_storeu_si128((__m128i*) &out[n], hi);
+        n += _g_array_compress_count[mask >> 4];
+
+        i += (a_last <= b_last) * 8;
+        j += (b_last <= a_last) * 8;
+    }
+#elif defined(_G_ARRAY_SSE2)
+    while (i + 4 <= na && j + 4 <= nb && n + 4 <= capacity) {
+        __m128i va = _mm_loadu_si128((const __m128i*) &a[i]);
+        __m128i vb = _mm_loadu_si128((const __m128i*) &b[j]);
+        __m128i eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4e)), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+        unsigned int mask = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(eq));
+        uint32_t a_last = a[i + 3];
+        uint32_t b_last = b[j + 3];
+
+        for (int k = 0; k < 4; k++) {
+            out[n] = a[i + k];
+            n += (mask >> k) & 1;
+        }
+
+        i += (a_last <= b_last) * 4;
+        j += (b_last <= a_last) * 4;
+    }
+#elif defined(_G_ARRAY_NEON)
+    static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+    uint32x4_t vbits = vld1q_u32(lane_bits);
+
+    while (i + 4 <= na && j + 4 <= nb && n + 4 <= capacity) {
+        uint32x4_t va = vld1q_u32(&a[i]);
+        uint32x4_t vb = vld1q_u32(&b[j]);
+        uint32x4_t eq = vorrq_u32(
+            vorrq_u32(vceqq_u32(va, vb), vceqq_u32(va, vextq_u32(vb, vb, 1))),
+            vorrq_u32(vceqq_u32(va, vextq_u32(vb, vb, 2)), vceqq_u32(va, vextq_u32(vb, vb, 3))));
+        unsigned int mask = vaddvq_u32(vandq_u32(eq, vbits));
+        uint32_t a_last = a[i + 3];
+        uint32_t b_last = b[j + 3];
+        uint8x16_t shuffled = vqtbl1q_u8(vreinterpretq_u8_u32(va), vld1q_u8(_g_array_compress_u32[mask]));
+
+        vst1q_u32(&out[n], vreinterpretq_u32_u8(shuffled));
+        n += _g_array_compress_count[mask];
+
+        i += (a_last <= b_last) * 4;
+        j += (b_last <= a_last) * 4;
+    }
+#endif
+
+    while (i < na && j < nb && n < capacity) {
+        uint32_t x = a[i];
+        uint32_t y = b[j];
+        out[n] = x;
+        n += x == y;
+        i += !(y < x);
+        j += !(x < y);
+    }
+
+    return n;
+}
+
+_G_ARRAY_DEFINE_TYPED_SET_FUNCS(u32, uint32_t, _g_array_intersect_u32)
+_G_ARRAY_DEFINE_TYPED_SET_FUNCS(i32, int32_t, _g_array_intersect_i32)
+_G_ARRAY_DEFINE_TYPED_SET_FUNCS(u64, uint64_t, _g_array_intersect_u64)
+_G_ARRAY_DEFINE_TYPED_SET_FUNCS(i64, int64_t, _g_array_intersect_i64)
+
+bool g_array_binary_search(GArray *array, const void *target, GCompareFunc compare_func, unsigned int *out_match_index)
+{
+    unsigned int index;
+
+    if (array == NULL) {
+        return false;
+    }
+
+    if (target == NULL) {
+        return false;
+    }
 
-            return true;
-        }
+    // the lower bound is the left-most match if there is one
+    index = g_array_lower_bound(array, target, compare_func);
+    if (index >= array->len || compare_func(&array->data[index * array->_element_size], target) != 0) {
+        return false;
     }
 
-    return false;
+    if (out_match_index) {
+        *out_match_index = index;
+    }
+
+    return true;
 }
 
 GArray* g_array_set_size(GArray *array, unsigned int length)
 {
+    unsigned int dirty = 0;
+
     if (length <= array->len) {
-        if (array->_clear_func && array->len > length) {
-            // call clear func on all elements that are going to be removed
-            int start_index = (array->len - length) - 1;
-            for (int i = start_index; i < array->len; i++) {
-                array->_clear_func(&array->data[i]);
-            }
-        }
+        return g_array_truncate(array, length);
+    }
 
-        array->len = length;
+    if (array->_clear) {
+        // only elements that were in use before can be non-zero, the rest are
+        // still zero from the allocation
+        dirty = array->_dirty_elements < length ? array->_dirty_elements : length;
+    }
 
-        if (array->_zero_terminated) {
-            _g_array_zero_terminate(array);
-        }
+    _g_array_resize_if_needed(array, length - array->len);
 
-        return array;
+    if (array->_clear && dirty > array->len) {
+        memset(&array->data[(size_t) array->len * array->_element_size], 0,
+            (size_t) (dirty - array->len) * array->_element_size);
     }
 
-    _g_array_resize_if_needed(array, length - array->len);
     array->len = length;
     if (array->_zero_terminated) {
         _g_array_zero_terminate(array);
@@ -447,35 +3627,561 @@ GArray* g_array_set_size(GArray *array, unsigned int length)
     return array;
 }
 
+GArray* g_array_reserve(GArray *array, unsigned int length)
+{
+    size_t needed = length;
+
+    if (array->_zero_terminated) {
+        needed++;
+    }
+
+    if (needed > array->_allocated_elements) {
+        _g_array_set_capacity(array, (unsigned int) needed);
+    }
+
+    return array;
+}
+
+GArray* g_array_shrink_to_fit(GArray *array)
+{
+    unsigned int needed = array->len;
+
+    if (array->_zero_terminated) {
+        needed++;
+    }
+
+    if (needed < array->_allocated_elements) {
+        _g_array_set_capacity(array, needed);
+    }
+
+    return array;
+}
+
 void g_array_set_clear_func(GArray *array, GDestroyNotify clear_func)
 {
     array->_clear_func = clear_func;
+    array->_clear_range_func = NULL;
+}
+
+void g_array_set_clear_range_func(GArray *array, GDestroyRangeNotify clear_range_func)
+{
+    array->_clear_range_func = clear_range_func;
+    array->_clear_func = NULL;
+}
+
+void g_array_memory_usage(GArray *array, GMemUsage *usage)
+{
+    usage->allocated = sizeof(GArray) + (size_t) array->_allocated_elements * array->_element_size;
+    usage->used = (size_t) array->len * array->_element_size;
+    usage->overhead = usage->allocated - usage->used;
 }
 
 char* g_array_free(GArray *array, bool free_segment)
 {
-    char *data;
+    char *data = NULL;
 
     if (array == NULL) {
         return NULL;
     }
 
+    if (!array->_embedded) {
+        _g_mem_stats_free(G_MEM_STATS_ARRAY, sizeof(GArray));
+    }
+    if (array->data != NULL && !array->_inline) {
+        _g_mem_stats_free(G_MEM_STATS_ARRAY, (size_t) array->_allocated_elements * array->_element_size);
+    }
+
     if (free_segment == false) {
-        data = array->data;
-        free(array);
-        return data;
+        data = _g_array_steal_data(array);
+    } else {
+        _g_array_clear_elements(array, 0, array->len);
+
+        if (array->_fd >= 0) {
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+            _g_array_file_close(array);
+#endif
+        } else if (!array->_inline) {
+            _g_mem_buffer_free(array->data, (size_t) array->_allocated_elements * array->_element_size, array->_mapped);
+        }
+    }
+
+    // a G_ARRAY_SMALL is owned by the caller
+    if (array->_embedded) {
+        array->data = NULL;
+        array->len = 0;
+        array->_allocated_elements = 0;
+        array->_mapped = false;
+        array->_inline = false;
+    } else {
+        g_free(array);
+    }
+
+    return data;
+}
+
+/*
+ * Search index
+ *
+ * The elements are stored in the order of a breadth-first traversal of the
+ * implicit binary search tree (Eytzinger layout): the children of element k
+ * are 2k and 2k + 1. The first levels of the tree share a few cache lines and
+ * the descendants four levels down are contiguous, so they can be prefetched
+ * while the current level is compared. Each step is one comparison without a
+ * branch on its result.
+ */
+unsigned int _g_array_log2(size_t n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int) (sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(n));
+#else
+    unsigned int log = 0;
+
+    while (n >>= 1) {
+        log++;
+    }
+
+    return log;
+#endif
+}
+
+// Position in the sorted array of tree element k. This is computed instead of
+// stored to save a cache miss per search: in a perfect tree with one more
+// level the in-order position follows from the depth and the offset within
+// the level, then the missing leaves of the last level that come before it
+// are subtracted.
+unsigned int _g_array_search_index_position(GArraySearchIndex *index, size_t k)
+{
+    unsigned int depth = _g_array_log2(k);
+    size_t offset = k - ((size_t) 1 << depth);
+    size_t pos = ((2 * offset + 1) << (index->_full_levels - depth)) - 1;
+    size_t leaves_before = (pos + 1) / 2;
+
+    if (leaves_before > index->_last_level_len) {
+        pos -= leaves_before - index->_last_level_len;
+    }
+
+    return (unsigned int) pos;
+}
+
+unsigned int _g_array_search_index_build(GArraySearchIndex *index, const char *sorted, unsigned int i, size_t k)
+{
+    unsigned int es = index->_element_size;
+
+    if (k > index->len) {
+        return i;
     }
 
-    if (array->_clear_func != NULL) {
-        for (int i = 0; i < array->len; i++) {
-            array->_clear_func(&array->data[i]);
+    i = _g_array_search_index_build(index, sorted, i, 2 * k);
+    memcpy(&index->data[k * es], &sorted[(size_t) i * es], es);
+    i++;
+
+    return _g_array_search_index_build(index, sorted, i, 2 * k + 1);
+}
+
+GArraySearchIndex* g_array_search_index_new(GArray *array, GCompareFunc compare_func)
+{
+    GArraySearchIndex *index;
+    size_t data_size = ((size_t) array->len + 1) * array->_element_size;
+
+    index = g_malloc(sizeof(GArraySearchIndex));
+    index->len = array->len;
+    index->_element_size = array->_element_size;
+    index->_compare_func = compare_func;
+    index->_full_levels = _g_array_log2((size_t) array->len + 1);
+    index->_last_level_len = array->len - (((size_t) 1 << index->_full_levels) - 1);
+    index->data = g_malloc(data_size);
+
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, sizeof(GArraySearchIndex));
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, data_size);
+
+    _g_array_search_index_build(index, array->data, 0, 1);
+
+    return index;
+}
+
+// Descends the tree and returns the first position for which
+// compare(element, target) < upper is false
+unsigned int _g_array_search_index_find(GArraySearchIndex *index, const void *target, int upper)
+{
+    unsigned int es = index->_element_size;
+    size_t len = index->len;
+    size_t k = 1;
+
+    while (k <= len) {
+        // the 16 descendants four levels down are next to each other
+        if (k * 16 <= len) {
+            _G_ARRAY_PREFETCH(&index->data[k * 16 * es]);
         }
+
+        k = 2 * k + (index->_compare_func(&index->data[k * es], target) < upper);
+    }
+
+    // the last left turn led to the result: strip the trailing right turns
+    // and that left turn
+    while (k & 1) {
+        k >>= 1;
     }
+    k >>= 1;
 
-    free(array->data);
-    free(array);
+    return k == 0 ? index->len : _g_array_search_index_position(index, k);
+}
 
-    return NULL;
+unsigned int g_array_search_index_lower_bound(GArraySearchIndex *index, const void *target)
+{
+    return _g_array_search_index_find(index, target, 0);
+}
+
+unsigned int g_array_search_index_upper_bound(GArraySearchIndex *index, const void *target)
+{
+    return _g_array_search_index_find(index, target, 1);
+}
+
+bool g_array_search_index_equal_range(GArraySearchIndex *index, const void *target, unsigned int *out_begin, unsigned int *out_end)
+{
+    unsigned int begin = _g_array_search_index_find(index, target, 0);
+    unsigned int end = _g_array_search_index_find(index, target, 1);
+
+    if (out_begin) {
+        *out_begin = begin;
+    }
+
+    if (out_end) {
+        *out_end = end;
+    }
+
+    return begin < end;
+}
+
+void g_array_search_index_free(GArraySearchIndex *index)
+{
+    if (index == NULL) {
+        return;
+    }
+
+    _g_mem_stats_free(G_MEM_STATS_ARRAY, ((size_t) index->len + 1) * index->_element_size);
+    _g_mem_stats_free(G_MEM_STATS_ARRAY, sizeof(GArraySearchIndex));
+
+    g_free(index->data);
+    g_free(index);
+}
+
+/*
+ * K-way merge
+ *
+ * The heads of the k arrays play a tournament in a loser tree: leaf i is
+ * array i, and every inner node keeps the loser of the match played there
+ * while the winner moves up. After the overall winner is taken, only the
+ * matches on the path from its leaf to the root are played again, so each
+ * element costs log2(k) comparisons, and, unlike a heap, each of them against
+ * a single stored node. Equal elements are taken from the array with the
+ * lower index first, so the merge is stable.
+ */
+size_t _g_array_merger_size(unsigned int k)
+{
+    return sizeof(GArrayMerger) + (size_t) k * (sizeof(GArray*) + 2 * sizeof(char*) + sizeof(unsigned int));
+}
+
+// True if the head of array x must be returned before the head of array y.
+// Used up arrays lose every match.
+bool _g_array_merger_less(GArrayMerger *merger, unsigned int x, unsigned int y)
+{
+    const char *a = merger->_heads[x];
+    const char *b = merger->_heads[y];
+    int cmp;
+
+    if (a == NULL || b == NULL) {
+        return b == NULL && a != NULL;
+    }
+
+    cmp = merger->_compare_func(a, b);
+
+    return cmp < 0 || (cmp == 0 && x < y);
+}
+
+GArrayMerger* g_array_merger_new(GArray **arrays, unsigned int k, GCompareFunc compare_func)
+{
+    GArrayMerger *merger;
+    unsigned int *winners;
+    size_t remaining = 0;
+
+    if (k == 0) {
+        fprintf(stderr, "Critical: g_array_merger_new: no arrays to merge\n");
+        return NULL;
+    }
+
+    for (unsigned int i = 0; i < k; i++) {
+        if (arrays[i]->_element_size != arrays[0]->_element_size) {
+            fprintf(stderr, "Critical: g_array_merger_new: element size of array %u is %u instead of %u\n", i,
+                arrays[i]->_element_size, arrays[0]->_element_size);
+            return NULL;
+        }
+
+        remaining += arrays[i]->len;
+    }
+
+    merger = g_malloc(_g_array_merger_size(k));
+    merger->arrays = (GArray**) (merger + 1);
+    merger->k = k;
+    merger->remaining = remaining;
+    merger->_element_size = arrays[0]->_element_size;
+    merger->_heads = (const char**) (merger->arrays + k);
+    merger->_ends = merger->_heads + k;
+    merger->_tree = (unsigned int*) (merger->_ends + k);
+    merger->_compare_func = compare_func;
+
+    _g_mem_stats_alloc(G_MEM_STATS_ARRAY, _g_array_merger_size(k));
+
+    memcpy(merger->arrays, arrays, k * sizeof(GArray*));
+    for (unsigned int i = 0; i < k; i++) {
+        merger->_heads[i] = arrays[i]->len > 0 ? arrays[i]->data : NULL;
+        merger->_ends[i] = &arrays[i]->data[(size_t) arrays[i]->len * merger->_element_size];
+    }
+
+    // nodes 1 to k - 1 are the matches and k to 2k - 1 the leaves, the
+    // winners of the matches are only needed while the tree is built
+    winners = g_malloc(2 * (size_t) k * sizeof(unsigned int));
+    for (unsigned int i = 0; i < k; i++) {
+        winners[k + i] = i;
+    }
+
+    for (unsigned int node = k - 1; node >= 1; node--) {
+        unsigned int left = winners[2 * node];
+        unsigned int right = winners[2 * node + 1];
+        bool left_wins = !_g_array_merger_less(merger, right, left);
+
+        winners[node] = left_wins ? left : right;
+        merger->_tree[node] = left_wins ? right : left;
+    }
+
+    merger->_tree[0] = k == 1 ? 0 : winners[1];
+    g_free(winners);
+
+    return merger;
+}
+
+unsigned int g_array_merger_next(GArrayMerger *merger, void *buffer, unsigned int max_elements)
+{
+    unsigned int es = merger->_element_size;
+    unsigned int *tree = merger->_tree;
+    const char **heads = merger->_heads;
+    unsigned int n = 0;
+
+    while (n < max_elements && merger->remaining > 0) {
+        unsigned int winner = tree[0];
+        const char *head = heads[winner];
+
+        memcpy((char*) buffer + (size_t) n * es, head, es);
+        head += es;
+        if (head == merger->_ends[winner]) {
+            head = NULL;
+        }
+        heads[winner] = head;
+        merger->remaining--;
+        n++;
+
+        // replay the matches from the leaf of the winner up to the root, the
+        // outcome is hard to predict so the swap is done with masks instead
+        // of branches
+        for (unsigned int node = (winner + merger->k) / 2; node >= 1; node /= 2) {
+            unsigned int other = tree[node];
+            const char *other_head = heads[other];
+            unsigned int swap;
+            unsigned int mask;
+
+            if (head == NULL || other_head == NULL) {
+                swap = head == NULL && other_head != NULL;
+            } else {
+                int cmp = merger->_compare_func(other_head, head);
+                swap = (unsigned int) (cmp < 0) | ((unsigned int) (cmp == 0) & (unsigned int) (other < winner));
+            }
+
+            mask = 0u - swap;
+            tree[node] = other ^ ((other ^ winner) & mask);
+            winner ^= (winner ^ other) & mask;
+            head = (const char*) ((uintptr_t) head ^ (((uintptr_t) head ^ (uintptr_t) other_head) & (0 - (uintptr_t) swap)));
+        }
+
+        tree[0] = winner;
+    }
+
+    return n;
+}
+
+void g_array_merger_free(GArrayMerger *merger)
+{
+    if (merger == NULL) {
+        return;
+    }
+
+    _g_mem_stats_free(G_MEM_STATS_ARRAY, _g_array_merger_size(merger->k));
+    g_free(merger);
+}
+
+GArray* g_array_merge_k(GArray **arrays, unsigned int k, GCompareFunc compare_func)
+{
+    GArrayMerger *merger = g_array_merger_new(arrays, k, compare_func);
+    GArray *result;
+
+    if (merger == NULL) {
+        return NULL;
+    }
+
+    if (merger->remaining >= UINT_MAX) {
+        fprintf(stderr, "Critical: g_array_merge_k: the result would have more than %u elements\n", UINT_MAX - 1);
+        g_array_merger_free(merger);
+        return NULL;
+    }
+
+    result = g_array_sized_new(arrays[0]->_zero_terminated, arrays[0]->_clear, merger->_element_size,
+        (unsigned int) merger->remaining);
+    _g_array_filter_finish(result, g_array_merger_next(merger, result->data, (unsigned int) merger->remaining));
+    g_array_merger_free(merger);
+
+    return result;
+}
+
+/*
+ * Views
+ *
+ * The functions for views put the view into a GArray on the stack that
+ * doesn't own its data and call the function for arrays, so nothing is copied.
+ */
+GArrayView g_array_view(GArray *array, unsigned int index, unsigned int len)
+{
+    GArrayView view = {array->data, 0, array->_element_size};
+
+    if (index > array->len || len > array->len - index) {
+        fprintf(stderr, "Critical: g_array_view: elements %u to %u are outside of the array of length %u\n",
+            index, index + len, array->len);
+        return view;
+    }
+
+    view.data = &array->data[(size_t) index * array->_element_size];
+    view.len = len;
+
+    return view;
+}
+
+GArrayView g_array_view_slice(GArrayView view, unsigned int index, unsigned int len)
+{
+    GArrayView slice = {view.data, 0, view.element_size};
+
+    if (index > view.len || len > view.len - index) {
+        fprintf(stderr, "Critical: g_array_view_slice: elements %u to %u are outside of the view of length %u\n",
+            index, index + len, view.len);
+        return slice;
+    }
+
+    slice.data = &view.data[(size_t) index * view.element_size];
+    slice.len = len;
+
+    return slice;
+}
+
+GArray* g_array_view_copy(GArrayView view)
+{
+    GArray *copy = g_array_sized_new(false, false, view.element_size, view.len);
+
+    return g_array_append_vals(copy, view.data, view.len);
+}
+
+void g_array_view_sort(GArrayView view, GCompareFunc compare_func)
+{
+    GArray array;
+
+    g_array_sort(_g_array_view_header(&array, view), compare_func);
+}
+
+void g_array_view_sort_with_data(GArrayView view, GCompareDataFunc compare_func, void *user_data)
+{
+    GArray array;
+
+    g_array_sort_with_data(_g_array_view_header(&array, view), compare_func, user_data);
+}
+
+void g_array_view_stable_sort(GArrayView view, GCompareFunc compare_func)
+{
+    GArray array;
+
+    g_array_stable_sort(_g_array_view_header(&array, view), compare_func);
+}
+
+bool g_array_view_binary_search(GArrayView view, const void *target, GCompareFunc compare_func, unsigned int *out_match_index)
+{
+    GArray array;
+
+    return g_array_binary_search(_g_array_view_header(&array, view), target, compare_func, out_match_index);
+}
+
+unsigned int g_array_view_lower_bound(GArrayView view, const void *target, GCompareFunc compare_func)
+{
+    GArray array;
+
+    return g_array_lower_bound(_g_array_view_header(&array, view), target, compare_func);
+}
+
+unsigned int g_array_view_upper_bound(GArrayView view, const void *target, GCompareFunc compare_func)
+{
+    GArray array;
+
+    return g_array_upper_bound(_g_array_view_header(&array, view), target, compare_func);
+}
+
+bool g_array_view_find_u32(GArrayView view, uint32_t target, unsigned int *out_index)
+{
+    GArray array;
+
+    return g_array_find_u32(_g_array_view_header(&array, view), target, out_index);
+}
+
+bool g_array_view_find_u64(GArrayView view, uint64_t target, unsigned int *out_index)
+{
+    GArray array;
+
+    return g_array_find_u64(_g_array_view_header(&array, view), target, out_index);
+}
+
+bool g_array_view_find_f32(GArrayView view, float target, unsigned int *out_index)
+{
+    GArray array;
+
+    return g_array_find_f32(_g_array_view_header(&array, view), target, out_index);
+}
+
+GArray* g_array_view_sorted_intersect(GArrayView a, GArrayView b, GCompareFunc compare_func)
+{
+    GArray array_a;
+    GArray array_b;
+
+    return _g_array_sorted_set_op(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b), compare_func,
+        _G_ARRAY_SET_INTERSECT, "g_array_view_sorted_intersect");
+}
+
+GArray* g_array_view_sorted_union(GArrayView a, GArrayView b, GCompareFunc compare_func)
+{
+    GArray array_a;
+    GArray array_b;
+
+    return _g_array_sorted_set_op(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b), compare_func,
+        _G_ARRAY_SET_UNION, "g_array_view_sorted_union");
+}
+
+GArray* g_array_view_sorted_difference(GArrayView a, GArrayView b, GCompareFunc compare_func)
+{
+    GArray array_a;
+    GArray array_b;
+
+    return _g_array_sorted_set_op(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b), compare_func,
+        _G_ARRAY_SET_DIFFERENCE, "g_array_view_sorted_difference");
+}
+
+GArray* g_array_view_sorted_merge(GArrayView a, GArrayView b, GCompareFunc compare_func)
+{
+    GArray array_a;
+    GArray array_b;
+
+    return _g_array_sorted_set_op(_g_array_view_header(&array_a, a), _g_array_view_header(&array_b, b), compare_func,
+        _G_ARRAY_SET_MERGE, "g_array_view_sorted_merge");
 }
 
 #endif
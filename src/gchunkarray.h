@@ -0,0 +1,259 @@
+/*
+ * GChunkArray
+ *
+ * Copyright (c) 2023 Andreas Heck <aheck@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * GChunkArray is an array of fixed size elements that is stored in chunks of
+ * equal size instead of one contiguous buffer. It grows by allocating new
+ * chunks, so existing elements are never copied and pointers to them stay valid
+ * until the element is removed. Only the chunk directory, one pointer per
+ * chunk, is reallocated.
+ *
+ * The number of elements per chunk is a power of two, so accessing an element
+ * by its index is O(1). g_chunk_array_to_array() copies the elements into a
+ * contiguous GArray if one is needed.
+ */
+
+#ifndef _GCHUNKARRAY_H
+#define _GCHUNKARRAY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "gmem.h"
+#include "garray.h"
+
+// Chunk size in bytes if no number of elements per chunk is given
+#ifndef GCHUNKARRAY_CHUNK_BYTES
+#define GCHUNKARRAY_CHUNK_BYTES 65536
+#endif
+
+typedef struct GChunkArray {
+    char **chunks;
+    unsigned int len;
+    unsigned int _num_chunks;
+    unsigned int _allocated_chunks;
+    unsigned int _element_size;
+    unsigned int _chunk_shift; // log2 of the elements per chunk
+    unsigned int _chunk_mask; // elements per chunk - 1
+    GDestroyNotify _clear_func;
+} GChunkArray;
+
+GChunkArray* g_chunk_array_new(unsigned int element_size);
+GChunkArray* g_chunk_array_sized_new(unsigned int element_size, unsigned int chunk_elements);
+#define g_chunk_array_append_val(a, v) g_chunk_array_append_vals(a, &v, 1)
+GChunkArray* g_chunk_array_append_vals(GChunkArray *array, const void *data, unsigned int len);
+#define g_chunk_array_index(a, t, i) (((t*) (a)->chunks[(i) >> (a)->_chunk_shift])[(i) & (a)->_chunk_mask])
+void* g_chunk_array_index_ptr(GChunkArray *array, unsigned int index);
+GChunkArray* g_chunk_array_truncate(GChunkArray *array, unsigned int length);
+GArray* g_chunk_array_to_array(GChunkArray *array);
+void g_chunk_array_set_clear_func(GChunkArray *array, GDestroyNotify clear_func);
+void g_chunk_array_memory_usage(GChunkArray *array, GMemUsage *usage);
+void g_chunk_array_free(GChunkArray *array);
+
+#ifdef _CLIB_IMPL
+size_t _g_chunk_array_chunk_bytes(GChunkArray *array)
+{
+    return ((size_t) array->_chunk_mask + 1) * array->_element_size;
+}
+
+GChunkArray* g_chunk_array_new(unsigned int element_size)
+{
+    return g_chunk_array_sized_new(element_size, 0);
+}
+
+GChunkArray* g_chunk_array_sized_new(unsigned int element_size, unsigned int chunk_elements)
+{
+    GChunkArray *array;
+    unsigned int shift = 0;
+
+    if (element_size == 0) {
+        fprintf(stderr, "Critical: g_chunk_array_sized_new: element size is 0\n");
+        return NULL;
+    }
+
+    if (chunk_elements == 0) {
+        chunk_elements = GCHUNKARRAY_CHUNK_BYTES / element_size;
+    }
+
+    // round up to a power of two
+    while (shift < 31 && (1u << shift) < chunk_elements) {
+        shift++;
+    }
+
+    array = g_malloc(sizeof(GChunkArray));
+    _g_mem_stats_alloc(G_MEM_STATS_CHUNK_ARRAY, sizeof(GChunkArray));
+
+    array->chunks = NULL;
+    array->len = 0;
+    array->_num_chunks = 0;
+    array->_allocated_chunks = 0;
+    array->_element_size = element_size;
+    array->_chunk_shift = shift;
+    array->_chunk_mask = (1u << shift) - 1;
+    array->_clear_func = NULL;
+
+    return array;
+}
+
+void _g_chunk_array_add_chunk(GChunkArray *array)
+{
+    size_t chunk_bytes = _g_chunk_array_chunk_bytes(array);
+
+    if (array->_num_chunks == array->_allocated_chunks) {
+        unsigned int allocated = array->_allocated_chunks ? array->_allocated_chunks * 2 : 8;
+
+        if (array->chunks == NULL) {
+            _g_mem_stats_alloc(G_MEM_STATS_CHUNK_ARRAY, allocated * sizeof(char*));
+        } else {
+            _g_mem_stats_realloc(G_MEM_STATS_CHUNK_ARRAY, array->_allocated_chunks * sizeof(char*), allocated * sizeof(char*));
+        }
+
+        array->chunks = g_realloc(array->chunks, allocated * sizeof(char*));
+        array->_allocated_chunks = allocated;
+    }
+
+    array->chunks[array->_num_chunks++] = g_malloc(chunk_bytes);
+    _g_mem_stats_alloc(G_MEM_STATS_CHUNK_ARRAY, chunk_bytes);
+}
+
+GChunkArray* g_chunk_array_append_vals(GChunkArray *array, const void *data, unsigned int len)
+{
+    unsigned int es = array->_element_size;
+    unsigned int chunk_elements = array->_chunk_mask + 1;
+    const char *src = data;
+
+    // fast path for appending single elements to a chunk that has room
+    if (len == 1 && (array->len & array->_chunk_mask) != 0) {
+        memcpy(&array->chunks[array->len >> array->_chunk_shift][(size_t) (array->len & array->_chunk_mask) * es], data, es);
+        array->len++;
+        return array;
+    }
+
+    while (len > 0) {
+        unsigned int offset = array->len & array->_chunk_mask;
+        unsigned int n = chunk_elements - offset;
+
+        if ((array->len >> array->_chunk_shift) == array->_num_chunks) {
+            _g_chunk_array_add_chunk(array);
+        }
+
+        if (n > len) {
+            n = len;
+        }
+
+        memcpy(&array->chunks[array->len >> array->_chunk_shift][(size_t) offset * es], src, (size_t) n * es);
+
+        src += (size_t) n * es;
+        array->len += n;
+        len -= n;
+    }
+
+    return array;
+}
+
+void* g_chunk_array_index_ptr(GChunkArray *array, unsigned int index)
+{
+    return &array->chunks[index >> array->_chunk_shift][(size_t) (index & array->_chunk_mask) * array->_element_size];
+}
+
+GChunkArray* g_chunk_array_truncate(GChunkArray *array, unsigned int length)
+{
+    unsigned int num_chunks;
+
+    if (length >= array->len) {
+        return array;
+    }
+
+    if (array->_clear_func) {
+        for (unsigned int i = length; i < array->len; i++) {
+            array->_clear_func(g_chunk_array_index_ptr(array, i));
+        }
+    }
+
+    // release the chunks that don't hold elements anymore
+    num_chunks = (length + array->_chunk_mask) >> array->_chunk_shift;
+    while (array->_num_chunks > num_chunks) {
+        array->_num_chunks--;
+        g_free(array->chunks[array->_num_chunks]);
+        _g_mem_stats_free(G_MEM_STATS_CHUNK_ARRAY, _g_chunk_array_chunk_bytes(array));
+    }
+
+    array->len = length;
+
+    return array;
+}
+
+GArray* g_chunk_array_to_array(GChunkArray *array)
+{
+    GArray *result = g_array_sized_new(false, false, array->_element_size, array->len);
+    size_t chunk_elements = (size_t) array->_chunk_mask + 1;
+
+    for (unsigned int i = 0; i < array->_num_chunks; i++) {
+        size_t n = array->len - i * chunk_elements;
+
+        if (n > chunk_elements) {
+            n = chunk_elements;
+        }
+
+        g_array_append_vals(result, array->chunks[i], (unsigned int) n);
+    }
+
+    return result;
+}
+
+void g_chunk_array_set_clear_func(GChunkArray *array, GDestroyNotify clear_func)
+{
+    array->_clear_func = clear_func;
+}
+
+void g_chunk_array_memory_usage(GChunkArray *array, GMemUsage *usage)
+{
+    usage->allocated = sizeof(GChunkArray) + array->_allocated_chunks * sizeof(char*) +
+        array->_num_chunks * _g_chunk_array_chunk_bytes(array);
+    usage->used = (size_t) array->len * array->_element_size;
+    usage->overhead = usage->allocated - usage->used;
+}
+
+void g_chunk_array_free(GChunkArray *array)
+{
+    if (array == NULL) {
+        return;
+    }
+
+    g_chunk_array_truncate(array, 0);
+
+    if (array->chunks != NULL) {
+        _g_mem_stats_free(G_MEM_STATS_CHUNK_ARRAY, array->_allocated_chunks * sizeof(char*));
+    }
+    _g_mem_stats_free(G_MEM_STATS_CHUNK_ARRAY, sizeof(GChunkArray));
+
+    g_free(array->chunks);
+    g_free(array);
+}
+
+#endif
+#endif
@@ -0,0 +1,270 @@
+/*
+ * GColumnArray
+ *
+ * Copyright (c) 2023 Andreas Heck <aheck@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * GColumnArray stores records column by column: every field of the records
+ * is a GArray of its own and all columns always have the same length. Code
+ * that only looks at one or two fields reads them sequentially instead of
+ * pulling whole records through the cache.
+ *
+ * Sorting by a column sorts a permutation of the row indices and applies it
+ * to all columns. The sort is stable, so sorting by several columns one after
+ * the other sorts by all of them with the last one as primary key.
+ */
+
+#ifndef _GCOLUMNARRAY_H
+#define _GCOLUMNARRAY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "gmem.h"
+#include "garray.h"
+
+typedef struct GColumnArray {
+    GArray **columns;
+    unsigned int len;
+    unsigned int num_columns;
+} GColumnArray;
+
+GColumnArray* g_column_array_new(unsigned int num_columns, const unsigned int *element_sizes);
+GColumnArray* g_column_array_sized_new(unsigned int num_columns, const unsigned int *element_sizes, unsigned int reserved_size);
+GArray* g_column_array_get_column(GColumnArray *array, unsigned int column);
+#define g_column_array_index(a, column, t, i) (((t*) (a)->columns[column]->data)[i])
+GColumnArray* g_column_array_append_row(GColumnArray *array, const void * const *values);
+GColumnArray* g_column_array_remove_row(GColumnArray *array, unsigned int index);
+GColumnArray* g_column_array_remove_row_fast(GColumnArray *array, unsigned int index);
+GColumnArray* g_column_array_remove_range(GColumnArray *array, unsigned int index, unsigned int length);
+GColumnArray* g_column_array_set_size(GColumnArray *array, unsigned int length);
+GColumnArray* g_column_array_reserve(GColumnArray *array, unsigned int length);
+void g_column_array_sort_by_column(GColumnArray *array, unsigned int column, GCompareFunc compare_func);
+void g_column_array_sort_by_column_with_data(GColumnArray *array, unsigned int column, GCompareDataFunc compare_func, void *user_data);
+void g_column_array_memory_usage(GColumnArray *array, GMemUsage *usage);
+void g_column_array_free(GColumnArray *array);
+
+#ifdef _CLIB_IMPL
+GColumnArray* g_column_array_new(unsigned int num_columns, const unsigned int *element_sizes)
+{
+    return g_column_array_sized_new(num_columns, element_sizes, 0);
+}
+
+GColumnArray* g_column_array_sized_new(unsigned int num_columns, const unsigned int *element_sizes, unsigned int reserved_size)
+{
+    GColumnArray *array;
+
+    array = g_malloc(sizeof(GColumnArray));
+    array->columns = g_malloc(sizeof(GArray*) * num_columns);
+    _g_mem_stats_alloc(G_MEM_STATS_COLUMN_ARRAY, sizeof(GColumnArray));
+    _g_mem_stats_alloc(G_MEM_STATS_COLUMN_ARRAY, sizeof(GArray*) * num_columns);
+
+    array->len = 0;
+    array->num_columns = num_columns;
+
+    for (unsigned int i = 0; i < num_columns; i++) {
+        array->columns[i] = g_array_sized_new(false, false, element_sizes[i], reserved_size);
+    }
+
+    return array;
+}
+
+GArray* g_column_array_get_column(GColumnArray *array, unsigned int column)
+{
+    return array->columns[column];
+}
+
+GColumnArray* g_column_array_append_row(GColumnArray *array, const void * const *values)
+{
+    for (unsigned int i = 0; i < array->num_columns; i++) {
+        g_array_append_vals(array->columns[i], values[i], 1);
+    }
+
+    array->len++;
+
+    return array;
+}
+
+GColumnArray* g_column_array_remove_row(GColumnArray *array, unsigned int index)
+{
+    return g_column_array_remove_range(array, index, 1);
+}
+
+GColumnArray* g_column_array_remove_row_fast(GColumnArray *array, unsigned int index)
+{
+    for (unsigned int i = 0; i < array->num_columns; i++) {
+        g_array_remove_index_fast(array->columns[i], index);
+    }
+
+    array->len--;
+
+    return array;
+}
+
+GColumnArray* g_column_array_remove_range(GColumnArray *array, unsigned int index, unsigned int length)
+{
+    for (unsigned int i = 0; i < array->num_columns; i++) {
+        g_array_remove_range(array->columns[i], index, length);
+    }
+
+    array->len -= length;
+
+    return array;
+}
+
+GColumnArray* g_column_array_set_size(GColumnArray *array, unsigned int length)
+{
+    for (unsigned int i = 0; i < array->num_columns; i++) {
+        g_array_set_size(array->columns[i], length);
+    }
+
+    array->len = length;
+
+    return array;
+}
+
+GColumnArray* g_column_array_reserve(GColumnArray *array, unsigned int length)
+{
+    for (unsigned int i = 0; i < array->num_columns; i++) {
+        g_array_reserve(array->columns[i], length);
+    }
+
+    return array;
+}
+
+struct _g_column_array_sort {
+    const char *column_data;
+    unsigned int element_size;
+    GCompareFunc compare_func;
+    GCompareDataFunc compare_data_func;
+    void *user_data;
+};
+
+int _g_column_array_compare_rows(const void *a, const void *b, void *user_data)
+{
+    struct _g_column_array_sort *sort = user_data;
+    const char *x = sort->column_data + (size_t) *(const unsigned int*) a * sort->element_size;
+    const char *y = sort->column_data + (size_t) *(const unsigned int*) b * sort->element_size;
+
+    if (sort->compare_func) {
+        return sort->compare_func(x, y);
+    }
+
+    return sort->compare_data_func(x, y, sort->user_data);
+}
+
+void _g_column_array_sort(GColumnArray *array, unsigned int column, struct _g_column_array_sort *sort)
+{
+    GArray *permutation;
+    unsigned int *rows;
+    char *buffer = NULL;
+    size_t buffer_size = 0;
+
+    if (array->len < 2) {
+        return;
+    }
+
+    permutation = g_array_sized_new(false, false, sizeof(unsigned int), array->len);
+    g_array_set_size(permutation, array->len);
+    rows = (unsigned int*) permutation->data;
+    for (unsigned int i = 0; i < array->len; i++) {
+        rows[i] = i;
+    }
+
+    sort->column_data = array->columns[column]->data;
+    sort->element_size = array->columns[column]->_element_size;
+    g_array_stable_sort_with_data(permutation, _g_column_array_compare_rows, sort);
+
+    // gather every column in the new order and copy it back
+    for (unsigned int c = 0; c < array->num_columns; c++) {
+        GArray *col = array->columns[c];
+        size_t es = col->_element_size;
+
+        if (buffer_size < array->len * es) {
+            g_free(buffer);
+            buffer_size = array->len * es;
+            buffer = g_malloc(buffer_size);
+        }
+
+        for (unsigned int i = 0; i < array->len; i++) {
+            memcpy(&buffer[i * es], &col->data[rows[i] * es], es);
+        }
+
+        memcpy(col->data, buffer, array->len * es);
+    }
+
+    g_free(buffer);
+    g_array_free(permutation, true);
+}
+
+void g_column_array_sort_by_column(GColumnArray *array, unsigned int column, GCompareFunc compare_func)
+{
+    struct _g_column_array_sort sort = {NULL, 0, compare_func, NULL, NULL};
+
+    _g_column_array_sort(array, column, &sort);
+}
+
+void g_column_array_sort_by_column_with_data(GColumnArray *array, unsigned int column, GCompareDataFunc compare_func, void *user_data)
+{
+    struct _g_column_array_sort sort = {NULL, 0, NULL, compare_func, user_data};
+
+    _g_column_array_sort(array, column, &sort);
+}
+
+void g_column_array_memory_usage(GColumnArray *array, GMemUsage *usage)
+{
+    GMemUsage column_usage;
+
+    usage->allocated = sizeof(GColumnArray) + sizeof(GArray*) * array->num_columns;
+    usage->used = 0;
+
+    for (unsigned int i = 0; i < array->num_columns; i++) {
+        g_array_memory_usage(array->columns[i], &column_usage);
+        usage->allocated += column_usage.allocated;
+        usage->used += column_usage.used;
+    }
+
+    usage->overhead = usage->allocated - usage->used;
+}
+
+void g_column_array_free(GColumnArray *array)
+{
+    if (array == NULL) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < array->num_columns; i++) {
+        g_array_free(array->columns[i], true);
+    }
+
+    _g_mem_stats_free(G_MEM_STATS_COLUMN_ARRAY, sizeof(GArray*) * array->num_columns);
+    _g_mem_stats_free(G_MEM_STATS_COLUMN_ARRAY, sizeof(GColumnArray));
+
+    g_free(array->columns);
+    g_free(array);
+}
+
+#endif
+#endif
@@ -31,6 +31,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "gmem.h"
+
 #define GHASHTABLE_MIN_SLOTS 64
 #define GHASHTABLE_MAX_LOAD 0.5
 
@@ -69,6 +71,7 @@ uint32_t g_hash_table_size(GHashTable *hash_table);
 void* g_hash_table_lookup(GHashTable *hash_table, void *key);
 void g_hash_table_foreach(GHashTable *hash_table, GHFunc func, void *user_data);
 bool g_hash_table_remove(GHashTable *hash_table, void *key);
+void g_hash_table_memory_usage(GHashTable *hash_table, GMemUsage *usage);
 void g_hash_table_destroy(GHashTable *hash_table);
 
 
@@ -119,11 +122,7 @@ GHashTable *g_hash_table_new(GHashFunc hash_func, GEqualFunc key_equal_func)
         return NULL;
     }
 
-    GHashTable *hash_table = (GHashTable*) malloc(sizeof(GHashTable));
-    if (hash_table == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_hash_table_new: Out of memory");
-        exit(1);
-    }
+    GHashTable *hash_table = (GHashTable*) g_malloc(sizeof(GHashTable));
 
     hash_table->num_slots = GHASHTABLE_MIN_SLOTS;
     hash_table->num_used = 0;
@@ -134,13 +133,10 @@ GHashTable *g_hash_table_new(GHashFunc hash_func, GEqualFunc key_equal_func)
     hash_table->value_destroy_func = NULL;
 
     size_t buf_size = hash_table->num_slots * sizeof(struct GHashTableSlot);
-    hash_table->slots = malloc(buf_size);
-    if (hash_table->slots == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_hash_table_new: Out of memory");
-        exit(1);
-    }
+    hash_table->slots = g_malloc0(buf_size);
 
-    memset(hash_table->slots, 0, buf_size);
+    _g_mem_stats_alloc(G_MEM_STATS_HASH_TABLE, sizeof(GHashTable));
+    _g_mem_stats_alloc(G_MEM_STATS_HASH_TABLE, buf_size);
 
     return hash_table;
 }
@@ -230,26 +226,23 @@ void _g_hash_table_resize(GHashTable *hash_table, uint32_t new_num_slots)
     struct GHashTableSlot *new_slots;
 
     size_t buf_size = new_num_slots * sizeof(struct GHashTableSlot);
-    new_slots = malloc(buf_size);
-    if (new_slots == NULL) {
-        fprintf(stderr, "FATAL ERROR: _g_hash_table_resize: Out of memory");
-        exit(1);
-    }
+    new_slots = g_malloc0(buf_size);
+
+    _g_mem_stats_alloc(G_MEM_STATS_HASH_TABLE, buf_size);
 
     hash_table->slots = new_slots;
     hash_table->num_used = 0;
     hash_table->num_slots = new_num_slots;
     hash_table->resize_threshold = (uint32_t) (hash_table->num_slots * GHASHTABLE_MAX_LOAD);
 
-    memset(hash_table->slots, 0, buf_size);
-
     for (uint32_t i = 0; i < old_num_slots; i++) {
         if (old_slots[i].used) {
             g_hash_table_insert(hash_table, old_slots[i].key, old_slots[i].value);
         }
     }
 
-    free(old_slots);
+    g_free(old_slots);
+    _g_mem_stats_free(G_MEM_STATS_HASH_TABLE, old_num_slots * sizeof(struct GHashTableSlot));
 }
 
 void g_hash_table_insert(GHashTable *hash_table, void *key, void *value)
@@ -343,6 +336,14 @@ bool g_hash_table_remove(GHashTable *hash_table, void *key)
     return true;
 }
 
+void g_hash_table_memory_usage(GHashTable *hash_table, GMemUsage *usage)
+{
+    usage->allocated = sizeof(GHashTable) + (size_t) hash_table->num_slots * sizeof(struct GHashTableSlot);
+    // only the key and value pointers of the used slots are payload
+    usage->used = (size_t) hash_table->num_used * 2 * sizeof(void*);
+    usage->overhead = usage->allocated - usage->used;
+}
+
 void g_hash_table_destroy(GHashTable *hash_table)
 {
     if (hash_table) {
@@ -363,9 +364,11 @@ void g_hash_table_destroy(GHashTable *hash_table)
         }
 
         if (hash_table->slots) {
-            free(hash_table->slots);
+            g_free(hash_table->slots);
+            _g_mem_stats_free(G_MEM_STATS_HASH_TABLE, (size_t) hash_table->num_slots * sizeof(struct GHashTableSlot));
         }
-        free(hash_table);
+        g_free(hash_table);
+        _g_mem_stats_free(G_MEM_STATS_HASH_TABLE, sizeof(GHashTable));
     }
 }
 
@@ -27,6 +27,8 @@
 #define _GLIST_H
 #include <math.h>
 
+#include "gmem.h"
+
 typedef int(*GCompareFunc) (const void *a, const void *b);
 typedef int(*GCompareDataFunc) (const void *a, const void *b, void *user_data);
 typedef void(*GFunc) (void *data, void *user_data);
@@ -66,6 +68,7 @@ GList* g_list_find(GList *list, const void *data);
 GList* g_list_find_custom(GList *list, const void *data, GCompareFunc func);
 int g_list_position(GList *list, GList *llink);
 int g_list_index(GList *list, const void *data);
+void g_list_memory_usage(GList *list, GMemUsage *usage);
 
 
 #ifdef _CLIB_IMPL
@@ -253,7 +256,9 @@ GList* g_list_remove(GList *list, const void *data)
                 }
             }
 
-            free(cur);
+            g_free(cur);
+            _g_mem_stats_free(G_MEM_STATS_LIST, sizeof(GList));
+
             return list;
         }
 
@@ -293,7 +298,10 @@ GList* g_list_remove_link(GList *list, GList *llink)
 GList* g_list_delete_link(GList *list, GList *link_)
 {
     list = g_list_remove_link(list, link_);
-    free(link_);
+    if (link_ != NULL) {
+        g_free(link_);
+        _g_mem_stats_free(G_MEM_STATS_LIST, sizeof(GList));
+    }
     return list;
 }
 
@@ -321,7 +329,8 @@ GList* g_list_remove_all(GList *list, const void *data)
             }
 
             next = cur->next;
-            free(cur);
+            g_free(cur);
+            _g_mem_stats_free(G_MEM_STATS_LIST, sizeof(GList));
             cur = next;
             continue;
         }
@@ -344,19 +353,17 @@ void g_list_free(GList *list)
 
     while (list != NULL) {
         next = list->next;
-        free(list);
+        g_free(list);
+        _g_mem_stats_free(G_MEM_STATS_LIST, sizeof(GList));
         list = next;
     }
 }
 
 GList* g_list_alloc()
 {
-    GList *list = (GList*) malloc(sizeof(GList));
+    GList *list = (GList*) g_malloc(sizeof(GList));
 
-    if (list == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_list_alloc: Out of memory");
-        exit(1);
-    }
+    _g_mem_stats_alloc(G_MEM_STATS_LIST, sizeof(GList));
 
     return list;
 }
@@ -365,7 +372,12 @@ GList* g_list_alloc()
 
 void g_list_free_1(GList *list)
 {
-    free(list);
+    if (list == NULL) {
+        return;
+    }
+
+    g_free(list);
+    _g_mem_stats_free(G_MEM_STATS_LIST, sizeof(GList));
 }
 
 uint32_t g_list_length(GList *list)
@@ -527,11 +539,9 @@ GList* _g_list_merge_sorted_with_data(GList *list1, GList *list2, GCompareDataFu
     }\
 \
     uint32_t buf_size = sizeof(GList*) * max_lists;\
-    GList **sorted_lists = (GList**) malloc(buf_size);\
+    GList **sorted_lists = (GList**) g_malloc(buf_size);\
 \
-    if (sorted_lists == NULL) {\
-        return list;\
-    }\
+    _g_mem_stats_alloc(G_MEM_STATS_LIST, buf_size);\
 \
     /* \
      * Set last element to NULL to "normalize" lists with an uneven number of\
@@ -582,7 +592,8 @@ GList* _g_list_merge_sorted_with_data(GList *list1, GList *list2, GCompareDataFu
     }\
 \
     GList *result = sorted_lists[0];\
-    free(sorted_lists);\
+    g_free(sorted_lists);\
+    _g_mem_stats_free(G_MEM_STATS_LIST, buf_size);\
 \
     return result;
 
@@ -737,5 +748,19 @@ int g_list_index(GList *list, const void *data)
     return -1;
 }
 
+void g_list_memory_usage(GList *list, GMemUsage *usage)
+{
+    size_t num_elements = 0;
+
+    for (list = g_list_first(list); list != NULL; list = list->next) {
+        num_elements++;
+    }
+
+    usage->allocated = num_elements * sizeof(GList);
+    // only the data pointers are payload, prev and next are overhead
+    usage->used = num_elements * sizeof(void*);
+    usage->overhead = usage->allocated - usage->used;
+}
+
 #endif
 #endif
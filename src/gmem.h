@@ -0,0 +1,654 @@
+/*
+ * GMem
+ *
+ * Copyright (c) 2023 Andreas Heck <aheck@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Memory allocation and accounting shared by all clib classes.
+ *
+ * All classes allocate through g_malloc(), g_malloc0(), g_realloc() and
+ * g_free(). Like in GLib these functions terminate the program if the memory
+ * can't be allocated and g_mem_set_vtable() replaces the allocator they call.
+ * The vtable has to be set before the first allocation and memory returned by
+ * clib (e.g. by g_array_free(array, false)) has to be released with g_free().
+ * To replace the allocator at compile time define CLIB_MALLOC, CLIB_REALLOC,
+ * CLIB_FREE and optionally CLIB_CALLOC before including any clib header.
+ *
+ * Every class provides a *_memory_usage() function that reports the memory
+ * held by one instance. If CLIB_MEM_STATS is defined before including any clib
+ * header, all classes additionally count their allocations in global per class
+ * counters that can be read with g_mem_stats_get(). Without CLIB_MEM_STATS the
+ * counting compiles to nothing.
+ *
+ * Byte counts are the sizes requested from the allocator. The allocator's own
+ * bookkeeping per block is not included.
+ *
+ * On Linux the buffers of GArray and GString that are at least
+ * GMEM_MREMAP_THRESHOLD bytes large are mapped directly with mmap() and grow
+ * with mremap(), which moves pages instead of copying their content. This is
+ * only done while the default allocator is in use and can be turned off by
+ * defining CLIB_NO_MREMAP. Such buffers are handed over to the caller as
+ * mappings, g_free() and g_realloc() recognize them.
+ */
+
+#ifndef _GMEM_H
+#define _GMEM_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef GMEM_MREMAP_THRESHOLD
+#define GMEM_MREMAP_THRESHOLD (64 * 1024 * 1024)
+#endif
+
+typedef struct GMemVTable {
+    void* (*malloc)(size_t n_bytes);
+    void* (*realloc)(void *mem, size_t n_bytes);
+    void (*free)(void *mem);
+    // optional: calloc, try_malloc and try_realloc may be NULL
+    void* (*calloc)(size_t n_blocks, size_t n_block_bytes);
+    void* (*try_malloc)(size_t n_bytes);
+    void* (*try_realloc)(void *mem, size_t n_bytes);
+} GMemVTable;
+
+typedef struct GMemUsage {
+    size_t allocated; // bytes allocated by the instance including its header
+    size_t used; // bytes holding the stored data
+    size_t overhead; // allocated - used: headers, links, unused capacity
+} GMemUsage;
+
+typedef enum GMemStatsType {
+    G_MEM_STATS_ARRAY,
+    G_MEM_STATS_HASH_TABLE,
+    G_MEM_STATS_LIST,
+    G_MEM_STATS_STRING,
+    G_MEM_STATS_QUEUE_ARRAY,
+    G_MEM_STATS_CHUNK_ARRAY,
+    G_MEM_STATS_COLUMN_ARRAY,
+    G_MEM_STATS_NUM_TYPES
+} GMemStatsType;
+
+typedef struct GMemStats {
+    size_t live_bytes;
+    uint64_t alloc_calls;
+    uint64_t realloc_calls;
+    uint64_t free_calls;
+} GMemStats;
+
+void g_mem_set_vtable(GMemVTable *vtable);
+void* g_malloc(size_t n_bytes);
+void* g_malloc0(size_t n_bytes);
+void* g_realloc(void *mem, size_t n_bytes);
+void* g_try_malloc(size_t n_bytes);
+void* g_try_realloc(void *mem, size_t n_bytes);
+void g_free(void *mem);
+void g_mem_stats_get(GMemStatsType type, GMemStats *stats);
+void g_mem_stats_reset(void);
+
+// Allocation of the data buffers of GArray and GString, *mapped tells if the
+// buffer is a mapping of its own instead of memory from the allocator
+void* _g_mem_buffer_alloc(size_t n_bytes, bool clear, bool *mapped);
+void* _g_mem_buffer_realloc(void *mem, size_t old_size, size_t new_size, bool *mapped);
+void* _g_mem_buffer_realloc0(void *mem, size_t old_size, size_t used, size_t new_size, bool *mapped);
+void* _g_mem_buffer_steal(void *mem, size_t size, size_t used, bool mapped);
+void _g_mem_buffer_free(void *mem, size_t size, bool mapped);
+
+#ifdef CLIB_MEM_STATS
+void _g_mem_stats_alloc(GMemStatsType type, size_t size);
+void _g_mem_stats_realloc(GMemStatsType type, size_t old_size, size_t new_size);
+void _g_mem_stats_free(GMemStatsType type, size_t size);
+#else
+#define _g_mem_stats_alloc(type, size) ((void) 0)
+#define _g_mem_stats_realloc(type, old_size, new_size) ((void) 0)
+#define _g_mem_stats_free(type, size) ((void) 0)
+#endif
+
+#endif
+
+// gmem.h is included by every class, so the implementation has its own guard
+// to be emitted exactly once no matter which class defines _CLIB_IMPL
+#if defined(_CLIB_IMPL) && !defined(_GMEM_IMPL)
+#define _GMEM_IMPL
+
+#if defined(__GNUC__) || defined(__clang__)
+#define _G_MEM_STATS_ADD(var, n) __atomic_fetch_add(&(var), (n), __ATOMIC_RELAXED)
+#define _G_MEM_STATS_SUB(var, n) __atomic_fetch_sub(&(var), (n), __ATOMIC_RELAXED)
+#else
+#define _G_MEM_STATS_ADD(var, n) ((var) += (n))
+#define _G_MEM_STATS_SUB(var, n) ((var) -= (n))
+#endif
+
+#if defined(__linux__) && !defined(CLIB_NO_MREMAP) && (defined(__GNUC__) || defined(__clang__))
+#include <sys/mman.h>
+#include <unistd.h>
+
+// the value differs between architectures, without it there is no mapping
+#if defined(MAP_ANONYMOUS)
+#define _G_MEM_MAP_ANONYMOUS MAP_ANONYMOUS
+#elif defined(MAP_ANON)
+#define _G_MEM_MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#ifdef _G_MEM_MAP_ANONYMOUS
+// Like qsort_r in garray.h mremap is only declared with _GNU_SOURCE which we
+// don't want to define for our users
+void *mremap(void *old_address, size_t old_size, size_t new_size, int flags, ...);
+
+#ifndef MREMAP_MAYMOVE
+#define MREMAP_MAYMOVE 1
+#endif
+
+#define _G_MEM_MREMAP
+#endif
+
+// Growing by at least this many bytes uses calloc and a copy instead of
+// realloc and memset in _g_mem_buffer_realloc0
+#define _G_MEM_CALLOC_THRESHOLD (128 * 1024)
+
+#if !defined(CLIB_MALLOC) || !defined(CLIB_REALLOC) || !defined(CLIB_FREE)
+#undef CLIB_MALLOC
+#undef CLIB_REALLOC
+#undef CLIB_FREE
+#undef CLIB_CALLOC
+#define CLIB_MALLOC malloc
+#define CLIB_REALLOC realloc
+#define CLIB_FREE free
+#define CLIB_CALLOC calloc
+#define _G_MEM_DEFAULT_ALLOCATOR true
+#endif
+
+#ifndef CLIB_CALLOC
+#define CLIB_CALLOC NULL
+#endif
+
+#ifndef _G_MEM_DEFAULT_ALLOCATOR
+#define _G_MEM_DEFAULT_ALLOCATOR false
+#endif
+
+GMemVTable _g_mem_vtable = {CLIB_MALLOC, CLIB_REALLOC, CLIB_FREE, CLIB_CALLOC, NULL, NULL};
+GMemStats _g_mem_stats[G_MEM_STATS_NUM_TYPES];
+
+// false while the allocator set at compile time or with g_mem_set_vtable()
+// is in use
+bool _g_mem_default_allocator = _G_MEM_DEFAULT_ALLOCATOR;
+
+void g_mem_set_vtable(GMemVTable *vtable)
+{
+    // back to the allocator the library was compiled with
+    if (vtable == NULL) {
+        GMemVTable compiled = {CLIB_MALLOC, CLIB_REALLOC, CLIB_FREE, CLIB_CALLOC, NULL, NULL};
+
+        memcpy(&_g_mem_vtable, &compiled, sizeof(GMemVTable));
+        _g_mem_default_allocator = _G_MEM_DEFAULT_ALLOCATOR;
+        return;
+    }
+
+    if (vtable->malloc == NULL || vtable->realloc == NULL || vtable->free == NULL) {
+        fprintf(stderr, "FATAL ERROR: g_mem_set_vtable: malloc, realloc and free are mandatory");
+        exit(1);
+    }
+
+    memcpy(&_g_mem_vtable, vtable, sizeof(GMemVTable));
+    _g_mem_default_allocator = false;
+}
+
+void _g_mem_out_of_memory(const char *func, size_t n_bytes)
+{
+    fprintf(stderr, "FATAL ERROR: %s: Failed to allocate %lu bytes", func, (unsigned long) n_bytes);
+    exit(1);
+}
+
+#ifdef _G_MEM_MREMAP
+/*
+ * Mapped buffers handed over to the caller stay mappings. They are recorded
+ * here so that g_free() and g_realloc() can tell them from allocated memory.
+ * Every mapping is at least GMEM_MREMAP_THRESHOLD bytes, so there are few of
+ * them and a list is enough. Nothing is looked up while the list is empty or
+ * for memory that doesn't start at a page, which excludes almost everything
+ * from the allocator. The lock only guards the list, the system calls are
+ * made after releasing it.
+ */
+typedef struct _GMemMapping {
+    void *mem;
+    size_t size;
+} _GMemMapping;
+
+_GMemMapping *_g_mem_mappings;
+size_t _g_mem_num_mappings;
+size_t _g_mem_mappings_capacity;
+bool _g_mem_mappings_locked;
+
+size_t _g_mem_page_size_cached;
+
+size_t _g_mem_page_size(void)
+{
+    size_t page_size = __atomic_load_n(&_g_mem_page_size_cached, __ATOMIC_RELAXED);
+
+    if (page_size == 0) {
+        page_size = (size_t) sysconf(_SC_PAGESIZE);
+        __atomic_store_n(&_g_mem_page_size_cached, page_size, __ATOMIC_RELAXED);
+    }
+
+    return page_size;
+}
+
+size_t _g_mem_page_round(size_t n_bytes)
+{
+    size_t page_size = _g_mem_page_size();
+
+    return (n_bytes + page_size - 1) & ~(page_size - 1);
+}
+
+void _g_mem_mappings_lock(void)
+{
+    while (__atomic_test_and_set(&_g_mem_mappings_locked, __ATOMIC_ACQUIRE)) {
+    }
+}
+
+void _g_mem_mappings_unlock(void)
+{
+    __atomic_clear(&_g_mem_mappings_locked, __ATOMIC_RELEASE);
+}
+
+void _g_mem_mappings_add(void *mem, size_t size)
+{
+    _g_mem_mappings_lock();
+
+    if (_g_mem_num_mappings == _g_mem_mappings_capacity) {
+        size_t capacity = _g_mem_mappings_capacity == 0 ? 8 : _g_mem_mappings_capacity * 2;
+        // not through the vtable, the list isn't memory of the caller
+        _GMemMapping *mappings = realloc(_g_mem_mappings, capacity * sizeof(_GMemMapping));
+
+        if (mappings == NULL) {
+            _g_mem_out_of_memory("_g_mem_mappings_add", capacity * sizeof(_GMemMapping));
+        }
+
+        _g_mem_mappings = mappings;
+        _g_mem_mappings_capacity = capacity;
+    }
+
+    _g_mem_mappings[_g_mem_num_mappings].mem = mem;
+    _g_mem_mappings[_g_mem_num_mappings].size = size;
+    __atomic_store_n(&_g_mem_num_mappings, _g_mem_num_mappings + 1, __ATOMIC_RELAXED);
+
+    _g_mem_mappings_unlock();
+}
+
+// Unmaps mem (n_bytes == 0) or resizes it if it is a mapping handed over to
+// the caller. Returns false for any other memory.
+bool _g_mem_mappings_realloc(void **mem, size_t n_bytes)
+{
+    _GMemMapping mapping = {NULL, 0};
+    void *new_mem;
+
+    if (__atomic_load_n(&_g_mem_num_mappings, __ATOMIC_RELAXED) == 0 ||
+            ((uintptr_t) *mem & (_g_mem_page_size() - 1)) != 0) {
+        return false;
+    }
+
+    // the entry is taken out of the list, only the caller has the memory
+    // until it is added again
+    _g_mem_mappings_lock();
+
+    for (size_t i = 0; i < _g_mem_num_mappings; i++) {
+        if (_g_mem_mappings[i].mem == *mem) {
+            mapping = _g_mem_mappings[i];
+            _g_mem_mappings[i] = _g_mem_mappings[_g_mem_num_mappings - 1];
+            __atomic_store_n(&_g_mem_num_mappings, _g_mem_num_mappings - 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+
+    _g_mem_mappings_unlock();
+
+    if (mapping.mem == NULL) {
+        return false;
+    }
+
+    if (n_bytes == 0) {
+        munmap(mapping.mem, mapping.size);
+        *mem = NULL;
+        return true;
+    }
+
+    new_mem = mremap(mapping.mem, mapping.size, _g_mem_page_round(n_bytes), MREMAP_MAYMOVE);
+    if (new_mem == MAP_FAILED) {
+        _g_mem_out_of_memory("mremap", n_bytes);
+    }
+
+    _g_mem_mappings_add(new_mem, _g_mem_page_round(n_bytes));
+    *mem = new_mem;
+
+    return true;
+}
+#endif
+
+void* g_malloc(size_t n_bytes)
+{
+    void *mem;
+
+    if (n_bytes == 0) {
+        return NULL;
+    }
+
+    mem = _g_mem_vtable.malloc(n_bytes);
+    if (mem == NULL) {
+        _g_mem_out_of_memory("g_malloc", n_bytes);
+    }
+
+    return mem;
+}
+
+void* g_malloc0(size_t n_bytes)
+{
+    void *mem;
+
+    if (n_bytes == 0) {
+        return NULL;
+    }
+
+    if (_g_mem_vtable.calloc) {
+        mem = _g_mem_vtable.calloc(1, n_bytes);
+    } else {
+        mem = _g_mem_vtable.malloc(n_bytes);
+        if (mem != NULL) {
+            memset(mem, 0, n_bytes);
+        }
+    }
+
+    if (mem == NULL) {
+        _g_mem_out_of_memory("g_malloc0", n_bytes);
+    }
+
+    return mem;
+}
+
+void* g_realloc(void *mem, size_t n_bytes)
+{
+    if (n_bytes == 0) {
+        g_free(mem);
+        return NULL;
+    }
+
+#ifdef _G_MEM_MREMAP
+    if (_g_mem_mappings_realloc(&mem, n_bytes)) {
+        return mem;
+    }
+#endif
+
+    mem = _g_mem_vtable.realloc(mem, n_bytes);
+    if (mem == NULL) {
+        _g_mem_out_of_memory("g_realloc", n_bytes);
+    }
+
+    return mem;
+}
+
+void* g_try_malloc(size_t n_bytes)
+{
+    if (n_bytes == 0) {
+        return NULL;
+    }
+
+    if (_g_mem_vtable.try_malloc) {
+        return _g_mem_vtable.try_malloc(n_bytes);
+    }
+
+    return _g_mem_vtable.malloc(n_bytes);
+}
+
+void* g_try_realloc(void *mem, size_t n_bytes)
+{
+    if (n_bytes == 0) {
+        g_free(mem);
+        return NULL;
+    }
+
+#ifdef _G_MEM_MREMAP
+    if (_g_mem_mappings_realloc(&mem, n_bytes)) {
+        return mem;
+    }
+#endif
+
+    if (_g_mem_vtable.try_realloc) {
+        return _g_mem_vtable.try_realloc(mem, n_bytes);
+    }
+
+    return _g_mem_vtable.realloc(mem, n_bytes);
+}
+
+void g_free(void *mem)
+{
+    if (mem == NULL) {
+        return;
+    }
+
+#ifdef _G_MEM_MREMAP
+    if (_g_mem_mappings_realloc(&mem, 0)) {
+        return;
+    }
+#endif
+
+    _g_mem_vtable.free(mem);
+}
+
+#ifdef _G_MEM_MREMAP
+bool _g_mem_use_mapping(size_t n_bytes)
+{
+    // a custom allocator wouldn't see the memory
+    return n_bytes >= GMEM_MREMAP_THRESHOLD && _g_mem_default_allocator;
+}
+
+void* _g_mem_map(size_t n_bytes)
+{
+    void *mem = mmap(NULL, _g_mem_page_round(n_bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | _G_MEM_MAP_ANONYMOUS, -1, 0);
+
+    if (mem == MAP_FAILED) {
+        _g_mem_out_of_memory("mmap", n_bytes);
+    }
+
+    return mem;
+}
+#endif
+
+void* _g_mem_buffer_alloc(size_t n_bytes, bool clear, bool *mapped)
+{
+#ifdef _G_MEM_MREMAP
+    if (_g_mem_use_mapping(n_bytes)) {
+        // fresh pages are zero anyway
+        *mapped = true;
+        return _g_mem_map(n_bytes);
+    }
+#endif
+
+    *mapped = false;
+
+    if (clear) {
+        return g_malloc0(n_bytes);
+    }
+
+    return g_malloc(n_bytes);
+}
+
+void* _g_mem_buffer_realloc(void *mem, size_t old_size, size_t new_size, bool *mapped)
+{
+#ifdef _G_MEM_MREMAP
+    void *new_mem;
+
+    if (*mapped) {
+        if (new_size >= GMEM_MREMAP_THRESHOLD) {
+            // keep the rest of the last page zero for _g_mem_buffer_realloc0
+            if (new_size < old_size) {
+                memset((char*) mem + new_size, 0, _g_mem_page_round(new_size) - new_size);
+            }
+
+            new_mem = mremap(mem, _g_mem_page_round(old_size), _g_mem_page_round(new_size), MREMAP_MAYMOVE);
+            if (new_mem == MAP_FAILED) {
+                _g_mem_out_of_memory("mremap", new_size);
+            }
+
+            return new_mem;
+        }
+
+        // shrunk below the threshold, go back to the allocator
+        new_mem = g_malloc(new_size);
+        if (new_size > 0) {
+            memcpy(new_mem, mem, new_size);
+        }
+        munmap(mem, _g_mem_page_round(old_size));
+        *mapped = false;
+
+        return new_mem;
+    }
+
+    if (_g_mem_use_mapping(new_size)) {
+        // the last copy, from now on the buffer grows with mremap
+        new_mem = _g_mem_map(new_size);
+        if (mem != NULL) {
+            memcpy(new_mem, mem, old_size < new_size ? old_size : new_size);
+            g_free(mem);
+        }
+        *mapped = true;
+
+        return new_mem;
+    }
+#endif
+
+    return g_realloc(mem, new_size);
+}
+
+// Like _g_mem_buffer_realloc() but the bytes from old_size to new_size are zero.
+// Only the first used bytes are preserved, the rest may be zero as well.
+void* _g_mem_buffer_realloc0(void *mem, size_t old_size, size_t used, size_t new_size, bool *mapped)
+{
+    void *new_mem;
+
+    if (new_size <= old_size) {
+        return _g_mem_buffer_realloc(mem, old_size, new_size, mapped);
+    }
+
+#ifdef _G_MEM_MREMAP
+    // mappings grow by fresh pages which are zero already
+    if (*mapped || _g_mem_use_mapping(new_size)) {
+        return _g_mem_buffer_realloc(mem, old_size, new_size, mapped);
+    }
+#endif
+
+    if (new_size - old_size < _G_MEM_CALLOC_THRESHOLD) {
+        new_mem = g_realloc(mem, new_size);
+        memset((char*) new_mem + old_size, 0, new_size - old_size);
+
+        return new_mem;
+    }
+
+    // calloc gets large blocks as fresh zero pages from the OS, so the new
+    // part isn't touched until it is used
+    new_mem = g_malloc0(new_size);
+    if (used > 0) {
+        memcpy(new_mem, mem, used);
+    }
+    g_free(mem);
+
+    return new_mem;
+}
+
+void* _g_mem_buffer_steal(void *mem, size_t size, size_t used, bool mapped)
+{
+#ifdef _G_MEM_MREMAP
+    // the mapping is handed over as it is, g_free() and g_realloc() find it in
+    // the list of mappings. The pages behind the used bytes are given back.
+    if (mapped) {
+        if (used == 0) {
+            munmap(mem, _g_mem_page_round(size));
+            return NULL;
+        }
+
+        if (_g_mem_page_round(used) < _g_mem_page_round(size)) {
+            mem = mremap(mem, _g_mem_page_round(size), _g_mem_page_round(used), MREMAP_MAYMOVE);
+            if (mem == MAP_FAILED) {
+                _g_mem_out_of_memory("mremap", used);
+            }
+        }
+
+        _g_mem_mappings_add(mem, _g_mem_page_round(used));
+
+        return mem;
+    }
+#endif
+
+    return mem;
+}
+
+void _g_mem_buffer_free(void *mem, size_t size, bool mapped)
+{
+#ifdef _G_MEM_MREMAP
+    if (mapped) {
+        munmap(mem, _g_mem_page_round(size));
+        return;
+    }
+#endif
+
+    g_free(mem);
+}
+
+void g_mem_stats_get(GMemStatsType type, GMemStats *stats)
+{
+    memcpy(stats, &_g_mem_stats[type], sizeof(GMemStats));
+}
+
+void g_mem_stats_reset(void)
+{
+    memset(_g_mem_stats, 0, sizeof(_g_mem_stats));
+}
+
+#ifdef CLIB_MEM_STATS
+void _g_mem_stats_alloc(GMemStatsType type, size_t size)
+{
+    _G_MEM_STATS_ADD(_g_mem_stats[type].live_bytes, size);
+    _G_MEM_STATS_ADD(_g_mem_stats[type].alloc_calls, 1);
+}
+
+void _g_mem_stats_realloc(GMemStatsType type, size_t old_size, size_t new_size)
+{
+    if (new_size >= old_size) {
+        _G_MEM_STATS_ADD(_g_mem_stats[type].live_bytes, new_size - old_size);
+    } else {
+        _G_MEM_STATS_SUB(_g_mem_stats[type].live_bytes, old_size - new_size);
+    }
+
+    _G_MEM_STATS_ADD(_g_mem_stats[type].realloc_calls, 1);
+}
+
+void _g_mem_stats_free(GMemStatsType type, size_t size)
+{
+    _G_MEM_STATS_SUB(_g_mem_stats[type].live_bytes, size);
+    _G_MEM_STATS_ADD(_g_mem_stats[type].free_calls, 1);
+}
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+/*
+ * GQueueArray
+ *
+ * Copyright (c) 2023 Andreas Heck <aheck@gmx.de>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * GQueueArray is a double-ended queue of fixed size elements in a ring
+ * buffer. Pushing and popping at both ends is O(1) and elements are accessed
+ * by their position from the head like in a GArray.
+ *
+ * The elements are contiguous in memory unless the queue wraps around the end
+ * of the buffer. g_queue_array_linearize() moves them so that they start at
+ * the beginning of the buffer and returns a pointer to them.
+ */
+
+#ifndef _GQUEUEARRAY_H
+#define _GQUEUEARRAY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "gmem.h"
+
+#define GQUEUEARRAY_MIN_ELEMENTS 8
+
+typedef void (*GDestroyNotify)(void *data);
+
+typedef struct GQueueArray {
+    char *data;
+    unsigned int len;
+    unsigned int _head; // position of the first element in data
+    unsigned int _allocated_elements; // always a power of 2
+    unsigned int _element_size;
+    GDestroyNotify _clear_func;
+} GQueueArray;
+
+GQueueArray* g_queue_array_new(unsigned int element_size);
+GQueueArray* g_queue_array_sized_new(unsigned int element_size, unsigned int reserved_size);
+#define g_queue_array_push_tail_val(q, v) g_queue_array_push_tail_vals(q, &v, 1)
+GQueueArray* g_queue_array_push_tail_vals(GQueueArray *queue, const void *data, unsigned int len);
+#define g_queue_array_push_head_val(q, v) g_queue_array_push_head_vals(q, &v, 1)
+GQueueArray* g_queue_array_push_head_vals(GQueueArray *queue, const void *data, unsigned int len);
+bool g_queue_array_pop_head(GQueueArray *queue, void *out_element);
+bool g_queue_array_pop_tail(GQueueArray *queue, void *out_element);
+void* g_queue_array_peek_head(GQueueArray *queue);
+void* g_queue_array_peek_tail(GQueueArray *queue);
+void* g_queue_array_index_ptr(GQueueArray *queue, unsigned int index);
+#define g_queue_array_index(q, t, i) (*(t*) g_queue_array_index_ptr(q, i))
+char* g_queue_array_linearize(GQueueArray *queue);
+void g_queue_array_clear(GQueueArray *queue);
+void g_queue_array_set_clear_func(GQueueArray *queue, GDestroyNotify clear_func);
+void g_queue_array_memory_usage(GQueueArray *queue, GMemUsage *usage);
+void g_queue_array_free(GQueueArray *queue);
+
+#ifdef _CLIB_IMPL
+#define _G_QUEUE_ARRAY_MAX_ELEMENTS (1u << 31)
+
+void _g_queue_array_resize_if_needed(GQueueArray *queue, unsigned int new_elements)
+{
+    unsigned int es = queue->_element_size;
+    unsigned int old_allocated = queue->_allocated_elements;
+    size_t needed = (size_t) queue->len + new_elements;
+    size_t allocated = old_allocated;
+
+    if (needed <= old_allocated) {
+        return;
+    }
+
+    // the capacity is a power of two that has to fit into an unsigned int
+    if (needed > _G_QUEUE_ARRAY_MAX_ELEMENTS) {
+        fprintf(stderr, "FATAL ERROR: _g_queue_array_resize_if_needed: %u more elements exceed the maximum length of %u",
+            new_elements, _G_QUEUE_ARRAY_MAX_ELEMENTS);
+        exit(1);
+    }
+
+    if (allocated < GQUEUEARRAY_MIN_ELEMENTS) {
+        allocated = GQUEUEARRAY_MIN_ELEMENTS;
+    }
+
+    while (allocated < needed) {
+        allocated *= 2;
+    }
+
+    if (queue->data == NULL) {
+        _g_mem_stats_alloc(G_MEM_STATS_QUEUE_ARRAY, allocated * es);
+    } else {
+        _g_mem_stats_realloc(G_MEM_STATS_QUEUE_ARRAY, (size_t) old_allocated * es, allocated * es);
+    }
+
+    queue->data = g_realloc(queue->data, allocated * es);
+    queue->_allocated_elements = (unsigned int) allocated;
+
+    // the part that wrapped around goes behind the old end, there is enough
+    // room because the buffer at least doubled
+    if (queue->_head + queue->len > old_allocated) {
+        unsigned int wrapped = queue->_head + queue->len - old_allocated;
+        memcpy(&queue->data[(size_t) old_allocated * es], queue->data, (size_t) wrapped * es);
+    }
+}
+
+// Buffer position of the element at index
+unsigned int _g_queue_array_pos(GQueueArray *queue, unsigned int index)
+{
+    return (queue->_head + index) & (queue->_allocated_elements - 1);
+}
+
+GQueueArray* g_queue_array_new(unsigned int element_size)
+{
+    return g_queue_array_sized_new(element_size, 0);
+}
+
+GQueueArray* g_queue_array_sized_new(unsigned int element_size, unsigned int reserved_size)
+{
+    GQueueArray *queue;
+
+    queue = g_malloc(sizeof(GQueueArray));
+    _g_mem_stats_alloc(G_MEM_STATS_QUEUE_ARRAY, sizeof(GQueueArray));
+
+    queue->data = NULL;
+    queue->len = 0;
+    queue->_head = 0;
+    queue->_allocated_elements = 0;
+    queue->_element_size = element_size;
+    queue->_clear_func = NULL;
+
+    if (reserved_size > 0) {
+        _g_queue_array_resize_if_needed(queue, reserved_size);
+    }
+
+    return queue;
+}
+
+GQueueArray* g_queue_array_push_tail_vals(GQueueArray *queue, const void *data, unsigned int len)
+{
+    unsigned int es = queue->_element_size;
+    unsigned int tail;
+    unsigned int first_part;
+
+    if (len == 0) {
+        return queue;
+    }
+
+    _g_queue_array_resize_if_needed(queue, len);
+
+    // copy in up to two parts if the new elements wrap around
+    tail = _g_queue_array_pos(queue, queue->len);
+    first_part = queue->_allocated_elements - tail;
+    if (first_part > len) {
+        first_part = len;
+    }
+
+    memcpy(&queue->data[(size_t) tail * es], data, (size_t) first_part * es);
+    memcpy(queue->data, (const char*) data + (size_t) first_part * es, (size_t) (len - first_part) * es);
+
+    queue->len += len;
+
+    return queue;
+}
+
+GQueueArray* g_queue_array_push_head_vals(GQueueArray *queue, const void *data, unsigned int len)
+{
+    unsigned int es = queue->_element_size;
+    unsigned int head;
+    unsigned int first_part;
+
+    if (len == 0) {
+        return queue;
+    }
+
+    _g_queue_array_resize_if_needed(queue, len);
+
+    // data[0] ends up at the new head like with g_array_prepend_vals
+    head = (queue->_head - len) & (queue->_allocated_elements - 1);
+    first_part = queue->_allocated_elements - head;
+    if (first_part > len) {
+        first_part = len;
+    }
+
+    memcpy(&queue->data[(size_t) head * es], data, (size_t) first_part * es);
+    memcpy(queue->data, (const char*) data + (size_t) first_part * es, (size_t) (len - first_part) * es);
+
+    queue->_head = head;
+    queue->len += len;
+
+    return queue;
+}
+
+bool g_queue_array_pop_head(GQueueArray *queue, void *out_element)
+{
+    if (queue->len == 0) {
+        return false;
+    }
+
+    // an element that isn't handed to the caller is dropped
+    if (out_element) {
+        memcpy(out_element, &queue->data[(size_t) queue->_head * queue->_element_size], queue->_element_size);
+    } else if (queue->_clear_func) {
+        queue->_clear_func(&queue->data[(size_t) queue->_head * queue->_element_size]);
+    }
+
+    queue->_head = _g_queue_array_pos(queue, 1);
+    queue->len--;
+
+    return true;
+}
+
+bool g_queue_array_pop_tail(GQueueArray *queue, void *out_element)
+{
+    if (queue->len == 0) {
+        return false;
+    }
+
+    if (out_element) {
+        memcpy(out_element, g_queue_array_peek_tail(queue), queue->_element_size);
+    } else if (queue->_clear_func) {
+        queue->_clear_func(g_queue_array_peek_tail(queue));
+    }
+
+    queue->len--;
+
+    return true;
+}
+
+void* g_queue_array_peek_head(GQueueArray *queue)
+{
+    if (queue->len == 0) {
+        return NULL;
+    }
+
+    return &queue->data[(size_t) queue->_head * queue->_element_size];
+}
+
+void* g_queue_array_peek_tail(GQueueArray *queue)
+{
+    if (queue->len == 0) {
+        return NULL;
+    }
+
+    return &queue->data[(size_t) _g_queue_array_pos(queue, queue->len - 1) * queue->_element_size];
+}
+
+void* g_queue_array_index_ptr(GQueueArray *queue, unsigned int index)
+{
+    return &queue->data[(size_t) _g_queue_array_pos(queue, index) * queue->_element_size];
+}
+
+char* g_queue_array_linearize(GQueueArray *queue)
+{
+    unsigned int es = queue->_element_size;
+    char *tmp;
+
+    if (queue->_head == 0) {
+        return queue->data;
+    }
+
+    if (queue->_head + queue->len <= queue->_allocated_elements) {
+        // contiguous, just move it to the front
+        memmove(queue->data, &queue->data[(size_t) queue->_head * es], (size_t) queue->len * es);
+    } else {
+        // the part at the end of the buffer goes in front of the wrapped part
+        unsigned int first_part = queue->_allocated_elements - queue->_head;
+        unsigned int wrapped = queue->len - first_part;
+
+        tmp = g_malloc((size_t) first_part * es);
+        memcpy(tmp, &queue->data[(size_t) queue->_head * es], (size_t) first_part * es);
+        memmove(&queue->data[(size_t) first_part * es], queue->data, (size_t) wrapped * es);
+        memcpy(queue->data, tmp, (size_t) first_part * es);
+        g_free(tmp);
+    }
+
+    queue->_head = 0;
+
+    return queue->data;
+}
+
+void g_queue_array_clear(GQueueArray *queue)
+{
+    if (queue->_clear_func) {
+        for (unsigned int i = 0; i < queue->len; i++) {
+            queue->_clear_func(g_queue_array_index_ptr(queue, i));
+        }
+    }
+
+    queue->_head = 0;
+    queue->len = 0;
+}
+
+void g_queue_array_set_clear_func(GQueueArray *queue, GDestroyNotify clear_func)
+{
+    queue->_clear_func = clear_func;
+}
+
+void g_queue_array_memory_usage(GQueueArray *queue, GMemUsage *usage)
+{
+    usage->allocated = sizeof(GQueueArray) + (size_t) queue->_allocated_elements * queue->_element_size;
+    usage->used = (size_t) queue->len * queue->_element_size;
+    usage->overhead = usage->allocated - usage->used;
+}
+
+void g_queue_array_free(GQueueArray *queue)
+{
+    if (queue == NULL) {
+        return;
+    }
+
+    g_queue_array_clear(queue);
+
+    _g_mem_stats_free(G_MEM_STATS_QUEUE_ARRAY, sizeof(GQueueArray));
+    if (queue->data != NULL) {
+        _g_mem_stats_free(G_MEM_STATS_QUEUE_ARRAY, (size_t) queue->_allocated_elements * queue->_element_size);
+    }
+
+    g_free(queue->data);
+    g_free(queue);
+}
+
+#endif
+#endif
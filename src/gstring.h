@@ -39,6 +39,8 @@ typedef SSIZE_T ssize_t;
 #include <string.h>
 #include <ctype.h>
 
+#include "gmem.h"
+
 #define GSTRING_MIN_BUF_SIZE 32
 
 #define TRUE  true
@@ -48,6 +50,7 @@ typedef struct GString {
     char *str;
     size_t len;
     size_t allocated_len;
+    bool _mapped; // str is mapped by gmem.h instead of allocated
 } GString;
 
 GString* g_string_new(const char *init);
@@ -73,6 +76,7 @@ void g_string_append_vprintf(GString *string, const char *format, va_list args);
 void g_string_printf(GString *string, const char *format, ...);
 void g_string_append_printf(GString *string, const char *format, ...);
 bool g_string_equal(GString *v, GString *v2);
+void g_string_memory_usage(GString *string, GMemUsage *usage);
 char* g_string_free(GString *string, bool free_segment);
 
 
@@ -145,17 +149,12 @@ GString* g_string_new(const char *init)
         buf_size = init_len + 1;
     }
 
-    string = malloc(sizeof(GString));
-    if (string == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_string_new: Out of memory");
-        exit(1);
-    }
+    string = g_malloc(sizeof(GString));
 
-    string->str = malloc(buf_size);
-    if (string->str == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_string_new: Out of memory");
-        exit(1);
-    }
+    string->str = _g_mem_buffer_alloc(buf_size, false, &string->_mapped);
+
+    _g_mem_stats_alloc(G_MEM_STATS_STRING, sizeof(GString));
+    _g_mem_stats_alloc(G_MEM_STATS_STRING, buf_size);
 
     // fill GString attributes
     if (init_len > 0) {
@@ -174,19 +173,14 @@ GString* g_string_new_len(const char *init, size_t len)
 {
     GString *string;
 
-    string = malloc(sizeof(GString));
-    if (string == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_string_new_len: Out of memory");
-        exit(1);
-    }
+    string = g_malloc(sizeof(GString));
 
     size_t buf_size = len + 1;
 
-    string->str = malloc(buf_size);
-    if (string->str == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_string_new_len: Out of memory");
-        exit(1);
-    }
+    string->str = _g_mem_buffer_alloc(buf_size, false, &string->_mapped);
+
+    _g_mem_stats_alloc(G_MEM_STATS_STRING, sizeof(GString));
+    _g_mem_stats_alloc(G_MEM_STATS_STRING, buf_size);
 
     memcpy(string->str, init, len);
 
@@ -201,17 +195,12 @@ GString* g_string_sized_new(ssize_t dfl_size)
 {
     GString *string;
 
-    string = malloc(sizeof(GString));
-    if (string == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_string_sized_new: Out of memory");
-        exit(1);
-    }
+    string = g_malloc(sizeof(GString));
 
-    string->str = malloc(dfl_size);
-    if (string->str == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_string_sized_new: Out of memory");
-        exit(1);
-    }
+    string->str = _g_mem_buffer_alloc(dfl_size, false, &string->_mapped);
+
+    _g_mem_stats_alloc(G_MEM_STATS_STRING, sizeof(GString));
+    _g_mem_stats_alloc(G_MEM_STATS_STRING, dfl_size);
 
     string->len = 0;
     string->allocated_len = dfl_size;
@@ -230,11 +219,9 @@ void _g_string_resize(GString *string, size_t requested_size)
 
     buf_size = requested_size * 2;
 
-    new_buf = realloc(string->str, buf_size);
-    if (new_buf == NULL) {
-        fprintf(stderr, "FATAL ERROR: g_string_new: Out of memory");
-        exit(1);
-    }
+    _g_mem_stats_realloc(G_MEM_STATS_STRING, string->allocated_len, buf_size);
+
+    new_buf = _g_mem_buffer_realloc(string->str, string->allocated_len, buf_size, &string->_mapped);
 
     string->str = new_buf;
     string->allocated_len = buf_size;
@@ -630,19 +617,30 @@ bool g_string_equal(GString *v, GString *v2)
     return memcmp(v->str, v2->str, v->len) == 0;
 }
 
+void g_string_memory_usage(GString *string, GMemUsage *usage)
+{
+    usage->allocated = sizeof(GString) + string->allocated_len;
+    usage->used = string->len;
+    usage->overhead = usage->allocated - usage->used;
+}
+
 char* g_string_free(GString *string, bool free_segment)
 {
     char *segment;
 
+    // with free_segment == false the caller owns the buffer from now on
+    _g_mem_stats_free(G_MEM_STATS_STRING, sizeof(GString));
+    _g_mem_stats_free(G_MEM_STATS_STRING, string->allocated_len);
+
     if (free_segment) {
-        free(string->str);
-        free(string);
+        _g_mem_buffer_free(string->str, string->allocated_len, string->_mapped);
+        g_free(string);
         return NULL;
     }
 
-    segment = string->str;
+    segment = _g_mem_buffer_steal(string->str, string->allocated_len, string->len + 1, string->_mapped);
 
-    free(string);
+    g_free(string);
 
     return segment;
 }
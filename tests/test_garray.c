@@ -1,10 +1,27 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
 #include <check.h>
 
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define _CLIB_IMPL 1
 #include "garray.h"
 
+// the capacity of an array that grew to needed elements in one step
+static unsigned int grown_capacity(unsigned int needed)
+{
+#ifdef GARRAY_GROW_POW2
+    return (unsigned int) _g_array_nearest_pow(needed);
+#else
+    return needed;
+#endif
+}
+
 int compare_int(const void *a, const void *b)
 {
     return *((int*) a) - *((int*) b);
@@ -63,7 +80,7 @@ START_TEST(test_garray_steal)
     g_array_append_vals(array, vals, sizeof(vals) / sizeof(int));
 
     ck_assert_int_eq(array->len, 5);
-    ck_assert_int_eq(array->_allocated_elements, 5);
+    ck_assert_int_eq(array->_allocated_elements, grown_capacity(5));
 
     void *array_data = g_array_steal(array, &len);
 
@@ -73,7 +90,7 @@ START_TEST(test_garray_steal)
     ck_assert_ptr_null(array->data);
     ck_assert_int_eq(array->_allocated_elements, 0);
 
-    free(array_data);
+    g_free(array_data);
     g_array_free(array, true);
 }
 END_TEST
@@ -89,7 +106,7 @@ START_TEST(test_garray_steal_zero_terminated)
     g_array_append_vals(array, vals, sizeof(vals) / sizeof(int));
 
     ck_assert_int_eq(array->len, 5);
-    ck_assert_int_eq(array->_allocated_elements, 6);
+    ck_assert_int_eq(array->_allocated_elements, grown_capacity(6));
 
     void *array_data = g_array_steal(array, &len);
 
@@ -101,7 +118,7 @@ START_TEST(test_garray_steal_zero_terminated)
     // zero terminated?
     ck_assert_int_eq(g_array_index(array, int, array->len), 0);
 
-    free(array_data);
+    g_free(array_data);
     g_array_free(array, true);
 }
 END_TEST
@@ -857,7 +874,7 @@ START_TEST(test_garray_set_size)
     result = g_array_set_size(array, 20);
     ck_assert_ptr_eq(array, result);
     ck_assert_int_eq(array->len, 20);
-    ck_assert_int_eq(array->_allocated_elements, 20);
+    ck_assert_int_eq(array->_allocated_elements, grown_capacity(20));
 
     ck_assert_int_eq(g_array_index(array, int, 0), 0);
     ck_assert_int_eq(g_array_index(array, int, 1), 1);
@@ -873,7 +890,7 @@ START_TEST(test_garray_set_size)
     result = g_array_set_size(array, 5);
     ck_assert_ptr_eq(array, result);
     ck_assert_int_eq(array->len, 5);
-    ck_assert_int_eq(array->_allocated_elements, 20);
+    ck_assert_int_eq(array->_allocated_elements, grown_capacity(20));
 
     ck_assert_int_eq(g_array_index(array, int, 0), 0);
     ck_assert_int_eq(g_array_index(array, int, 1), 1);
@@ -921,7 +938,7 @@ START_TEST(test_garray_zero_termination)
     g_array_prepend_val(array, val);
 
     ck_assert_int_eq(array->len, 2);
-    ck_assert_int_eq(array->_allocated_elements, 3);
+    ck_assert_int_eq(array->_allocated_elements, 4);
     ck_assert_int_eq(g_array_index(array, int, 0), 4);
     ck_assert_int_eq(g_array_index(array, int, 1), 5);
 
@@ -935,7 +952,7 @@ START_TEST(test_garray_zero_termination)
     g_array_append_vals(array, vals1, sizeof(vals1) / sizeof(int));
 
     ck_assert_int_eq(array->len, 6);
-    ck_assert_int_eq(array->_allocated_elements, 7);
+    ck_assert_int_eq(array->_allocated_elements, 8);
 
     // zero terminated?
     ck_assert_int_eq(g_array_index(array, int, array->len), 0);
@@ -947,7 +964,7 @@ START_TEST(test_garray_zero_termination)
     g_array_prepend_vals(array, vals2, sizeof(vals2) / sizeof(int));
 
     ck_assert_int_eq(array->len, 10);
-    ck_assert_int_eq(array->_allocated_elements, 11);
+    ck_assert_int_eq(array->_allocated_elements, 16);
 
     // zero terminated?
     ck_assert_int_eq(g_array_index(array, int, array->len), 0);
@@ -958,7 +975,7 @@ START_TEST(test_garray_zero_termination)
     g_array_remove_index(array, 5);
 
     ck_assert_int_eq(array->len, 9);
-    ck_assert_int_eq(array->_allocated_elements, 11);
+    ck_assert_int_eq(array->_allocated_elements, 16);
 
     ck_assert_int_eq(g_array_index(array, int, 0), 45);
     ck_assert_int_eq(g_array_index(array, int, 1), 28);
@@ -979,7 +996,7 @@ START_TEST(test_garray_zero_termination)
     g_array_remove_index_fast(array, 5);
 
     ck_assert_int_eq(array->len, 8);
-    ck_assert_int_eq(array->_allocated_elements, 11);
+    ck_assert_int_eq(array->_allocated_elements, 16);
 
     ck_assert_int_eq(g_array_index(array, int, 0), 45);
     ck_assert_int_eq(g_array_index(array, int, 1), 28);
@@ -999,7 +1016,7 @@ START_TEST(test_garray_zero_termination)
     g_array_remove_range(array, 3, 3);
 
     ck_assert_int_eq(array->len, 5);
-    ck_assert_int_eq(array->_allocated_elements, 11);
+    ck_assert_int_eq(array->_allocated_elements, 16);
 
     ck_assert_int_eq(g_array_index(array, int, 0), 45);
     ck_assert_int_eq(g_array_index(array, int, 1), 28);
@@ -1017,7 +1034,7 @@ START_TEST(test_garray_zero_termination)
     g_array_insert_val(array, 5, insert_val);
 
     ck_assert_int_eq(array->len, 6);
-    ck_assert_int_eq(array->_allocated_elements, 11);
+    ck_assert_int_eq(array->_allocated_elements, 16);
 
     ck_assert_int_eq(g_array_index(array, int, 0), 45);
     ck_assert_int_eq(g_array_index(array, int, 1), 28);
@@ -1035,7 +1052,7 @@ START_TEST(test_garray_zero_termination)
     g_array_set_size(array, 20);
 
     ck_assert_int_eq(array->len, 20);
-    ck_assert_int_eq(array->_allocated_elements, 21);
+    ck_assert_int_eq(array->_allocated_elements, 32);
 
     // zero terminated?
     ck_assert_int_eq(g_array_index(array, int, array->len), 0);
@@ -1043,7 +1060,7 @@ START_TEST(test_garray_zero_termination)
     g_array_set_size(array, 0);
 
     ck_assert_int_eq(array->len, 0);
-    ck_assert_int_eq(array->_allocated_elements, 21);
+    ck_assert_int_eq(array->_allocated_elements, 32);
 
     // zero terminated?
     ck_assert_int_eq(g_array_index(array, int, array->len), 0);
@@ -1078,66 +1095,2131 @@ START_TEST(test_garray_free_without_segment)
     char *result = g_array_free(array, false);
     ck_assert_ptr_nonnull(result);
 
-    free(result);
+    g_free(result);
 }
 END_TEST
 
-Suite* garray_suite(void)
+START_TEST(test_garray_memory_usage)
 {
-    Suite *s;
-    TCase *tc_core;
+    GArray *array = NULL;
+    GMemUsage usage;
 
-    s = suite_create("GArray");
+    array = g_array_sized_new(false, false, sizeof(int), 10);
 
-    /* Core test case */
-    tc_core = tcase_create("Core");
+    g_array_memory_usage(array, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GArray) + 10 * sizeof(int));
+    ck_assert_int_eq(usage.used, 0);
+    ck_assert_int_eq(usage.overhead, usage.allocated);
 
-    tcase_add_test(tc_core, test_garray_new);
-    tcase_add_test(tc_core, test_garray_sized_new);
+    int vals[] = {34, 82, 43, 12, 71};
+    g_array_append_vals(array, vals, sizeof(vals) / sizeof(int));
 
-    tcase_add_test(tc_core, test_garray_steal);
-    tcase_add_test(tc_core, test_garray_steal_zero_terminated);
+    g_array_memory_usage(array, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GArray) + 10 * sizeof(int));
+    ck_assert_int_eq(usage.used, 5 * sizeof(int));
+    ck_assert_int_eq(usage.overhead, sizeof(GArray) + 5 * sizeof(int));
 
-    tcase_add_test(tc_core, test_garray_append_val);
-    tcase_add_test(tc_core, test_garray_append_val_many);
-    tcase_add_test(tc_core, test_garray_append_vals);
+    g_array_free(array, true);
+}
+END_TEST
 
-    tcase_add_test(tc_core, test_garray_prepend_val);
-    tcase_add_test(tc_core, test_garray_prepend_val_many);
-    tcase_add_test(tc_core, test_garray_prepend_vals);
+START_TEST(test_garray_growth)
+{
+    GArray *array = NULL;
+    unsigned int reallocs = 0;
+    char *data = NULL;
 
-    tcase_add_test(tc_core, test_garray_insert_val);
-    tcase_add_test(tc_core, test_garray_insert_val_beginning);
-    tcase_add_test(tc_core, test_garray_insert_val_end);
-    tcase_add_test(tc_core, test_garray_insert_vals);
-    tcase_add_test(tc_core, test_garray_insert_vals_non_existing_index);
-    tcase_add_test(tc_core, test_garray_insert_vals_non_existing_index_clear);
+    array = g_array_new(false, false, sizeof(int));
 
-    tcase_add_test(tc_core, test_garray_remove_index);
-    tcase_add_test(tc_core, test_garray_remove_index_beginning);
-    tcase_add_test(tc_core, test_garray_remove_index_end);
+    for (int i = 0; i < 100000; i++) {
+        g_array_append_val(array, i);
 
-    tcase_add_test(tc_core, test_garray_remove_index_fast);
+        if (array->data != data) {
+            data = array->data;
+            reallocs++;
+        }
+    }
 
-    tcase_add_test(tc_core, test_garray_remove_range);
+    ck_assert_int_eq(array->len, 100000);
+    ck_assert_int_ge(array->_allocated_elements, 100000);
+    ck_assert_int_le(array->_allocated_elements, 200000);
+    ck_assert_int_le(reallocs, 40);
 
-    tcase_add_test(tc_core, test_garray_sort);
-    tcase_add_test(tc_core, test_garray_sort_with_data);
+    for (int i = 0; i < 100000; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i);
+    }
 
-    tcase_add_test(tc_core, test_garray_binary_search_null);
-    tcase_add_test(tc_core, test_garray_binary_search_empty);
-    tcase_add_test(tc_core, test_garray_binary_search_one);
-    tcase_add_test(tc_core, test_garray_binary_search_two);
-    tcase_add_test(tc_core, test_garray_binary_search_three);
-    tcase_add_test(tc_core, test_garray_binary_search_same);
-    tcase_add_test(tc_core, test_garray_binary_search_extensive);
+    g_array_free(array, true);
+}
+END_TEST
 
-    tcase_add_test(tc_core, test_garray_set_size);
+START_TEST(test_garray_reserve)
+{
+    GArray *array = NULL;
+    GArray *result = NULL;
 
-    tcase_add_test(tc_core, test_garray_zero_termination);
+    array = g_array_new(false, true, sizeof(int));
 
-    tcase_add_test(tc_core, test_garray_free);
-    tcase_add_test(tc_core, test_garray_free_without_segment);
+    result = g_array_reserve(array, 100);
+    ck_assert_ptr_eq(array, result);
+    ck_assert_int_eq(array->len, 0);
+    ck_assert_int_eq(array->_allocated_elements, 100);
+
+    // cleared arrays have their reserved memory zeroed
+    for (int i = 0; i < 100; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], 0);
+    }
+
+    // appending within the reserved capacity doesn't reallocate
+    char *data = array->data;
+    for (int i = 0; i < 100; i++) {
+        g_array_append_val(array, i);
+    }
+    ck_assert_ptr_eq(array->data, data);
+    ck_assert_int_eq(array->_allocated_elements, 100);
+
+    // reserving less than the capacity is a no-op
+    g_array_reserve(array, 10);
+    ck_assert_int_eq(array->_allocated_elements, 100);
+
+    g_array_free(array, true);
+
+    // zero terminated arrays reserve space for the terminator
+    array = g_array_new(true, false, sizeof(int));
+    g_array_reserve(array, 10);
+    ck_assert_int_eq(array->_allocated_elements, 11);
+    ck_assert_int_eq(((int*) array->data)[0], 0);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_shrink_to_fit)
+{
+    GArray *array = NULL;
+    GArray *result = NULL;
+
+    array = g_array_new(false, false, sizeof(int));
+
+    for (int i = 0; i < 5; i++) {
+        g_array_append_val(array, i);
+    }
+    g_array_reserve(array, 100);
+
+    result = g_array_shrink_to_fit(array);
+    ck_assert_ptr_eq(array, result);
+    ck_assert_int_eq(array->len, 5);
+    ck_assert_int_eq(array->_allocated_elements, 5);
+
+    for (int i = 0; i < 5; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i);
+    }
+
+    g_array_set_size(array, 0);
+    g_array_shrink_to_fit(array);
+    ck_assert_int_eq(array->_allocated_elements, 0);
+    ck_assert_ptr_null(array->data);
+
+    g_array_free(array, true);
+
+    array = g_array_new(true, false, sizeof(int));
+    for (int i = 1; i <= 5; i++) {
+        g_array_append_val(array, i);
+    }
+
+    g_array_shrink_to_fit(array);
+    ck_assert_int_eq(array->_allocated_elements, 6);
+    ck_assert_int_eq(((int*) array->data)[5], 0);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+typedef struct {
+    uint64_t key;
+    uint64_t payload;
+} SortRecord;
+
+#define INT_LESS(a, b) ((a) < (b))
+#define RECORD_LESS(a, b) ((a).key < (b).key)
+
+CLIB_DEFINE_ARRAY_SORT(sort_ints, int, INT_LESS)
+CLIB_DEFINE_ARRAY_SORT(sort_records, SortRecord, RECORD_LESS)
+
+static int compare_int_values(const void *a, const void *b)
+{
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+
+    return (x > y) - (x < y);
+}
+
+START_TEST(test_garray_define_sort)
+{
+    GArray *array = NULL;
+    GArray *expected = NULL;
+    unsigned int seed = 1;
+
+    int sizes[] = {0, 1, 2, 3, 16, 17, 100, 129, 1000, 100000};
+
+    for (int s = 0; s < sizeof(sizes) / sizeof(int); s++) {
+        // random, sorted, reverse sorted and few unique values
+        for (int pattern = 0; pattern < 4; pattern++) {
+            array = g_array_new(false, false, sizeof(int));
+
+            for (int i = 0; i < sizes[s]; i++) {
+                int val;
+
+                seed = seed * 1103515245 + 12345;
+                switch (pattern) {
+                    case 0: val = (int) (seed >> 1); break;
+                    case 1: val = i; break;
+                    case 2: val = sizes[s] - i; break;
+                    default: val = (seed >> 16) % 4; break;
+                }
+
+                g_array_append_val(array, val);
+            }
+
+            expected = g_array_copy(array);
+            g_array_sort(expected, compare_int_values);
+
+            sort_ints(array);
+
+            ck_assert_int_eq(array->len, sizes[s]);
+            for (int i = 0; i < sizes[s]; i++) {
+                ck_assert_int_eq(((int*) array->data)[i], ((int*) expected->data)[i]);
+            }
+
+            g_array_free(array, true);
+            g_array_free(expected, true);
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_garray_define_sort_records)
+{
+    GArray *array = NULL;
+    SortRecord rec;
+    uint64_t sum = 0;
+
+    array = g_array_new(false, false, sizeof(SortRecord));
+
+    for (int i = 0; i < 10000; i++) {
+        rec.key = (i * 7919) % 1000;
+        rec.payload = i;
+        sum += rec.payload;
+        g_array_append_val(array, rec);
+    }
+
+    sort_records(array);
+
+    SortRecord *data = (SortRecord*) array->data;
+    for (int i = 1; i < 10000; i++) {
+        ck_assert_uint_le(data[i - 1].key, data[i].key);
+    }
+
+    // the payload has to stay with its key
+    for (int i = 0; i < 10000; i++) {
+        ck_assert_uint_eq((data[i].payload * 7919) % 1000, data[i].key);
+        sum -= data[i].payload;
+    }
+    ck_assert_uint_eq(sum, 0);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_define_sort_heap_sort)
+{
+    int vals[] = {5, 3, 9, 1, 5, 7, 2, 8, 0, 6, 4, 5};
+
+    // heap sort is the fallback for inputs that make quicksort degrade
+    sort_ints_heap_sort(vals, sizeof(vals) / sizeof(int));
+
+    for (int i = 1; i < sizeof(vals) / sizeof(int); i++) {
+        ck_assert_int_le(vals[i - 1], vals[i]);
+    }
+}
+END_TEST
+
+typedef struct {
+    uint32_t id;
+    int64_t timestamp;
+} RadixRecord;
+
+START_TEST(test_garray_radix_sort)
+{
+    GArray *array = NULL;
+    uint64_t seed = 1;
+
+    // unsigned 32 bit keys
+    array = g_array_new(false, false, sizeof(uint32_t));
+    for (int i = 0; i < 10000; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint32_t val = (uint32_t) (seed >> 32);
+        g_array_append_val(array, val);
+    }
+
+    g_array_radix_sort(array, 0, sizeof(uint32_t), G_ARRAY_RADIX_UNSIGNED);
+
+    ck_assert_int_eq(array->len, 10000);
+    for (int i = 1; i < 10000; i++) {
+        ck_assert_uint_le(((uint32_t*) array->data)[i - 1], ((uint32_t*) array->data)[i]);
+    }
+
+    g_array_free(array, true);
+
+    // signed 16 bit keys
+    int16_t vals16[] = {300, -1, 0, -32768, 32767, 5, -300, 1};
+    int16_t sorted16[] = {-32768, -300, -1, 0, 1, 5, 300, 32767};
+    array = g_array_new(false, false, sizeof(int16_t));
+    g_array_append_vals(array, vals16, 8);
+
+    g_array_radix_sort(array, 0, sizeof(int16_t), G_ARRAY_RADIX_SIGNED);
+
+    for (int i = 0; i < 8; i++) {
+        ck_assert_int_eq(((int16_t*) array->data)[i], sorted16[i]);
+    }
+
+    // descending
+    g_array_radix_sort(array, 0, sizeof(int16_t), G_ARRAY_RADIX_SIGNED | G_ARRAY_RADIX_DESCENDING);
+
+    for (int i = 0; i < 8; i++) {
+        ck_assert_int_eq(((int16_t*) array->data)[i], sorted16[7 - i]);
+    }
+
+    // invalid keys leave the array alone
+    g_array_radix_sort(array, 0, 3, G_ARRAY_RADIX_SIGNED);
+    g_array_radix_sort(array, 1, sizeof(int16_t), G_ARRAY_RADIX_SIGNED);
+    g_array_radix_sort(array, 0, sizeof(int16_t), G_ARRAY_RADIX_FLOAT);
+
+    for (int i = 0; i < 8; i++) {
+        ck_assert_int_eq(((int16_t*) array->data)[i], sorted16[7 - i]);
+    }
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_radix_sort_float)
+{
+    GArray *array = NULL;
+
+    float valsf[] = {1.5f, -0.25f, 0.0f, -100.0f, 3.0e10f, -3.0e-10f, 2.0f, -1.5f};
+    float sortedf[] = {-100.0f, -1.5f, -0.25f, -3.0e-10f, 0.0f, 1.5f, 2.0f, 3.0e10f};
+    array = g_array_new(false, false, sizeof(float));
+    g_array_append_vals(array, valsf, 8);
+
+    g_array_radix_sort(array, 0, sizeof(float), G_ARRAY_RADIX_FLOAT);
+
+    for (int i = 0; i < 8; i++) {
+        ck_assert_float_eq(((float*) array->data)[i], sortedf[i]);
+    }
+
+    g_array_free(array, true);
+
+    double valsd[] = {1.5, -0.25, 0.0, -100.0, 3.0e100, -3.0e-100, 2.0, -1.5};
+    double sortedd[] = {-100.0, -1.5, -0.25, -3.0e-100, 0.0, 1.5, 2.0, 3.0e100};
+    array = g_array_new(false, false, sizeof(double));
+    g_array_append_vals(array, valsd, 8);
+
+    g_array_radix_sort(array, 0, sizeof(double), G_ARRAY_RADIX_FLOAT);
+
+    for (int i = 0; i < 8; i++) {
+        ck_assert_double_eq(((double*) array->data)[i], sortedd[i]);
+    }
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_radix_sort_stable)
+{
+    GArray *array = NULL;
+    RadixRecord rec;
+
+    array = g_array_new(false, false, sizeof(RadixRecord));
+    for (int i = 0; i < 1000; i++) {
+        rec.id = i;
+        rec.timestamp = (i % 10) - 5;
+        g_array_append_val(array, rec);
+    }
+
+    g_array_radix_sort(array, offsetof(RadixRecord, timestamp), sizeof(int64_t), G_ARRAY_RADIX_SIGNED);
+
+    RadixRecord *data = (RadixRecord*) array->data;
+    for (int i = 1; i < 1000; i++) {
+        ck_assert_int_le(data[i - 1].timestamp, data[i].timestamp);
+
+        // elements with equal keys keep their order
+        if (data[i - 1].timestamp == data[i].timestamp) {
+            ck_assert_uint_lt(data[i - 1].id, data[i].id);
+        }
+    }
+    ck_assert_int_eq(data[0].timestamp, -5);
+    ck_assert_uint_eq(data[0].id, 0);
+    ck_assert_int_eq(data[999].timestamp, 4);
+    ck_assert_uint_eq(data[999].id, 999);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+static int compare_int_direction(const void *a, const void *b, void *user_data)
+{
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+
+    return ((x > y) - (x < y)) * *(const int*) user_data;
+}
+
+START_TEST(test_garray_sort_parallel)
+{
+    GArray *array = NULL;
+    GArray *expected = NULL;
+    unsigned int seed = 1;
+    // enough elements for 8 threads, even on machines with fewer CPUs
+    unsigned int thread_counts[] = {0, 1, 2, 3, 4, 7, 8};
+
+    for (int t = 0; t < sizeof(thread_counts) / sizeof(unsigned int); t++) {
+        array = g_array_new(false, false, sizeof(int));
+
+        for (int i = 0; i < 800000; i++) {
+            seed = seed * 1103515245 + 12345;
+            int val = (int) ((seed >> 8) % 100000);
+            g_array_append_val(array, val);
+        }
+
+        expected = g_array_copy(array);
+        g_array_sort(expected, compare_int_values);
+
+        g_array_sort_parallel(array, compare_int_values, thread_counts[t]);
+
+        ck_assert_int_eq(array->len, 800000);
+        ck_assert_int_eq(memcmp(array->data, expected->data, array->len * sizeof(int)), 0);
+
+        g_array_free(array, true);
+        g_array_free(expected, true);
+    }
+}
+END_TEST
+
+START_TEST(test_garray_sort_parallel_with_data)
+{
+    GArray *array = NULL;
+    int direction = -1;
+
+    array = g_array_new(false, false, sizeof(int));
+    for (int i = 0; i < 200000; i++) {
+        g_array_append_val(array, i);
+    }
+
+    g_array_sort_parallel_with_data(array, compare_int_direction, &direction, 4);
+
+    for (int i = 0; i < 200000; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], 199999 - i);
+    }
+
+    g_array_free(array, true);
+
+    // small arrays are sorted by the calling thread
+    int vals[] = {3, 1, 2};
+    array = g_array_new(false, false, sizeof(int));
+    g_array_append_vals(array, vals, 3);
+
+    g_array_sort_parallel_with_data(array, compare_int_direction, &direction, 4);
+
+    ck_assert_int_eq(((int*) array->data)[0], 3);
+    ck_assert_int_eq(((int*) array->data)[1], 2);
+    ck_assert_int_eq(((int*) array->data)[2], 1);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+typedef struct {
+    int key;
+    int seq;
+} StableRecord;
+
+static int compare_stable_record(const void *a, const void *b)
+{
+    int x = ((const StableRecord*) a)->key;
+    int y = ((const StableRecord*) b)->key;
+
+    return (x > y) - (x < y);
+}
+
+static int compare_stable_record_with_data(const void *a, const void *b, void *user_data)
+{
+    return compare_stable_record(a, b) * *(const int*) user_data;
+}
+
+static void check_stable_sort(int len, int pattern, GArray *scratch)
+{
+    GArray *array = NULL;
+    StableRecord rec;
+    unsigned int seed = len;
+
+    array = g_array_new(false, false, sizeof(StableRecord));
+
+    for (int i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        switch (pattern) {
+            case 0: rec.key = (seed >> 16) % 100; break; // random with many duplicates
+            case 1: rec.key = i / 3; break; // sorted
+            case 2: rec.key = (len - i) / 3; break; // descending with duplicates
+            case 3: rec.key = (seed >> 16) % 50 == 0 ? (int) ((seed >> 8) % len) : i; break; // nearly sorted
+            default: rec.key = (i % 100 < 50) ? i % 100 : 100 - i % 100; break; // sawtooth
+        }
+        rec.seq = i;
+
+        g_array_append_val(array, rec);
+    }
+
+    if (scratch == NULL) {
+        g_array_stable_sort(array, compare_stable_record);
+    } else {
+        g_array_stable_sort_with_buffer(array, compare_stable_record, scratch);
+    }
+
+    ck_assert_int_eq(array->len, len);
+
+    StableRecord *data = (StableRecord*) array->data;
+    for (int i = 1; i < len; i++) {
+        ck_assert_int_le(data[i - 1].key, data[i].key);
+
+        if (data[i - 1].key == data[i].key) {
+            ck_assert_int_lt(data[i - 1].seq, data[i].seq);
+        }
+    }
+
+    g_array_free(array, true);
+}
+
+START_TEST(test_garray_stable_sort)
+{
+    int sizes[] = {0, 1, 2, 5, 63, 64, 65, 1000, 100000};
+
+    for (int s = 0; s < sizeof(sizes) / sizeof(int); s++) {
+        for (int pattern = 0; pattern < 5; pattern++) {
+            check_stable_sort(sizes[s], pattern, NULL);
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_garray_stable_sort_with_buffer)
+{
+    int sizes[] = {1000, 100000, 65, 1000};
+    GArray *scratch = g_array_new(false, false, sizeof(StableRecord));
+    GArray *wrong = g_array_new(false, false, sizeof(int));
+    GArray *array = g_array_new(false, false, sizeof(StableRecord));
+    char *data;
+
+    // the scratch array grows with the largest array and is reused after
+    for (int s = 0; s < sizeof(sizes) / sizeof(int); s++) {
+        for (int pattern = 0; pattern < 5; pattern++) {
+            check_stable_sort(sizes[s], pattern, scratch);
+        }
+        ck_assert_uint_ge(scratch->len, sizes[s] / 2);
+    }
+
+    data = scratch->data;
+    check_stable_sort(100000, 0, scratch);
+    ck_assert_ptr_eq(scratch->data, data);
+
+    // the element sizes have to match
+    StableRecord recs[] = {{2, 0}, {1, 1}};
+    g_array_append_vals(array, recs, 2);
+    g_array_stable_sort_with_buffer(array, compare_stable_record, wrong);
+    ck_assert_int_eq(((StableRecord*) array->data)[0].key, 2);
+    ck_assert_uint_eq(wrong->len, 0);
+
+    g_array_free(array, true);
+    g_array_free(wrong, true);
+    g_array_free(scratch, true);
+}
+END_TEST
+
+START_TEST(test_garray_stable_sort_with_data)
+{
+    GArray *array = NULL;
+    StableRecord rec;
+    int direction = -1;
+
+    array = g_array_new(false, false, sizeof(StableRecord));
+
+    // sort by a secondary key first, then by the primary key
+    for (int i = 0; i < 1000; i++) {
+        rec.key = i % 7;
+        rec.seq = i;
+        g_array_append_val(array, rec);
+    }
+
+    g_array_stable_sort_with_data(array, compare_stable_record_with_data, &direction);
+
+    StableRecord *data = (StableRecord*) array->data;
+    for (int i = 1; i < 1000; i++) {
+        ck_assert_int_ge(data[i - 1].key, data[i].key);
+
+        if (data[i - 1].key == data[i].key) {
+            ck_assert_int_lt(data[i - 1].seq, data[i].seq);
+        }
+    }
+
+    // the scratch buffer doesn't outlive the sort
+    GMemUsage usage;
+    g_array_memory_usage(array, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GArray) + (size_t) array->_allocated_elements * sizeof(StableRecord));
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_search_index)
+{
+    GArray *array = NULL;
+    GArraySearchIndex *index = NULL;
+
+    for (int len = 0; len < 70; len++) {
+        array = g_array_new(false, false, sizeof(int));
+
+        // every value twice, only even values: 0, 0, 2, 2, 4, 4, ...
+        for (int i = 0; i < len; i++) {
+            int val = (i / 2) * 2;
+            g_array_append_val(array, val);
+        }
+
+        index = g_array_search_index_new(array, compare_int_values);
+        ck_assert_int_eq(index->len, len);
+
+        for (int target = -1; target <= len + 1; target++) {
+            unsigned int lower = 0;
+            unsigned int upper = 0;
+
+            // linear search for the expected results
+            while (lower < len && ((int*) array->data)[lower] < target) {
+                lower++;
+            }
+            upper = lower;
+            while (upper < len && ((int*) array->data)[upper] <= target) {
+                upper++;
+            }
+
+            ck_assert_uint_eq(g_array_search_index_lower_bound(index, &target), lower);
+            ck_assert_uint_eq(g_array_search_index_upper_bound(index, &target), upper);
+
+            unsigned int begin;
+            unsigned int end;
+            bool found = g_array_search_index_equal_range(index, &target, &begin, &end);
+            ck_assert_int_eq(found, lower < upper);
+            ck_assert_uint_eq(begin, lower);
+            ck_assert_uint_eq(end, upper);
+        }
+
+        g_array_search_index_free(index);
+        g_array_free(array, true);
+    }
+}
+END_TEST
+
+START_TEST(test_garray_search_index_large)
+{
+    GArray *array = NULL;
+    GArraySearchIndex *index = NULL;
+
+    array = g_array_new(false, false, sizeof(int));
+    for (int i = 0; i < 100000; i++) {
+        int val = i * 3;
+        g_array_append_val(array, val);
+    }
+
+    index = g_array_search_index_new(array, compare_int_values);
+
+    for (int i = 0; i < 100000; i += 7) {
+        int target = i * 3;
+        ck_assert_uint_eq(g_array_search_index_lower_bound(index, &target), i);
+        ck_assert_uint_eq(g_array_search_index_upper_bound(index, &target), i + 1);
+
+        target = i * 3 + 1;
+        ck_assert_uint_eq(g_array_search_index_lower_bound(index, &target), i + 1);
+    }
+
+    g_array_search_index_free(index);
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_bounds)
+{
+    GArray *array = NULL;
+
+    for (int len = 0; len < 40; len++) {
+        array = g_array_new(false, false, sizeof(int));
+
+        // 0, 0, 0, 3, 3, 3, 6, ...
+        for (int i = 0; i < len; i++) {
+            int val = (i / 3) * 3;
+            g_array_append_val(array, val);
+        }
+
+        for (int target = -1; target <= len + 1; target++) {
+            unsigned int lower = 0;
+            unsigned int upper = 0;
+
+            while (lower < len && ((int*) array->data)[lower] < target) {
+                lower++;
+            }
+            upper = lower;
+            while (upper < len && ((int*) array->data)[upper] <= target) {
+                upper++;
+            }
+
+            ck_assert_uint_eq(g_array_lower_bound(array, &target, compare_int_values), lower);
+            ck_assert_uint_eq(g_array_upper_bound(array, &target, compare_int_values), upper);
+            ck_assert_uint_eq(g_array_lower_bound_i32(array, target), lower);
+            ck_assert_uint_eq(g_array_upper_bound_i32(array, target), upper);
+
+            unsigned int begin;
+            unsigned int end;
+            bool found = g_array_equal_range(array, &target, compare_int_values, &begin, &end);
+            ck_assert_int_eq(found, lower < upper);
+            ck_assert_uint_eq(begin, lower);
+            ck_assert_uint_eq(end, upper);
+        }
+
+        g_array_free(array, true);
+    }
+}
+END_TEST
+
+START_TEST(test_garray_bounds_batch)
+{
+    GArray *array = NULL;
+    int targets[100];
+    unsigned int lower[100];
+    unsigned int upper[100];
+
+    array = g_array_new(false, false, sizeof(int));
+    for (int i = 0; i < 1000; i++) {
+        int val = (i / 2) * 2;
+        g_array_append_val(array, val);
+    }
+
+    for (int i = 0; i < 100; i++) {
+        targets[i] = (i * 37) % 1010 - 5;
+    }
+
+    g_array_lower_bound_batch(array, targets, 100, compare_int_values, lower);
+    g_array_upper_bound_batch(array, targets, 100, compare_int_values, upper);
+
+    for (int i = 0; i < 100; i++) {
+        ck_assert_uint_eq(lower[i], g_array_lower_bound(array, &targets[i], compare_int_values));
+        ck_assert_uint_eq(upper[i], g_array_upper_bound(array, &targets[i], compare_int_values));
+    }
+
+    g_array_lower_bound_batch_i32(array, targets, 100, lower);
+    g_array_upper_bound_batch_i32(array, targets, 100, upper);
+
+    for (int i = 0; i < 100; i++) {
+        ck_assert_uint_eq(lower[i], g_array_lower_bound(array, &targets[i], compare_int_values));
+        ck_assert_uint_eq(upper[i], g_array_upper_bound(array, &targets[i], compare_int_values));
+    }
+
+    g_array_free(array, true);
+
+    // unsigned 64 bit keys above the signed range
+    uint64_t vals[] = {1, 5, 0x8000000000000000ULL, 0xffffffffffffffffULL};
+    uint64_t targets64[] = {0, 5, 0x8000000000000001ULL, 0xffffffffffffffffULL};
+    unsigned int expected64[] = {0, 1, 3, 3};
+    array = g_array_new(false, false, sizeof(uint64_t));
+    g_array_append_vals(array, vals, 4);
+
+    g_array_lower_bound_batch_u64(array, targets64, 4, lower);
+    for (int i = 0; i < 4; i++) {
+        ck_assert_uint_eq(lower[i], expected64[i]);
+        ck_assert_uint_eq(g_array_lower_bound_u64(array, targets64[i]), expected64[i]);
+    }
+    ck_assert_uint_eq(g_array_upper_bound_u64(array, 0xffffffffffffffffULL), 4);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+static void create_temp_file(char *path, const uint32_t *vals, size_t len)
+{
+    int fd = mkstemp(path);
+    FILE *f;
+
+    ck_assert_int_ge(fd, 0);
+    close(fd);
+
+    if (len == 0) {
+        return;
+    }
+
+    f = fopen(path, "wb");
+    ck_assert_ptr_nonnull(f);
+    ck_assert_int_eq(fwrite(vals, sizeof(uint32_t), len, f), len);
+    fclose(f);
+}
+
+START_TEST(test_garray_new_from_file)
+{
+    char path[] = "/tmp/test_garray_XXXXXX";
+    uint32_t vals[1000];
+    uint32_t val = 4242;
+    GArray *array;
+
+    for (int i = 0; i < 1000; i++) {
+        vals[i] = 999 - i;
+    }
+    create_temp_file(path, vals, 1000);
+
+    array = g_array_new_from_file(path, sizeof(uint32_t), false);
+    ck_assert_ptr_nonnull(array);
+    ck_assert_int_eq(array->len, 1000);
+    for (int i = 0; i < 1000; i++) {
+        ck_assert_int_eq(((uint32_t*) array->data)[i], 999 - i);
+    }
+
+    // sorting a read-only array doesn't change the file
+    g_array_sort(array, compare_int_values);
+    for (int i = 0; i < 1000; i++) {
+        ck_assert_int_eq(((uint32_t*) array->data)[i], i);
+    }
+
+    // growing turns it into a normal array
+    g_array_append_val(array, val);
+    ck_assert_int_eq(array->_fd, -1);
+    ck_assert_int_eq(array->len, 1001);
+    for (int i = 0; i < 1000; i++) {
+        ck_assert_int_eq(((uint32_t*) array->data)[i], i);
+    }
+    ck_assert_int_eq(((uint32_t*) array->data)[1000], 4242);
+    g_array_free(array, true);
+
+    array = g_array_new_from_file(path, sizeof(uint32_t), false);
+    ck_assert_int_eq(array->len, 1000);
+    for (int i = 0; i < 1000; i++) {
+        ck_assert_int_eq(((uint32_t*) array->data)[i], 999 - i);
+    }
+    g_array_free(array, true);
+
+    // the file size has to be a multiple of the element size
+    ck_assert_ptr_null(g_array_new_from_file(path, 3, false));
+    ck_assert_ptr_null(g_array_new_from_file(path, 0, false));
+
+    unlink(path);
+    ck_assert_ptr_null(g_array_new_from_file(path, sizeof(uint32_t), false));
+}
+END_TEST
+
+START_TEST(test_garray_new_from_file_writable)
+{
+    char path[] = "/tmp/test_garray_XXXXXX";
+    GArray *array;
+    uint32_t *data;
+    struct stat st;
+
+    create_temp_file(path, NULL, 0);
+
+    array = g_array_new_from_file(path, sizeof(uint32_t), true);
+    ck_assert_ptr_nonnull(array);
+    ck_assert_int_eq(array->len, 0);
+
+    for (uint32_t i = 0; i < 10000; i++) {
+        g_array_append_val(array, i);
+    }
+    ck_assert(g_array_sync(array));
+    g_array_free(array, true);
+
+    // the unused capacity is cut off when the array is freed
+    ck_assert_int_eq(stat(path, &st), 0);
+    ck_assert_int_eq(st.st_size, 10000 * sizeof(uint32_t));
+
+    array = g_array_new_from_file(path, sizeof(uint32_t), true);
+    ck_assert_int_eq(array->len, 10000);
+    for (uint32_t i = 0; i < 10000; i++) {
+        ck_assert_int_eq(((uint32_t*) array->data)[i], i);
+    }
+    ((uint32_t*) array->data)[0] = 4242;
+    g_array_remove_range(array, 5000, 5000);
+    g_array_shrink_to_fit(array);
+    g_array_free(array, true);
+
+    array = g_array_new_from_file(path, sizeof(uint32_t), false);
+    ck_assert_int_eq(array->len, 5000);
+    ck_assert_int_eq(((uint32_t*) array->data)[0], 4242);
+    ck_assert_int_eq(((uint32_t*) array->data)[4999], 4999);
+
+    // the stolen data is a copy and the file stays as it is
+    data = (uint32_t*) g_array_free(array, false);
+    ck_assert_int_eq(data[4999], 4999);
+    g_free(data);
+
+    ck_assert_int_eq(stat(path, &st), 0);
+    ck_assert_int_eq(st.st_size, 5000 * sizeof(uint32_t));
+
+    unlink(path);
+}
+END_TEST
+#endif
+
+START_TEST(test_garray_set_size_clear)
+{
+    GArray *array = g_array_new(false, true, sizeof(int));
+    int *data;
+
+    for (int i = 1; i <= 100; i++) {
+        g_array_append_val(array, i);
+    }
+
+    // the removed elements must not show up again
+    g_array_remove_range(array, 10, 90);
+    g_array_set_size(array, 100);
+    data = (int*) array->data;
+    for (int i = 0; i < 10; i++) {
+        ck_assert_int_eq(data[i], i + 1);
+    }
+    for (int i = 10; i < 100; i++) {
+        ck_assert_int_eq(data[i], 0);
+    }
+
+    // large enough for fresh pages from calloc or mmap
+    for (int i = 10; i < 100; i++) {
+        data[i] = i;
+    }
+    g_array_set_size(array, 50);
+    g_array_set_size(array, 20000000);
+    data = (int*) array->data;
+    for (int i = 0; i < 10; i++) {
+        ck_assert_int_eq(data[i], i + 1);
+    }
+    for (int i = 10; i < 50; i++) {
+        ck_assert_int_eq(data[i], i);
+    }
+    for (int i = 50; i < 20000000; i += 997) {
+        ck_assert_int_eq(data[i], 0);
+    }
+    ck_assert_int_eq(data[19999999], 0);
+
+    g_array_free(array, true);
+
+    // neither must they in the gap when inserting past the end
+    int vals[] = {7, 7, 7, 7, 7, 7, 7, 7, 7, 7};
+    int expected[] = {7, 7, 0, 0, 0, 7};
+    int v = 7;
+    array = g_array_new(false, true, sizeof(int));
+    g_array_append_vals(array, vals, 10);
+    g_array_set_size(array, 2);
+    g_array_insert_val(array, 5, v);
+    ck_assert_int_eq(array->len, 6);
+    ck_assert_int_eq(memcmp(array->data, expected, sizeof(expected)), 0);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_small)
+{
+    G_ARRAY_SMALL(int, 8) small = G_ARRAY_SMALL_INITIALIZER(small, false, false);
+    GArray *array = &small.array;
+    int *data;
+
+    ck_assert_int_eq(array->len, 0);
+    ck_assert_int_eq(g_array_get_element_size(array), sizeof(int));
+
+    for (int i = 0; i < 8; i++) {
+        g_array_append_val(array, i);
+    }
+    ck_assert_ptr_eq(array->data, small.inline_data);
+
+    // spills to the heap
+    for (int i = 8; i < 100; i++) {
+        g_array_append_val(array, i);
+    }
+    ck_assert_ptr_ne(array->data, small.inline_data);
+    ck_assert_int_eq(array->len, 100);
+    for (int i = 0; i < 100; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i);
+    }
+
+    g_array_free(array, true);
+
+    // inline data is copied when it is handed over
+    g_array_small_init(&small, true, false);
+    for (int i = 0; i < 5; i++) {
+        g_array_prepend_val(array, i);
+    }
+    g_array_shrink_to_fit(array);
+    ck_assert_ptr_eq(array->data, small.inline_data);
+
+    data = (int*) g_array_free(array, false);
+    ck_assert_ptr_ne(data, small.inline_data);
+    for (int i = 0; i < 5; i++) {
+        ck_assert_int_eq(data[i], 4 - i);
+    }
+    ck_assert_int_eq(data[5], 0);
+    g_free(data);
+}
+END_TEST
+
+START_TEST(test_garray_small_clear)
+{
+    G_ARRAY_SMALL(int, 4) small = G_ARRAY_SMALL_INITIALIZER(small, true, true);
+    GArray *array = &small.array;
+    int val = 42;
+
+    g_array_set_size(array, 3);
+    ck_assert_ptr_eq(array->data, small.inline_data);
+    for (int i = 0; i < 4; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], 0);
+    }
+
+    g_array_append_val(array, val);
+    g_array_set_size(array, 1000);
+    ck_assert_int_eq(((int*) array->data)[3], 42);
+    for (int i = 4; i <= 1000; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], 0);
+    }
+
+    g_array_free(array, true);
+}
+END_TEST
+
+static bool is_even(const void *element, void *user_data)
+{
+    return *(const uint32_t*) element % 2 == 0;
+}
+
+static bool is_key_below(const void *element, void *user_data)
+{
+    return ((const SortRecord*) element)->key < (uint64_t) *(int*) user_data;
+}
+
+START_TEST(test_garray_find)
+{
+    GArray *array32 = g_array_new(false, false, sizeof(uint32_t));
+    GArray *array64 = g_array_new(false, false, sizeof(uint64_t));
+    GArray *arrayf = g_array_new(false, false, sizeof(float));
+    unsigned int index;
+
+    ck_assert(!g_array_find_u32(array32, 0, &index));
+    ck_assert(!g_array_find_u64(array64, 0, &index));
+    ck_assert(!g_array_find_f32(arrayf, 0.0f, &index));
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t v32 = i * 3;
+        uint64_t v64 = ((uint64_t) i << 32) | (i * 3);
+        float vf = i * 0.25f;
+
+        g_array_append_val(array32, v32);
+        g_array_append_val(array64, v64);
+        g_array_append_val(arrayf, vf);
+    }
+
+    // every position, so both the vector blocks and the tail are covered
+    for (uint32_t i = 0; i < 1000; i++) {
+        ck_assert(g_array_find_u32(array32, i * 3, &index));
+        ck_assert_uint_eq(index, i);
+        ck_assert(g_array_find_u64(array64, ((uint64_t) i << 32) | (i * 3), &index));
+        ck_assert_uint_eq(index, i);
+        ck_assert(g_array_find_f32(arrayf, i * 0.25f, &index));
+        ck_assert_uint_eq(index, i);
+    }
+
+    ck_assert(!g_array_find_u32(array32, 1, NULL));
+    // the lower half matches but the upper one doesn't
+    ck_assert(!g_array_find_u64(array64, 3, NULL));
+    ck_assert(!g_array_find_f32(arrayf, 0.1f, NULL));
+    ck_assert(!g_array_find_f32(arrayf, NAN, NULL));
+
+    // first match wins
+    ((uint32_t*) array32->data)[700] = 3;
+    ck_assert(g_array_find_u32(array32, 3, &index));
+    ck_assert_uint_eq(index, 1);
+
+    // the element size has to fit
+    ck_assert(!g_array_find_u64(array32, 0, &index));
+
+    g_array_free(array32, true);
+    g_array_free(array64, true);
+    g_array_free(arrayf, true);
+}
+END_TEST
+
+START_TEST(test_garray_count_if)
+{
+    GArray *array = g_array_new(false, false, sizeof(uint32_t));
+    GArray *records = g_array_new(false, false, sizeof(SortRecord));
+    int limit = 10;
+
+    ck_assert_uint_eq(g_array_count_if(array, is_even, NULL), 0);
+
+    for (uint32_t i = 0; i < 999; i++) {
+        SortRecord rec = {i % 20, i};
+
+        g_array_append_val(array, i);
+        g_array_append_val(records, rec);
+    }
+
+    ck_assert_uint_eq(g_array_count_if(array, is_even, NULL), 500);
+    ck_assert_uint_eq(g_array_count_if(records, is_key_below, &limit), 500);
+
+    ck_assert_uint_eq(g_array_count_range_u32(array, 0, UINT32_MAX), 999);
+    ck_assert_uint_eq(g_array_count_range_u32(array, 100, 199), 100);
+    ck_assert_uint_eq(g_array_count_range_u32(array, 998, 2000), 1);
+    ck_assert_uint_eq(g_array_count_range_u32(array, 5, 5), 1);
+    ck_assert_uint_eq(g_array_count_range_u32(array, 2000, 3000), 0);
+    ck_assert_uint_eq(g_array_count_range_u32(array, 10, 5), 0);
+
+    g_array_free(array, true);
+    g_array_free(records, true);
+}
+END_TEST
+
+START_TEST(test_garray_filter)
+{
+    GArray *array = g_array_new(true, false, sizeof(uint32_t));
+    GArray *records = g_array_new(false, false, sizeof(SortRecord));
+    GArray *result;
+    uint32_t big = 4000000000u;
+    int limit = 3;
+
+    for (uint32_t i = 0; i < 1001; i++) {
+        SortRecord rec = {i % 20, i};
+
+        g_array_append_val(array, i);
+        g_array_append_val(records, rec);
+    }
+    g_array_append_val(array, big);
+
+    result = g_array_filter(array, is_even, NULL);
+    ck_assert_uint_eq(result->len, 502);
+    ck_assert_uint_eq(g_array_get_element_size(result), sizeof(uint32_t));
+    for (unsigned int i = 0; i < 501; i++) {
+        ck_assert_uint_eq(((uint32_t*) result->data)[i], i * 2);
+    }
+    ck_assert_uint_eq(((uint32_t*) result->data)[501], big);
+    // zero-terminated like the source
+    ck_assert_uint_eq(((uint32_t*) result->data)[502], 0);
+    g_array_free(result, true);
+
+    result = g_array_filter(records, is_key_below, &limit);
+    ck_assert_uint_eq(result->len, 151);
+    for (unsigned int i = 0; i < result->len; i++) {
+        ck_assert_uint_lt(((SortRecord*) result->data)[i].key, 3);
+    }
+    g_array_free(result, true);
+
+    result = g_array_filter_range_u32(array, 100, 355);
+    ck_assert_uint_eq(result->len, 256);
+    for (unsigned int i = 0; i < 256; i++) {
+        ck_assert_uint_eq(((uint32_t*) result->data)[i], 100 + i);
+    }
+    ck_assert_uint_eq(((uint32_t*) result->data)[256], 0);
+    g_array_free(result, true);
+
+    result = g_array_filter_range_u32(array, 1000, UINT32_MAX);
+    ck_assert_uint_eq(result->len, 2);
+    ck_assert_uint_eq(((uint32_t*) result->data)[0], 1000);
+    ck_assert_uint_eq(((uint32_t*) result->data)[1], big);
+    g_array_free(result, true);
+
+    result = g_array_filter_range_u32(array, 0, UINT32_MAX);
+    ck_assert_uint_eq(result->len, array->len);
+    ck_assert_int_eq(memcmp(result->data, array->data, array->len * sizeof(uint32_t)), 0);
+    g_array_free(result, true);
+
+    result = g_array_filter_range_u32(array, 5000, 6000);
+    ck_assert_uint_eq(result->len, 0);
+    g_array_free(result, true);
+
+    g_array_free(array, true);
+    g_array_free(records, true);
+
+    // results of cleared arrays are zero when they grow again
+    array = g_array_new(false, true, sizeof(uint32_t));
+    for (uint32_t i = 1; i <= 16; i++) {
+        g_array_append_val(array, i);
+    }
+
+    result = g_array_filter_range_u32(array, 1, 8);
+    ck_assert_uint_eq(result->len, 8);
+    g_array_set_size(result, 0);
+    g_array_set_size(result, 8);
+    for (unsigned int i = 0; i < 8; i++) {
+        ck_assert_uint_eq(((uint32_t*) result->data)[i], 0);
+    }
+
+    g_array_free(result, true);
+    g_array_free(array, true);
+}
+END_TEST
+
+static int compare_uint32_values(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*) a;
+    uint32_t y = *(const uint32_t*) b;
+
+    return (x > y) - (x < y);
+}
+
+static int compare_record_keys(const void *a, const void *b)
+{
+    uint64_t x = ((const SortRecord*) a)->key;
+    uint64_t y = ((const SortRecord*) b)->key;
+
+    return (x > y) - (x < y);
+}
+
+static GArray* create_sequence_u32(unsigned int len, uint32_t step, uint32_t offset)
+{
+    GArray *array = g_array_new(false, false, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t val = i * step + offset;
+        g_array_append_val(array, val);
+    }
+
+    return array;
+}
+
+static void check_set_result(GArray *result, GArray *a, GArray *b, int op)
+{
+    static bool in_a[100000];
+    static bool in_b[100000];
+    unsigned int n = 0;
+
+    memset(in_a, 0, sizeof(in_a));
+    memset(in_b, 0, sizeof(in_b));
+    for (unsigned int i = 0; i < a->len; i++) {
+        in_a[((uint32_t*) a->data)[i]] = true;
+    }
+    for (unsigned int i = 0; i < b->len; i++) {
+        in_b[((uint32_t*) b->data)[i]] = true;
+    }
+
+    // 0 intersect, 1 union, 2 difference, 3 merge
+    for (uint32_t v = 0; v < 100000; v++) {
+        int copies = op == 0 ? in_a[v] && in_b[v] : op == 1 ? in_a[v] || in_b[v] :
+            op == 2 ? in_a[v] && !in_b[v] : in_a[v] + in_b[v];
+
+        for (int k = 0; k < copies; k++) {
+            ck_assert_uint_lt(n, result->len);
+            ck_assert_uint_eq(((uint32_t*) result->data)[n], v);
+            n++;
+        }
+    }
+
+    ck_assert_uint_eq(n, result->len);
+    g_array_free(result, true);
+}
+
+START_TEST(test_garray_sorted_set_ops)
+{
+    // similar sizes, skewed sizes in both directions and empty arrays
+    unsigned int sizes[][6] = {
+        {1000, 2, 0, 700, 3, 1},
+        {10000, 3, 5, 9000, 3, 2},
+        {500, 7, 0, 500, 7, 0},
+        {20, 97, 3, 30000, 3, 0},
+        {30000, 3, 0, 20, 97, 3},
+        {0, 1, 0, 100, 1, 0},
+        {100, 1, 0, 0, 1, 0}
+    };
+
+    for (unsigned int t = 0; t < sizeof(sizes) / sizeof(sizes[0]); t++) {
+        GArray *a = create_sequence_u32(sizes[t][0], sizes[t][1], sizes[t][2]);
+        GArray *b = create_sequence_u32(sizes[t][3], sizes[t][4], sizes[t][5]);
+
+        check_set_result(g_array_sorted_intersect_u32(a, b), a, b, 0);
+        check_set_result(g_array_sorted_union_u32(a, b), a, b, 1);
+        check_set_result(g_array_sorted_difference_u32(a, b), a, b, 2);
+        check_set_result(g_array_sorted_merge_u32(a, b), a, b, 3);
+
+        check_set_result(g_array_sorted_intersect(a, b, compare_uint32_values), a, b, 0);
+        check_set_result(g_array_sorted_union(a, b, compare_uint32_values), a, b, 1);
+        check_set_result(g_array_sorted_difference(a, b, compare_uint32_values), a, b, 2);
+        check_set_result(g_array_sorted_merge(a, b, compare_uint32_values), a, b, 3);
+
+        g_array_free(a, true);
+        g_array_free(b, true);
+    }
+}
+END_TEST
+
+START_TEST(test_garray_sorted_intersect_skewed_blocks)
+{
+    // the matches all sit in the last blocks of a, so the result fills up
+    // while the SIMD loop still has blocks of a left
+    uint32_t a1[] = {1, 2, 5, 6, 7, 8, 9, 10};
+    uint32_t b1[] = {5, 6, 7, 8};
+    uint32_t a2[] = {1, 2, 3, 4, 5, 6, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18};
+    uint32_t b2[] = {9, 10, 11, 12, 13, 14, 15, 16};
+    GArray *a = g_array_new(false, false, sizeof(uint32_t));
+    GArray *b = g_array_new(false, false, sizeof(uint32_t));
+
+    g_array_append_vals(a, a1, sizeof(a1) / sizeof(a1[0]));
+    g_array_append_vals(b, b1, sizeof(b1) / sizeof(b1[0]));
+    check_set_result(g_array_sorted_intersect_u32(a, b), a, b, 0);
+
+    g_array_set_size(a, 0);
+    g_array_set_size(b, 0);
+    g_array_append_vals(a, a2, sizeof(a2) / sizeof(a2[0]));
+    g_array_append_vals(b, b2, sizeof(b2) / sizeof(b2[0]));
+    check_set_result(g_array_sorted_intersect_u32(a, b), a, b, 0);
+    check_set_result(g_array_sorted_intersect_u32(b, a), b, a, 0);
+
+    g_array_free(a, true);
+    g_array_free(b, true);
+}
+END_TEST
+
+START_TEST(test_garray_sorted_intersect_duplicates)
+{
+    // the inputs should be sets, but runs of equal values in a must not make
+    // the result overflow, neither with blocks of 4 nor of 8
+    uint32_t a1[] = {0, 2, 3, 3, 3, 3, 4, 4, 7, 8, 8, 8, 10, 10, 13, 14, 17, 18, 18, 21, 21, 22, 25, 25, 28,
+        29, 29, 33, 33, 33, 34, 36, 36, 36, 38, 38, 39, 40, 40, 42, 42, 46, 46, 46, 47, 47, 48, 48, 48, 49};
+    uint32_t b1[] = {0, 2, 3, 6, 27, 28, 39, 43, 44, 47, 48, 49};
+    uint32_t a2[] = {0, 0, 1, 2, 2, 3, 3, 3, 4, 4, 6, 7, 7, 8, 8, 9, 10, 12, 17, 21, 21, 21, 21, 25, 25, 27, 27,
+        27, 29, 30, 31, 31, 32, 33, 34, 34, 35, 35, 36, 37, 39, 39, 40, 40, 41, 41, 41, 43, 43, 43, 46, 47, 48,
+        50, 51, 54, 54, 56, 57, 58, 59};
+    uint32_t b2[] = {2, 7, 12, 16, 17, 20, 25, 29, 30, 33, 34, 38, 39, 40, 41, 42, 43, 45, 46, 55, 58};
+    uint32_t *a_vals[] = {a1, a2};
+    uint32_t *b_vals[] = {b1, b2};
+    unsigned int a_lens[] = {sizeof(a1) / sizeof(a1[0]), sizeof(a2) / sizeof(a2[0])};
+    unsigned int b_lens[] = {sizeof(b1) / sizeof(b1[0]), sizeof(b2) / sizeof(b2[0])};
+
+    for (int t = 0; t < 2; t++) {
+        GArray *a = g_array_new(false, false, sizeof(uint32_t));
+        GArray *b = g_array_new(false, false, sizeof(uint32_t));
+        GArray *result;
+
+        g_array_append_vals(a, a_vals[t], a_lens[t]);
+        g_array_append_vals(b, b_vals[t], b_lens[t]);
+        result = g_array_sorted_intersect_u32(a, b);
+
+        ck_assert_uint_le(result->len, b->len);
+        for (unsigned int i = 0; i < result->len; i++) {
+            uint32_t val = ((uint32_t*) result->data)[i];
+
+            ck_assert(g_array_binary_search(a, &val, compare_uint32_values, NULL));
+            ck_assert(g_array_binary_search(b, &val, compare_uint32_values, NULL));
+        }
+
+        g_array_free(result, true);
+        g_array_free(a, true);
+        g_array_free(b, true);
+    }
+}
+END_TEST
+
+START_TEST(test_garray_sorted_set_ops_typed)
+{
+    GArray *a = g_array_new(true, false, sizeof(int64_t));
+    GArray *b = g_array_new(false, false, sizeof(int64_t));
+    GArray *u32 = g_array_new(false, false, sizeof(uint32_t));
+    GArray *result;
+
+    for (int64_t v = -5; v <= 5; v += 2) {
+        g_array_append_val(a, v);
+    }
+    for (int64_t v = -4; v <= 1; v++) {
+        g_array_append_val(b, v);
+    }
+
+    result = g_array_sorted_intersect_i64(a, b);
+    ck_assert_uint_eq(result->len, 3);
+    ck_assert_int_eq(((int64_t*) result->data)[0], -3);
+    ck_assert_int_eq(((int64_t*) result->data)[1], -1);
+    ck_assert_int_eq(((int64_t*) result->data)[2], 1);
+    // zero-terminated like a
+    ck_assert_int_eq(((int64_t*) result->data)[3], 0);
+    g_array_free(result, true);
+
+    result = g_array_sorted_union_i64(a, b);
+    ck_assert_uint_eq(result->len, 9);
+    ck_assert_int_eq(((int64_t*) result->data)[0], -5);
+    ck_assert_int_eq(((int64_t*) result->data)[1], -4);
+    ck_assert_int_eq(((int64_t*) result->data)[8], 5);
+    g_array_free(result, true);
+
+    result = g_array_sorted_difference_i64(a, b);
+    ck_assert_uint_eq(result->len, 3);
+    ck_assert_int_eq(((int64_t*) result->data)[0], -5);
+    ck_assert_int_eq(((int64_t*) result->data)[1], 3);
+    ck_assert_int_eq(((int64_t*) result->data)[2], 5);
+    g_array_free(result, true);
+
+    result = g_array_sorted_merge_i64(a, b);
+    ck_assert_uint_eq(result->len, 12);
+    g_array_free(result, true);
+
+    // the element sizes have to match
+    ck_assert_ptr_null(g_array_sorted_intersect_i64(a, u32));
+    ck_assert_ptr_null(g_array_sorted_union_u32(a, b));
+
+    g_array_free(a, true);
+    g_array_free(b, true);
+    g_array_free(u32, true);
+}
+END_TEST
+
+START_TEST(test_garray_sorted_set_ops_records)
+{
+    GArray *a = g_array_new(false, false, sizeof(SortRecord));
+    GArray *b = g_array_new(false, false, sizeof(SortRecord));
+    GArray *result;
+    SortRecord *data;
+
+    // a has keys 0, 2, 4, ... with payload 1, b keys 0, 3, 6, ... with payload 2
+    for (uint64_t i = 0; i < 100; i++) {
+        SortRecord rec_a = {i * 2, 1};
+        SortRecord rec_b = {i * 3, 2};
+
+        g_array_append_val(a, rec_a);
+        g_array_append_val(b, rec_b);
+    }
+
+    // elements that are in both arrays are taken from a
+    result = g_array_sorted_intersect(a, b, compare_record_keys);
+    ck_assert_uint_eq(result->len, 34);
+    data = (SortRecord*) result->data;
+    for (unsigned int i = 0; i < result->len; i++) {
+        ck_assert_uint_eq(data[i].key, i * 6);
+        ck_assert_uint_eq(data[i].payload, 1);
+    }
+    g_array_free(result, true);
+
+    result = g_array_sorted_union(a, b, compare_record_keys);
+    ck_assert_uint_eq(result->len, 166);
+    data = (SortRecord*) result->data;
+    for (unsigned int i = 0; i < result->len; i++) {
+        ck_assert_uint_eq(data[i].payload, data[i].key % 2 == 0 && data[i].key < 200 ? 1 : 2);
+    }
+    g_array_free(result, true);
+
+    // merging keeps all elements and puts the ones of a first
+    result = g_array_sorted_merge(a, b, compare_record_keys);
+    ck_assert_uint_eq(result->len, 200);
+    data = (SortRecord*) result->data;
+    for (unsigned int i = 1; i < result->len; i++) {
+        ck_assert_uint_le(data[i - 1].key, data[i].key);
+        if (data[i - 1].key == data[i].key) {
+            ck_assert_uint_eq(data[i - 1].payload, 1);
+            ck_assert_uint_eq(data[i].payload, 2);
+        }
+    }
+    g_array_free(result, true);
+
+    // the same with a much larger b, where b is searched instead
+    for (uint64_t i = 100; i < 10000; i++) {
+        SortRecord rec_b = {i * 3, 2};
+        g_array_append_val(b, rec_b);
+    }
+    g_array_set_size(a, 20);
+
+    result = g_array_sorted_intersect(a, b, compare_record_keys);
+    ck_assert_uint_eq(result->len, 7);
+    for (unsigned int i = 0; i < result->len; i++) {
+        ck_assert_uint_eq(((SortRecord*) result->data)[i].payload, 1);
+    }
+    g_array_free(result, true);
+
+    result = g_array_sorted_merge(b, a, compare_record_keys);
+    ck_assert_uint_eq(result->len, 10020);
+    data = (SortRecord*) result->data;
+    for (unsigned int i = 1; i < result->len; i++) {
+        ck_assert_uint_le(data[i - 1].key, data[i].key);
+        if (data[i - 1].key == data[i].key) {
+            ck_assert_uint_eq(data[i - 1].payload, 2);
+            ck_assert_uint_eq(data[i].payload, 1);
+        }
+    }
+    g_array_free(result, true);
+
+    g_array_free(a, true);
+    g_array_free(b, true);
+}
+END_TEST
+
+START_TEST(test_garray_merge_k)
+{
+    GArray *runs[37];
+    GArray *result;
+    SortRecord *data;
+    uint64_t seed = 7;
+    unsigned int total = 0;
+
+    // runs of different lengths, some empty, with many equal keys; the
+    // payload is the index of the run
+    for (unsigned int r = 0; r < 37; r++) {
+        unsigned int len = (r * 7) % 50;
+        uint64_t key = 0;
+
+        runs[r] = g_array_new(false, true, sizeof(SortRecord));
+        for (unsigned int i = 0; i < len; i++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            key += (seed >> 33) % 3;
+            SortRecord rec = {key, r};
+            g_array_append_val(runs[r], rec);
+        }
+        total += len;
+    }
+
+    result = g_array_merge_k(runs, 37, compare_record_keys);
+    ck_assert_uint_eq(result->len, total);
+    data = (SortRecord*) result->data;
+    for (unsigned int i = 1; i < result->len; i++) {
+        ck_assert_uint_le(data[i - 1].key, data[i].key);
+        // equal keys keep the order of the runs
+        if (data[i - 1].key == data[i].key) {
+            ck_assert_uint_le(data[i - 1].payload, data[i].payload);
+        }
+    }
+
+    // the result is cleared like the runs, also after shrinking and growing
+    g_array_set_size(result, 0);
+    g_array_set_size(result, total);
+    for (unsigned int i = 0; i < total; i++) {
+        ck_assert_uint_eq(((SortRecord*) result->data)[i].key, 0);
+    }
+    g_array_free(result, true);
+
+    // a single array is copied
+    result = g_array_merge_k(&runs[1], 1, compare_record_keys);
+    ck_assert_uint_eq(result->len, runs[1]->len);
+    ck_assert_int_eq(memcmp(result->data, runs[1]->data, runs[1]->len * sizeof(SortRecord)), 0);
+    g_array_free(result, true);
+
+    ck_assert_ptr_null(g_array_merge_k(runs, 0, compare_record_keys));
+
+    for (unsigned int r = 0; r < 37; r++) {
+        g_array_free(runs[r], true);
+    }
+}
+END_TEST
+
+START_TEST(test_garray_merger)
+{
+    GArray *runs[5];
+    GArray *wide;
+    GArrayMerger *merger;
+    uint32_t buffer[7];
+    uint32_t next = 0;
+    unsigned int n;
+
+    // run r has r, r + 5, r + 10, ...
+    for (uint32_t r = 0; r < 5; r++) {
+        runs[r] = g_array_new(false, false, sizeof(uint32_t));
+        for (uint32_t v = r; v < 1000; v += 5) {
+            g_array_append_val(runs[r], v);
+        }
+    }
+
+    merger = g_array_merger_new(runs, 5, compare_uint32_values);
+    ck_assert_uint_eq(merger->remaining, 1000);
+
+    while ((n = g_array_merger_next(merger, buffer, 7)) > 0) {
+        ck_assert_uint_le(n, 7);
+        for (unsigned int i = 0; i < n; i++) {
+            ck_assert_uint_eq(buffer[i], next);
+            next++;
+        }
+    }
+
+    ck_assert_uint_eq(next, 1000);
+    ck_assert_uint_eq(merger->remaining, 0);
+    g_array_merger_free(merger);
+
+    // all element sizes have to match
+    wide = g_array_new(false, false, sizeof(uint64_t));
+    g_array_free(runs[3], true);
+    runs[3] = wide;
+    ck_assert_ptr_null(g_array_merger_new(runs, 5, compare_uint32_values));
+
+    for (uint32_t r = 0; r < 5; r++) {
+        g_array_free(runs[r], true);
+    }
+}
+END_TEST
+
+static unsigned int records_cleared[100];
+static unsigned int num_range_calls;
+
+static void clear_record(void *data)
+{
+    records_cleared[((SortRecord*) data)->key]++;
+}
+
+static void clear_record_range(void *first, size_t count)
+{
+    num_range_calls++;
+    for (size_t i = 0; i < count; i++) {
+        records_cleared[((SortRecord*) first)[i].key]++;
+    }
+}
+
+static GArray* create_records(unsigned int len)
+{
+    GArray *array = g_array_new(false, false, sizeof(SortRecord));
+
+    memset(records_cleared, 0, sizeof(records_cleared));
+    num_range_calls = 0;
+
+    for (uint64_t i = 0; i < len; i++) {
+        SortRecord rec = {i, i};
+        g_array_append_val(array, rec);
+    }
+
+    return array;
+}
+
+// Checks that exactly the records from begin to end - 1 were cleared once
+static void check_records_cleared(unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = 0; i < 100; i++) {
+        ck_assert_uint_eq(records_cleared[i], i >= begin && i < end ? 1 : 0);
+    }
+
+    memset(records_cleared, 0, sizeof(records_cleared));
+}
+
+START_TEST(test_garray_clear_func)
+{
+    GArray *array = create_records(100);
+
+    g_array_set_clear_func(array, clear_record);
+
+    g_array_remove_index(array, 10);
+    check_records_cleared(10, 11);
+    // 99 takes the place of 21
+    g_array_remove_index_fast(array, 20);
+    check_records_cleared(21, 22);
+    g_array_remove_index_fast(array, 20);
+    check_records_cleared(99, 100);
+
+    // 0 to 9, 11 to 20, 98, 22 to 97
+    g_array_remove_range(array, 30, 5);
+    check_records_cleared(31, 36);
+    ck_assert_uint_eq(array->len, 92);
+    ck_assert_uint_eq(((SortRecord*) array->data)[30].key, 36);
+
+    g_array_set_size(array, 80);
+    check_records_cleared(86, 98);
+    g_array_truncate(array, 70);
+    check_records_cleared(76, 86);
+    g_array_truncate(array, 75);
+    check_records_cleared(0, 0);
+    ck_assert_uint_eq(array->len, 70);
+
+    // 0 to 9, 11 to 20, 98, 22 to 30, 36 to 75
+    g_array_remove_range(array, 0, 21);
+    for (unsigned int i = 0; i < 100; i++) {
+        ck_assert_uint_eq(records_cleared[i], (i < 21 && i != 10) || i == 98 ? 1 : 0);
+    }
+    memset(records_cleared, 0, sizeof(records_cleared));
+
+    g_array_free(array, true);
+    for (unsigned int i = 0; i < 100; i++) {
+        ck_assert_uint_eq(records_cleared[i], (i >= 22 && i <= 30) || (i >= 36 && i <= 75) ? 1 : 0);
+    }
+}
+END_TEST
+
+START_TEST(test_garray_clear_range_func)
+{
+    GArray *array = create_records(100);
+
+    g_array_set_clear_range_func(array, clear_record_range);
+    ck_assert_ptr_null(array->_clear_func);
+
+    g_array_remove_range(array, 10, 20);
+    check_records_cleared(10, 30);
+    ck_assert_uint_eq(num_range_calls, 1);
+    ck_assert_uint_eq(((SortRecord*) array->data)[10].key, 30);
+
+    // removing the end is the same as truncating
+    g_array_remove_range(array, 70, 10);
+    check_records_cleared(90, 100);
+    ck_assert_uint_eq(array->len, 70);
+
+    g_array_remove_index(array, 0);
+    check_records_cleared(0, 1);
+
+    g_array_set_size(array, 9);
+    check_records_cleared(30, 90);
+    ck_assert_uint_eq(num_range_calls, 4);
+
+    // a clear function replaces the range function
+    g_array_set_clear_func(array, clear_record);
+    ck_assert_ptr_null(array->_clear_range_func);
+    g_array_set_clear_range_func(array, clear_record_range);
+
+    num_range_calls = 0;
+    g_array_free(array, true);
+    check_records_cleared(1, 10);
+    ck_assert_uint_eq(num_range_calls, 1);
+}
+END_TEST
+
+START_TEST(test_garray_view)
+{
+    GArray *array = g_array_new(false, false, sizeof(int));
+    GArrayView view;
+    GArrayView slice;
+    GArray *copy;
+
+    for (int i = 0; i < 100; i++) {
+        g_array_append_val(array, i);
+    }
+
+    view = g_array_view(array, 10, 50);
+    ck_assert_ptr_eq(view.data, &array->data[10 * sizeof(int)]);
+    ck_assert_uint_eq(view.len, 50);
+    ck_assert_uint_eq(view.element_size, sizeof(int));
+    ck_assert_int_eq(g_array_view_index(view, int, 0), 10);
+    ck_assert_int_eq(g_array_view_index(view, int, 49), 59);
+
+    slice = g_array_view_slice(view, 40, 10);
+    ck_assert_uint_eq(slice.len, 10);
+    ck_assert_int_eq(g_array_view_index(slice, int, 0), 50);
+
+    // changes through the view change the array
+    g_array_view_index(slice, int, 0) = -1;
+    ck_assert_int_eq(((int*) array->data)[50], -1);
+
+    copy = g_array_view_copy(slice);
+    ck_assert_uint_eq(copy->len, 10);
+    ck_assert_int_eq(((int*) copy->data)[0], -1);
+    ck_assert_int_eq(((int*) copy->data)[9], 59);
+    g_array_free(copy, true);
+
+    // ranges outside of the array give empty views
+    ck_assert_uint_eq(g_array_view(array, 100, 0).len, 0);
+    ck_assert_uint_eq(g_array_view(array, 90, 11).len, 0);
+    ck_assert_uint_eq(g_array_view(array, 101, 0).len, 0);
+    ck_assert_uint_eq(g_array_view_slice(view, 45, 10).len, 0);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_view_sort_search)
+{
+    GArray *array = g_array_new(false, false, sizeof(uint32_t));
+    GArrayView view;
+    unsigned int index;
+    uint32_t target;
+
+    // 99, 98, ..., 0
+    for (uint32_t i = 0; i < 100; i++) {
+        uint32_t val = 99 - i;
+        g_array_append_val(array, val);
+    }
+
+    // only elements 20 to 79 are sorted
+    view = g_array_view(array, 20, 60);
+    g_array_view_sort(view, compare_uint32_values);
+    ck_assert_uint_eq(((uint32_t*) array->data)[19], 80);
+    for (uint32_t i = 0; i < 60; i++) {
+        ck_assert_uint_eq(((uint32_t*) array->data)[20 + i], 20 + i);
+    }
+    ck_assert_uint_eq(((uint32_t*) array->data)[80], 19);
+
+    // positions are relative to the view
+    target = 25;
+    ck_assert(g_array_view_binary_search(view, &target, compare_uint32_values, &index));
+    ck_assert_uint_eq(index, 5);
+    ck_assert_uint_eq(g_array_view_lower_bound(view, &target, compare_uint32_values), 5);
+    ck_assert_uint_eq(g_array_view_upper_bound(view, &target, compare_uint32_values), 6);
+    target = 80;
+    ck_assert(!g_array_view_binary_search(view, &target, compare_uint32_values, &index));
+
+    ck_assert(g_array_view_find_u32(view, 79, &index));
+    ck_assert_uint_eq(index, 59);
+    ck_assert(!g_array_view_find_u32(view, 19, &index));
+
+    // a stable sort only moves the elements of the view
+    view = g_array_view(array, 0, 20);
+    g_array_view_stable_sort(view, compare_uint32_values);
+    ck_assert_uint_eq(((uint32_t*) array->data)[0], 80);
+    ck_assert_uint_eq(((uint32_t*) array->data)[19], 99);
+    ck_assert_uint_eq(((uint32_t*) array->data)[20], 20);
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_garray_view_set_ops)
+{
+    GArray *a = create_sequence_u32(1000, 2, 0);
+    GArray *b = create_sequence_u32(1000, 3, 0);
+    GArray *result;
+
+    // 100, 102, ..., 298 and 150, 153, ..., 447
+    GArrayView va = g_array_view(a, 50, 100);
+    GArrayView vb = g_array_view(b, 50, 100);
+
+    result = g_array_view_sorted_intersect_u32(va, vb);
+    ck_assert_uint_eq(result->len, 25);
+    ck_assert_uint_eq(((uint32_t*) result->data)[0], 150);
+    ck_assert_uint_eq(((uint32_t*) result->data)[24], 294);
+    g_array_free(result, true);
+
+    result = g_array_view_sorted_intersect(va, vb, compare_uint32_values);
+    ck_assert_uint_eq(result->len, 25);
+    g_array_free(result, true);
+
+    result = g_array_view_sorted_union_u32(va, vb);
+    ck_assert_uint_eq(result->len, 175);
+    g_array_free(result, true);
+
+    result = g_array_view_sorted_difference(va, vb, compare_uint32_values);
+    ck_assert_uint_eq(result->len, 75);
+    ck_assert_uint_eq(((uint32_t*) result->data)[0], 100);
+    g_array_free(result, true);
+
+    result = g_array_view_sorted_merge_u32(va, g_array_view_slice(vb, 0, 0));
+    ck_assert_uint_eq(result->len, 100);
+    ck_assert_int_eq(memcmp(result->data, va.data, 100 * sizeof(uint32_t)), 0);
+    g_array_free(result, true);
+
+    g_array_free(a, true);
+    g_array_free(b, true);
+}
+END_TEST
+
+static void add_one(void *element, void *user_data)
+{
+    *(int*) element += *(int*) user_data;
+}
+
+START_TEST(test_garray_foreach)
+{
+    GArray *array = NULL;
+    int step = 1;
+
+    array = g_array_new(false, false, sizeof(int));
+    g_array_foreach(array, add_one, &step);
+
+    for (int i = 0; i < 10; i++) {
+        g_array_append_val(array, i);
+    }
+
+    g_array_foreach(array, add_one, &step);
+
+    for (int i = 0; i < 10; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i + 1);
+    }
+
+    g_array_free(array, true);
+}
+END_TEST
+
+typedef struct {
+    uint32_t value;
+    uint32_t visits;
+    uint32_t result;
+} ForeachRecord;
+
+static void score_record(void *element, void *user_data)
+{
+    ForeachRecord *record = (ForeachRecord*) element;
+    uint32_t result = record->value;
+
+    // every 1000th record takes much longer than the others
+    unsigned int rounds = record->value % 1000 == 0 ? 10000 : 1;
+    for (unsigned int i = 0; i < rounds; i++) {
+        result = result * 2654435761u + 1;
+    }
+
+    record->result = result;
+    record->visits++;
+}
+
+START_TEST(test_garray_parallel_foreach)
+{
+    GArray *array = NULL;
+    GArrayThreadPool *pool = NULL;
+    unsigned int thread_counts[] = {0, 1, 2, 3, 8};
+    unsigned int lens[] = {100003, 1000, 1};
+
+    for (int t = 0; t < sizeof(thread_counts) / sizeof(unsigned int); t++) {
+        pool = g_array_thread_pool_new(thread_counts[t]);
+        ck_assert_int_ge(g_array_thread_pool_get_num_threads(pool), 1);
+#ifndef GARRAY_NO_THREADS
+        // more threads than CPUs are started too
+        if (thread_counts[t] > 0) {
+            ck_assert_uint_eq(g_array_thread_pool_get_num_threads(pool), thread_counts[t]);
+        }
+#endif
+
+        // the pool is reused for several arrays
+        for (int l = 0; l < sizeof(lens) / sizeof(unsigned int); l++) {
+            array = g_array_new(false, true, sizeof(ForeachRecord));
+            g_array_set_size(array, lens[l]);
+
+            for (unsigned int i = 0; i < lens[l]; i++) {
+                ((ForeachRecord*) array->data)[i].value = i;
+            }
+
+            g_array_parallel_foreach(array, pool, score_record, NULL);
+
+            for (unsigned int i = 0; i < lens[l]; i++) {
+                ForeachRecord *record = &((ForeachRecord*) array->data)[i];
+                ForeachRecord expected = {i, 0, 0};
+
+                score_record(&expected, NULL);
+                ck_assert_int_eq(record->visits, 1);
+                ck_assert_int_eq(record->result, expected.result);
+            }
+
+            g_array_free(array, true);
+        }
+
+        g_array_thread_pool_free(pool);
+    }
+
+    // absurd thread counts are capped
+    pool = g_array_thread_pool_new(UINT_MAX);
+    ck_assert_uint_le(g_array_thread_pool_get_num_threads(pool), GARRAY_MAX_THREADS);
+    g_array_thread_pool_free(pool);
+
+    // without a pool the calling thread does all the work
+    int step = 2;
+    array = g_array_new(false, false, sizeof(int));
+    for (int i = 0; i < 5000; i++) {
+        g_array_append_val(array, i);
+    }
+
+    g_array_parallel_foreach(array, NULL, add_one, &step);
+
+    for (int i = 0; i < 5000; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i + 2);
+    }
+
+    g_array_free(array, true);
+}
+END_TEST
+
+static void sum_uint64(void *accumulator, const void *element, void *user_data)
+{
+    *(uint64_t*) accumulator += *(const uint32_t*) element;
+}
+
+static void combine_sum_uint64(void *accumulator, const void *other, void *user_data)
+{
+    *(uint64_t*) accumulator += *(const uint64_t*) other;
+}
+
+// Checks that the elements arrive in order, which only holds if the results
+// of the chunks are combined in order
+typedef struct {
+    uint32_t first;
+    uint32_t last;
+    uint32_t count;
+    bool ordered;
+} SequenceResult;
+
+static void reduce_sequence(void *accumulator, const void *element, void *user_data)
+{
+    SequenceResult *result = (SequenceResult*) accumulator;
+    uint32_t value = *(const uint32_t*) element;
+
+    if (result->count == 0) {
+        result->first = value;
+    } else if (value != result->last + 1) {
+        result->ordered = false;
+    }
+
+    result->last = value;
+    result->count++;
+}
+
+static void combine_sequence(void *accumulator, const void *other, void *user_data)
+{
+    SequenceResult *result = (SequenceResult*) accumulator;
+    const SequenceResult *next = (const SequenceResult*) other;
+
+    if (next->count == 0) {
+        return;
+    }
+
+    if (result->count == 0) {
+        *result = *next;
+        return;
+    }
+
+    if (next->first != result->last + 1 || !next->ordered) {
+        result->ordered = false;
+    }
+
+    result->last = next->last;
+    result->count += next->count;
+}
+
+START_TEST(test_garray_parallel_reduce)
+{
+    GArray *array = NULL;
+    GArrayThreadPool *pool = NULL;
+    unsigned int thread_counts[] = {1, 4, 7};
+    unsigned int n = 1000001;
+
+    array = create_sequence_u32(n, 1, 0);
+
+    for (int t = 0; t < sizeof(thread_counts) / sizeof(unsigned int); t++) {
+        pool = g_array_thread_pool_new(thread_counts[t]);
+
+        uint64_t sum = 0;
+        g_array_parallel_reduce(array, pool, &sum, sizeof(sum), sum_uint64, combine_sum_uint64, NULL);
+        ck_assert_uint_eq(sum, (uint64_t) n * (n - 1) / 2);
+
+        SequenceResult sequence = {0, 0, 0, true};
+        g_array_parallel_reduce(array, pool, &sequence, sizeof(sequence), reduce_sequence, combine_sequence, NULL);
+        ck_assert(sequence.ordered);
+        ck_assert_uint_eq(sequence.first, 0);
+        ck_assert_uint_eq(sequence.last, n - 1);
+        ck_assert_uint_eq(sequence.count, n);
+
+        g_array_thread_pool_free(pool);
+    }
+
+    g_array_free(array, true);
+
+    // an empty array leaves the initial value alone
+    array = g_array_new(false, false, sizeof(uint32_t));
+    uint64_t sum = 42;
+    g_array_parallel_reduce(array, NULL, &sum, sizeof(sum), sum_uint64, combine_sum_uint64, NULL);
+    ck_assert_uint_eq(sum, 42);
+    g_array_free(array, true);
+}
+END_TEST
+
+Suite* garray_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GArray");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, test_garray_new);
+    tcase_add_test(tc_core, test_garray_sized_new);
+
+    tcase_add_test(tc_core, test_garray_steal);
+    tcase_add_test(tc_core, test_garray_steal_zero_terminated);
+
+    tcase_add_test(tc_core, test_garray_append_val);
+    tcase_add_test(tc_core, test_garray_append_val_many);
+    tcase_add_test(tc_core, test_garray_append_vals);
+
+    tcase_add_test(tc_core, test_garray_prepend_val);
+    tcase_add_test(tc_core, test_garray_prepend_val_many);
+    tcase_add_test(tc_core, test_garray_prepend_vals);
+
+    tcase_add_test(tc_core, test_garray_insert_val);
+    tcase_add_test(tc_core, test_garray_insert_val_beginning);
+    tcase_add_test(tc_core, test_garray_insert_val_end);
+    tcase_add_test(tc_core, test_garray_insert_vals);
+    tcase_add_test(tc_core, test_garray_insert_vals_non_existing_index);
+    tcase_add_test(tc_core, test_garray_insert_vals_non_existing_index_clear);
+
+    tcase_add_test(tc_core, test_garray_remove_index);
+    tcase_add_test(tc_core, test_garray_remove_index_beginning);
+    tcase_add_test(tc_core, test_garray_remove_index_end);
+
+    tcase_add_test(tc_core, test_garray_remove_index_fast);
+
+    tcase_add_test(tc_core, test_garray_remove_range);
+
+    tcase_add_test(tc_core, test_garray_sort);
+    tcase_add_test(tc_core, test_garray_sort_with_data);
+
+    tcase_add_test(tc_core, test_garray_binary_search_null);
+    tcase_add_test(tc_core, test_garray_binary_search_empty);
+    tcase_add_test(tc_core, test_garray_binary_search_one);
+    tcase_add_test(tc_core, test_garray_binary_search_two);
+    tcase_add_test(tc_core, test_garray_binary_search_three);
+    tcase_add_test(tc_core, test_garray_binary_search_same);
+    tcase_add_test(tc_core, test_garray_binary_search_extensive);
+
+    tcase_add_test(tc_core, test_garray_set_size);
+
+    tcase_add_test(tc_core, test_garray_zero_termination);
+
+    tcase_add_test(tc_core, test_garray_free);
+    tcase_add_test(tc_core, test_garray_free_without_segment);
+
+    tcase_add_test(tc_core, test_garray_memory_usage);
+
+    tcase_add_test(tc_core, test_garray_growth);
+    tcase_add_test(tc_core, test_garray_reserve);
+    tcase_add_test(tc_core, test_garray_shrink_to_fit);
+
+    tcase_add_test(tc_core, test_garray_define_sort);
+    tcase_add_test(tc_core, test_garray_define_sort_records);
+    tcase_add_test(tc_core, test_garray_define_sort_heap_sort);
+
+    tcase_add_test(tc_core, test_garray_radix_sort);
+    tcase_add_test(tc_core, test_garray_radix_sort_float);
+    tcase_add_test(tc_core, test_garray_radix_sort_stable);
+
+    tcase_add_test(tc_core, test_garray_sort_parallel);
+    tcase_add_test(tc_core, test_garray_sort_parallel_with_data);
+
+    tcase_add_test(tc_core, test_garray_stable_sort);
+    tcase_add_test(tc_core, test_garray_stable_sort_with_buffer);
+    tcase_add_test(tc_core, test_garray_stable_sort_with_data);
+
+    tcase_add_test(tc_core, test_garray_search_index);
+    tcase_add_test(tc_core, test_garray_search_index_large);
+
+    tcase_add_test(tc_core, test_garray_bounds);
+    tcase_add_test(tc_core, test_garray_bounds_batch);
+#if !(defined _WIN32 || defined _WIN64 || defined __WINDOWS__)
+    tcase_add_test(tc_core, test_garray_new_from_file);
+    tcase_add_test(tc_core, test_garray_new_from_file_writable);
+#endif
+
+    tcase_add_test(tc_core, test_garray_set_size_clear);
+
+    tcase_add_test(tc_core, test_garray_small);
+    tcase_add_test(tc_core, test_garray_small_clear);
+
+    tcase_add_test(tc_core, test_garray_find);
+    tcase_add_test(tc_core, test_garray_count_if);
+    tcase_add_test(tc_core, test_garray_filter);
+
+    tcase_add_test(tc_core, test_garray_sorted_set_ops);
+    tcase_add_test(tc_core, test_garray_sorted_intersect_skewed_blocks);
+    tcase_add_test(tc_core, test_garray_sorted_intersect_duplicates);
+    tcase_add_test(tc_core, test_garray_sorted_set_ops_typed);
+    tcase_add_test(tc_core, test_garray_sorted_set_ops_records);
+
+    tcase_add_test(tc_core, test_garray_merge_k);
+    tcase_add_test(tc_core, test_garray_merger);
+
+    tcase_add_test(tc_core, test_garray_clear_func);
+    tcase_add_test(tc_core, test_garray_clear_range_func);
+
+    tcase_add_test(tc_core, test_garray_view);
+    tcase_add_test(tc_core, test_garray_view_sort_search);
+    tcase_add_test(tc_core, test_garray_view_set_ops);
+
+    tcase_add_test(tc_core, test_garray_foreach);
+    tcase_add_test(tc_core, test_garray_parallel_foreach);
+    tcase_add_test(tc_core, test_garray_parallel_reduce);
 
     suite_add_tcase(s, tc_core);
 
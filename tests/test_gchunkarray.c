@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <check.h>
+
+#define _CLIB_IMPL 1
+#include "gchunkarray.h"
+
+static int num_cleared = 0;
+
+static void clear_int(void *data)
+{
+    ck_assert_int_ge(*(int*) data, 0);
+    num_cleared++;
+}
+
+START_TEST(test_g_chunk_array_new)
+{
+    GChunkArray *array = g_chunk_array_new(sizeof(int));
+
+    ck_assert_ptr_nonnull(array);
+    ck_assert_int_eq(array->len, 0);
+    ck_assert_int_eq(array->_chunk_mask + 1, GCHUNKARRAY_CHUNK_BYTES / sizeof(int));
+    g_chunk_array_free(array);
+
+    // rounded up to a power of two
+    array = g_chunk_array_sized_new(sizeof(int), 100);
+    ck_assert_int_eq(array->_chunk_mask + 1, 128);
+    g_chunk_array_free(array);
+
+    ck_assert_ptr_null(g_chunk_array_new(0));
+    ck_assert_ptr_null(g_chunk_array_sized_new(0, 100));
+}
+END_TEST
+
+START_TEST(test_g_chunk_array_append)
+{
+    GChunkArray *array = g_chunk_array_sized_new(sizeof(int), 16);
+
+    for (int i = 0; i < 1000; i++) {
+        g_chunk_array_append_val(array, i);
+    }
+
+    ck_assert_int_eq(array->len, 1000);
+    ck_assert_int_eq(array->_num_chunks, 63);
+
+    for (int i = 0; i < 1000; i++) {
+        ck_assert_int_eq(g_chunk_array_index(array, int, i), i);
+        ck_assert_int_eq(*(int*) g_chunk_array_index_ptr(array, i), i);
+    }
+
+    g_chunk_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_chunk_array_append_vals)
+{
+    GChunkArray *array = g_chunk_array_sized_new(sizeof(int), 8);
+    int vals[50];
+
+    for (int i = 0; i < 50; i++) {
+        vals[i] = i;
+    }
+
+    // spans several chunks and starts in the middle of one
+    g_chunk_array_append_vals(array, vals, 3);
+    g_chunk_array_append_vals(array, vals, 50);
+    g_chunk_array_append_vals(array, vals, 0);
+
+    ck_assert_int_eq(array->len, 53);
+    ck_assert_int_eq(array->_num_chunks, 7);
+    for (int i = 0; i < 3; i++) {
+        ck_assert_int_eq(g_chunk_array_index(array, int, i), i);
+    }
+    for (int i = 0; i < 50; i++) {
+        ck_assert_int_eq(g_chunk_array_index(array, int, i + 3), i);
+    }
+
+    g_chunk_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_chunk_array_stable_pointers)
+{
+    GChunkArray *array = g_chunk_array_sized_new(sizeof(int), 4);
+    int *first;
+    int *tenth;
+
+    for (int i = 0; i < 10; i++) {
+        g_chunk_array_append_val(array, i);
+    }
+
+    first = g_chunk_array_index_ptr(array, 0);
+    tenth = g_chunk_array_index_ptr(array, 9);
+
+    for (int i = 10; i < 10000; i++) {
+        g_chunk_array_append_val(array, i);
+    }
+
+    ck_assert_ptr_eq(first, g_chunk_array_index_ptr(array, 0));
+    ck_assert_ptr_eq(tenth, g_chunk_array_index_ptr(array, 9));
+    ck_assert_int_eq(*first, 0);
+    ck_assert_int_eq(*tenth, 9);
+
+    g_chunk_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_chunk_array_truncate)
+{
+    GChunkArray *array = g_chunk_array_sized_new(sizeof(int), 8);
+
+    g_chunk_array_set_clear_func(array, clear_int);
+
+    for (int i = 0; i < 30; i++) {
+        g_chunk_array_append_val(array, i);
+    }
+
+    num_cleared = 0;
+    g_chunk_array_truncate(array, 50);
+    ck_assert_int_eq(num_cleared, 0);
+    ck_assert_int_eq(array->len, 30);
+
+    g_chunk_array_truncate(array, 9);
+    ck_assert_int_eq(num_cleared, 21);
+    ck_assert_int_eq(array->len, 9);
+    ck_assert_int_eq(array->_num_chunks, 2);
+
+    for (int i = 9; i < 20; i++) {
+        g_chunk_array_append_val(array, i);
+    }
+    for (int i = 0; i < 20; i++) {
+        ck_assert_int_eq(g_chunk_array_index(array, int, i), i);
+    }
+
+    g_chunk_array_truncate(array, 16);
+    ck_assert_int_eq(array->_num_chunks, 2);
+
+    num_cleared = 0;
+    g_chunk_array_free(array);
+    ck_assert_int_eq(num_cleared, 16);
+}
+END_TEST
+
+START_TEST(test_g_chunk_array_to_array)
+{
+    GChunkArray *array = g_chunk_array_sized_new(sizeof(int), 8);
+    GArray *result;
+
+    result = g_chunk_array_to_array(array);
+    ck_assert_int_eq(result->len, 0);
+    g_array_free(result, true);
+
+    for (int i = 0; i < 29; i++) {
+        g_chunk_array_append_val(array, i);
+    }
+
+    result = g_chunk_array_to_array(array);
+    ck_assert_int_eq(result->len, 29);
+    ck_assert_int_eq(g_array_get_element_size(result), sizeof(int));
+    for (int i = 0; i < 29; i++) {
+        ck_assert_int_eq(((int*) result->data)[i], i);
+    }
+
+    g_array_free(result, true);
+    g_chunk_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_chunk_array_memory_usage)
+{
+    GChunkArray *array = g_chunk_array_sized_new(sizeof(int), 8);
+    GMemUsage usage;
+
+    for (int i = 0; i < 10; i++) {
+        g_chunk_array_append_val(array, i);
+    }
+
+    g_chunk_array_memory_usage(array, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GChunkArray) + 8 * sizeof(char*) + 16 * sizeof(int));
+    ck_assert_int_eq(usage.used, 10 * sizeof(int));
+    ck_assert_int_eq(usage.overhead, usage.allocated - usage.used);
+
+    g_chunk_array_free(array);
+}
+END_TEST
+
+Suite* gchunkarray_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GChunkArray");
+
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, test_g_chunk_array_new);
+    tcase_add_test(tc_core, test_g_chunk_array_append);
+    tcase_add_test(tc_core, test_g_chunk_array_append_vals);
+    tcase_add_test(tc_core, test_g_chunk_array_stable_pointers);
+    tcase_add_test(tc_core, test_g_chunk_array_truncate);
+    tcase_add_test(tc_core, test_g_chunk_array_to_array);
+    tcase_add_test(tc_core, test_g_chunk_array_memory_usage);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = gchunkarray_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
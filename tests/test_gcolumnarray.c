@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <check.h>
+
+#define _CLIB_IMPL 1
+#include "gcolumnarray.h"
+
+static const unsigned int column_sizes[] = {sizeof(uint32_t), sizeof(double), sizeof(char)};
+
+static GColumnArray* create_rows(unsigned int num_rows)
+{
+    GColumnArray *array = g_column_array_new(3, column_sizes);
+
+    for (unsigned int i = 0; i < num_rows; i++) {
+        uint32_t id = i;
+        double value = i * 0.5;
+        char tag = 'a' + i % 26;
+        const void *row[] = {&id, &value, &tag};
+
+        g_column_array_append_row(array, row);
+    }
+
+    return array;
+}
+
+static void check_row(GColumnArray *array, unsigned int index, uint32_t id)
+{
+    ck_assert_int_eq(g_column_array_index(array, 0, uint32_t, index), id);
+    ck_assert_double_eq(g_column_array_index(array, 1, double, index), id * 0.5);
+    ck_assert_int_eq(g_column_array_index(array, 2, char, index), 'a' + id % 26);
+}
+
+static int compare_char(const void *a, const void *b)
+{
+    return *(const char*) a - *(const char*) b;
+}
+
+static int compare_double_direction(const void *a, const void *b, void *user_data)
+{
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    int direction = *(int*) user_data;
+
+    return direction * ((x > y) - (x < y));
+}
+
+START_TEST(test_g_column_array_new)
+{
+    GColumnArray *array = g_column_array_new(3, column_sizes);
+
+    ck_assert_int_eq(array->len, 0);
+    ck_assert_int_eq(array->num_columns, 3);
+    for (unsigned int i = 0; i < 3; i++) {
+        ck_assert_int_eq(g_array_get_element_size(g_column_array_get_column(array, i)), column_sizes[i]);
+        ck_assert_int_eq(g_column_array_get_column(array, i)->len, 0);
+    }
+
+    g_column_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_column_array_append_row)
+{
+    GColumnArray *array = create_rows(1000);
+
+    ck_assert_int_eq(array->len, 1000);
+    for (unsigned int i = 0; i < 3; i++) {
+        ck_assert_int_eq(g_column_array_get_column(array, i)->len, 1000);
+    }
+
+    for (unsigned int i = 0; i < 1000; i++) {
+        check_row(array, i, i);
+    }
+
+    g_column_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_column_array_remove)
+{
+    GColumnArray *array = create_rows(10);
+
+    g_column_array_remove_row(array, 0);
+    ck_assert_int_eq(array->len, 9);
+    check_row(array, 0, 1);
+
+    g_column_array_remove_range(array, 2, 3);
+    ck_assert_int_eq(array->len, 6);
+    check_row(array, 1, 2);
+    check_row(array, 2, 6);
+
+    g_column_array_remove_row_fast(array, 0);
+    ck_assert_int_eq(array->len, 5);
+    check_row(array, 0, 9);
+    check_row(array, 1, 2);
+
+    for (unsigned int i = 0; i < 3; i++) {
+        ck_assert_int_eq(g_column_array_get_column(array, i)->len, 5);
+    }
+
+    g_column_array_set_size(array, 20);
+    ck_assert_int_eq(array->len, 20);
+    ck_assert_int_eq(g_column_array_get_column(array, 2)->len, 20);
+
+    g_column_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_column_array_sort_by_column)
+{
+    GColumnArray *array = create_rows(100);
+    int direction = -1;
+
+    g_column_array_sort_by_column_with_data(array, 1, compare_double_direction, &direction);
+    for (unsigned int i = 0; i < 100; i++) {
+        check_row(array, i, 99 - i);
+    }
+
+    // stable, so rows with the same tag stay in descending order of their id
+    g_column_array_sort_by_column(array, 2, compare_char);
+    for (unsigned int i = 1; i < 100; i++) {
+        char prev_tag = g_column_array_index(array, 2, char, i - 1);
+        char tag = g_column_array_index(array, 2, char, i);
+
+        ck_assert_int_le(prev_tag, tag);
+        if (prev_tag == tag) {
+            ck_assert_int_gt(g_column_array_index(array, 0, uint32_t, i - 1),
+                g_column_array_index(array, 0, uint32_t, i));
+        }
+    }
+
+    for (unsigned int i = 0; i < 100; i++) {
+        check_row(array, i, g_column_array_index(array, 0, uint32_t, i));
+    }
+
+    g_column_array_free(array);
+}
+END_TEST
+
+START_TEST(test_g_column_array_memory_usage)
+{
+    GColumnArray *array = create_rows(10);
+    GMemUsage usage;
+
+    g_column_array_memory_usage(array, &usage);
+    ck_assert_int_eq(usage.used, 10 * (sizeof(uint32_t) + sizeof(double) + sizeof(char)));
+    ck_assert_int_ge(usage.allocated, sizeof(GColumnArray) + 3 * sizeof(GArray) + usage.used);
+    ck_assert_int_eq(usage.overhead, usage.allocated - usage.used);
+
+    g_column_array_free(array);
+}
+END_TEST
+
+Suite* gcolumnarray_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GColumnArray");
+
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, test_g_column_array_new);
+    tcase_add_test(tc_core, test_g_column_array_append_row);
+    tcase_add_test(tc_core, test_g_column_array_remove);
+    tcase_add_test(tc_core, test_g_column_array_sort_by_column);
+    tcase_add_test(tc_core, test_g_column_array_memory_usage);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = gcolumnarray_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
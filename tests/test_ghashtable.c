@@ -462,6 +462,41 @@ START_TEST(test_ghashtable_free_keys_and_values)
 }
 END_TEST
 
+START_TEST(test_ghashtable_memory_usage)
+{
+    GHashTable *htable = NULL;
+    GMemUsage usage;
+
+    htable = g_hash_table_new(g_int_hash, g_int_equal);
+
+    g_hash_table_memory_usage(htable, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GHashTable) + GHASHTABLE_MIN_SLOTS * sizeof(struct GHashTableSlot));
+    ck_assert_int_eq(usage.used, 0);
+    ck_assert_int_eq(usage.overhead, usage.allocated);
+
+    for (uint64_t i = 1; i <= 10; i++) {
+        g_hash_table_insert(htable, (void*) i, (void*) i);
+    }
+
+    g_hash_table_memory_usage(htable, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GHashTable) + GHASHTABLE_MIN_SLOTS * sizeof(struct GHashTableSlot));
+    ck_assert_int_eq(usage.used, 10 * 2 * sizeof(void*));
+    ck_assert_int_eq(usage.overhead, usage.allocated - usage.used);
+
+    // trigger a resize
+    for (uint64_t i = 11; i <= GHASHTABLE_MIN_SLOTS; i++) {
+        g_hash_table_insert(htable, (void*) i, (void*) i);
+    }
+
+    g_hash_table_memory_usage(htable, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GHashTable) + htable->num_slots * sizeof(struct GHashTableSlot));
+    ck_assert_int_gt(htable->num_slots, GHASHTABLE_MIN_SLOTS);
+    ck_assert_int_eq(usage.used, GHASHTABLE_MIN_SLOTS * 2 * sizeof(void*));
+
+    g_hash_table_destroy(htable);
+}
+END_TEST
+
 Suite* ghashtable_suite(void)
 {
     Suite *s;
@@ -497,6 +532,8 @@ Suite* ghashtable_suite(void)
 
     tcase_add_test(tc_core, test_ghashtable_free_keys_and_values);
 
+    tcase_add_test(tc_core, test_ghashtable_memory_usage);
+
     suite_add_tcase(s, tc_core);
 
     return s;
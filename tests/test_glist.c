@@ -966,6 +966,30 @@ START_TEST(test_glist_index)
 }
 END_TEST
 
+START_TEST(test_glist_memory_usage)
+{
+    GList *list = NULL;
+    GMemUsage usage;
+
+    g_list_memory_usage(list, &usage);
+    ck_assert_int_eq(usage.allocated, 0);
+    ck_assert_int_eq(usage.used, 0);
+    ck_assert_int_eq(usage.overhead, 0);
+
+    list = g_list_append(list, "Element 1");
+    list = g_list_append(list, "Element 2");
+    list = g_list_append(list, "Element 3");
+
+    // works from any element of the list
+    g_list_memory_usage(g_list_last(list), &usage);
+    ck_assert_int_eq(usage.allocated, 3 * sizeof(GList));
+    ck_assert_int_eq(usage.used, 3 * sizeof(void*));
+    ck_assert_int_eq(usage.overhead, 3 * (sizeof(GList) - sizeof(void*)));
+
+    g_list_free(list);
+}
+END_TEST
+
 Suite* glist_suite(void)
 {
     Suite *s;
@@ -1032,6 +1056,8 @@ Suite* glist_suite(void)
 
     tcase_add_test(tc_core, test_glist_index);
 
+    tcase_add_test(tc_core, test_glist_memory_usage);
+
     suite_add_tcase(s, tc_core);
 
     return s;
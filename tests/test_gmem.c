@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <check.h>
+
+#define _CLIB_IMPL 1
+#define CLIB_MEM_STATS 1
+#define GMEM_MREMAP_THRESHOLD (64 * 1024)
+#include "garray.h"
+#include "ghashtable.h"
+#include "glist.h"
+#include "gstring.h"
+
+START_TEST(test_gmem_stats_reset)
+{
+    GMemStats stats;
+    GArray *array = g_array_new(false, false, sizeof(int));
+
+    g_mem_stats_reset();
+
+    for (int i = 0; i < G_MEM_STATS_NUM_TYPES; i++) {
+        g_mem_stats_get(i, &stats);
+        ck_assert_int_eq(stats.live_bytes, 0);
+        ck_assert_int_eq(stats.alloc_calls, 0);
+        ck_assert_int_eq(stats.realloc_calls, 0);
+        ck_assert_int_eq(stats.free_calls, 0);
+    }
+
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_gmem_stats_array)
+{
+    GMemStats stats;
+    GMemUsage usage;
+    GArray *array = NULL;
+
+    g_mem_stats_reset();
+
+    array = g_array_new(false, false, sizeof(int));
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    ck_assert_int_eq(stats.live_bytes, sizeof(GArray));
+    ck_assert_int_eq(stats.alloc_calls, 1);
+
+    int vals[] = {34, 82, 43, 12, 71};
+    g_array_append_vals(array, vals, sizeof(vals) / sizeof(int));
+    g_array_append_vals(array, vals, sizeof(vals) / sizeof(int));
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    g_array_memory_usage(array, &usage);
+    ck_assert_int_eq(stats.live_bytes, usage.allocated);
+    ck_assert_int_eq(stats.alloc_calls, 2);
+    ck_assert_int_eq(stats.realloc_calls, 1);
+    ck_assert_int_eq(stats.free_calls, 0);
+
+    g_array_free(array, true);
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    ck_assert_int_eq(stats.live_bytes, 0);
+    ck_assert_int_eq(stats.free_calls, 2);
+
+    // other types are not affected
+    g_mem_stats_get(G_MEM_STATS_STRING, &stats);
+    ck_assert_int_eq(stats.alloc_calls, 0);
+}
+END_TEST
+
+START_TEST(test_gmem_stats_array_steal)
+{
+    GMemStats stats;
+    GArray *array = NULL;
+    size_t len;
+
+    g_mem_stats_reset();
+
+    array = g_array_new(false, false, sizeof(int));
+
+    int vals[] = {34, 82, 43, 12, 71};
+    g_array_append_vals(array, vals, sizeof(vals) / sizeof(int));
+
+    // stolen data is not held by the array anymore
+    void *data = g_array_steal(array, &len);
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    ck_assert_int_eq(stats.live_bytes, sizeof(GArray));
+
+    g_free(data);
+    g_array_free(array, true);
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    ck_assert_int_eq(stats.live_bytes, 0);
+}
+END_TEST
+
+START_TEST(test_gmem_stats_array_small)
+{
+    GMemStats stats;
+    G_ARRAY_SMALL(int, 8) small;
+    GArray *array = g_array_small_init(&small, false, false);
+
+    g_mem_stats_reset();
+
+    for (int i = 0; i < 8; i++) {
+        g_array_append_val(array, i);
+    }
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    ck_assert_int_eq(stats.alloc_calls, 0);
+    ck_assert_int_eq(stats.live_bytes, 0);
+
+    g_array_append_val(array, small.inline_data[0]);
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    ck_assert_int_eq(stats.alloc_calls, 1);
+    ck_assert_int_eq(stats.live_bytes, 16 * sizeof(int));
+
+    g_array_free(array, true);
+
+    g_mem_stats_get(G_MEM_STATS_ARRAY, &stats);
+    ck_assert_int_eq(stats.live_bytes, 0);
+}
+END_TEST
+
+START_TEST(test_gmem_stats_hash_table)
+{
+    GMemStats stats;
+    GMemUsage usage;
+    GHashTable *htable = NULL;
+
+    g_mem_stats_reset();
+
+    htable = g_hash_table_new(g_int_hash, g_int_equal);
+
+    for (uint64_t i = 1; i <= 1000; i++) {
+        g_hash_table_insert(htable, (void*) i, (void*) i);
+    }
+
+    g_mem_stats_get(G_MEM_STATS_HASH_TABLE, &stats);
+    g_hash_table_memory_usage(htable, &usage);
+    ck_assert_int_eq(stats.live_bytes, usage.allocated);
+    ck_assert_int_gt(stats.alloc_calls, 2);
+    ck_assert_int_eq(stats.free_calls, stats.alloc_calls - 2);
+
+    g_hash_table_destroy(htable);
+
+    g_mem_stats_get(G_MEM_STATS_HASH_TABLE, &stats);
+    ck_assert_int_eq(stats.live_bytes, 0);
+    ck_assert_int_eq(stats.free_calls, stats.alloc_calls);
+}
+END_TEST
+
+START_TEST(test_gmem_stats_list)
+{
+    GMemStats stats;
+    GList *list = NULL;
+
+    g_mem_stats_reset();
+
+    list = g_list_append(list, "Element 1");
+    list = g_list_append(list, "Element 2");
+    list = g_list_prepend(list, "Element 0");
+
+    g_mem_stats_get(G_MEM_STATS_LIST, &stats);
+    ck_assert_int_eq(stats.live_bytes, 3 * sizeof(GList));
+    ck_assert_int_eq(stats.alloc_calls, 3);
+
+    list = g_list_delete_link(list, list);
+
+    g_mem_stats_get(G_MEM_STATS_LIST, &stats);
+    ck_assert_int_eq(stats.live_bytes, 2 * sizeof(GList));
+    ck_assert_int_eq(stats.free_calls, 1);
+
+    g_list_free(list);
+
+    g_mem_stats_get(G_MEM_STATS_LIST, &stats);
+    ck_assert_int_eq(stats.live_bytes, 0);
+    ck_assert_int_eq(stats.free_calls, 3);
+}
+END_TEST
+
+START_TEST(test_gmem_stats_string)
+{
+    GMemStats stats;
+    GMemUsage usage;
+    GString *string = NULL;
+
+    g_mem_stats_reset();
+
+    string = g_string_new("Hello");
+    g_string_append(string, " World, this string is longer than the minimum buffer size");
+
+    g_mem_stats_get(G_MEM_STATS_STRING, &stats);
+    g_string_memory_usage(string, &usage);
+    ck_assert_int_eq(stats.live_bytes, usage.allocated);
+    ck_assert_int_eq(stats.alloc_calls, 2);
+    ck_assert_int_eq(stats.realloc_calls, 1);
+
+    g_string_free(string, true);
+
+    g_mem_stats_get(G_MEM_STATS_STRING, &stats);
+    ck_assert_int_eq(stats.live_bytes, 0);
+    ck_assert_int_eq(stats.free_calls, 2);
+}
+END_TEST
+
+static int tracking_live_blocks;
+
+static void* tracking_malloc(size_t n_bytes)
+{
+    tracking_live_blocks++;
+    return malloc(n_bytes);
+}
+
+static void* tracking_realloc(void *mem, size_t n_bytes)
+{
+    if (mem == NULL) {
+        tracking_live_blocks++;
+    }
+
+    return realloc(mem, n_bytes);
+}
+
+static void tracking_free(void *mem)
+{
+    tracking_live_blocks--;
+    free(mem);
+}
+
+START_TEST(test_gmem_vtable)
+{
+    GMemVTable vtable = {tracking_malloc, tracking_realloc, tracking_free, NULL, NULL, NULL};
+    char *segment;
+
+    tracking_live_blocks = 0;
+    g_mem_set_vtable(&vtable);
+
+    GArray *array = g_array_new(true, true, sizeof(int));
+    for (int i = 0; i < 100; i++) {
+        g_array_append_val(array, i);
+    }
+
+    GHashTable *htable = g_hash_table_new(g_int_hash, g_int_equal);
+    g_hash_table_insert(htable, (void*) 1, (void*) "one");
+
+    GList *list = g_list_append(NULL, (void*) "one");
+    list = g_list_append(list, (void*) "two");
+
+    GString *string = g_string_new("Hello");
+    g_string_append(string, " World");
+
+    ck_assert_int_eq(tracking_live_blocks, 2 + 2 + 2 + 2);
+
+    g_array_free(array, true);
+    g_hash_table_destroy(htable);
+    g_list_free(list);
+    segment = g_string_free(string, false);
+    ck_assert_int_eq(tracking_live_blocks, 1);
+    ck_assert_str_eq(segment, "Hello World");
+
+    g_free(segment);
+    ck_assert_int_eq(tracking_live_blocks, 0);
+
+    g_mem_set_vtable(NULL);
+}
+END_TEST
+
+// bump allocator: every block is preceded by its size so realloc can copy it,
+// free does nothing and everything is released at once by resetting the arena
+static size_t arena[8 * 1024];
+static size_t arena_used;
+
+static void* arena_malloc(size_t n_bytes)
+{
+    size_t *block = &arena[arena_used];
+    size_t n_words = (n_bytes + sizeof(size_t) - 1) / sizeof(size_t);
+
+    if (arena_used + 1 + n_words > sizeof(arena) / sizeof(size_t)) {
+        return NULL;
+    }
+
+    arena_used += 1 + n_words;
+    block[0] = n_bytes;
+
+    return &block[1];
+}
+
+static void* arena_realloc(void *mem, size_t n_bytes)
+{
+    void *new_mem = arena_malloc(n_bytes);
+
+    if (mem != NULL && new_mem != NULL) {
+        size_t old_size = ((size_t*) mem)[-1];
+        memcpy(new_mem, mem, old_size < n_bytes ? old_size : n_bytes);
+    }
+
+    return new_mem;
+}
+
+static void arena_free(void *mem)
+{
+}
+
+START_TEST(test_gmem_vtable_arena)
+{
+    GMemVTable vtable = {arena_malloc, arena_realloc, arena_free, NULL, NULL, NULL};
+
+    arena_used = 0;
+    g_mem_set_vtable(&vtable);
+
+    GArray *array = g_array_sized_new(false, true, sizeof(int), 1000);
+    for (int i = 0; i < 1000; i++) {
+        g_array_append_val(array, i);
+    }
+
+    GString *string = g_string_new(NULL);
+    for (int i = 0; i < 100; i++) {
+        g_string_append_c(string, 'a');
+    }
+
+    ck_assert_int_eq(array->len, 1000);
+    for (int i = 0; i < 1000; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i);
+    }
+    ck_assert_int_eq(string->len, 100);
+    ck_assert((void*) array->data > (void*) arena);
+    ck_assert((void*) array->data < (void*) &arena[sizeof(arena) / sizeof(size_t)]);
+
+    // no need to free anything individually
+    arena_used = 0;
+
+    g_mem_set_vtable(NULL);
+}
+END_TEST
+
+START_TEST(test_gmem_malloc0)
+{
+    char *mem = g_malloc0(64);
+
+    for (int i = 0; i < 64; i++) {
+        ck_assert_int_eq(mem[i], 0);
+    }
+
+    ck_assert_ptr_null(g_malloc(0));
+
+    mem = g_realloc(mem, 128);
+    mem = g_realloc(mem, 0);
+    ck_assert_ptr_null(mem);
+}
+END_TEST
+
+START_TEST(test_gmem_mremap_array)
+{
+    GArray *array = g_array_new(true, false, sizeof(int));
+    int *data;
+
+    for (int i = 0; i < 100000; i++) {
+        g_array_append_val(array, i);
+    }
+
+#ifdef _G_MEM_MREMAP
+    ck_assert(array->_mapped);
+#endif
+    for (int i = 0; i < 100000; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i);
+    }
+    ck_assert_int_eq(((int*) array->data)[100000], 0);
+
+    // back below the threshold
+    g_array_set_size(array, 10);
+    g_array_shrink_to_fit(array);
+    ck_assert(!array->_mapped);
+    for (int i = 0; i < 10; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], i);
+    }
+
+    for (int i = 10; i < 50000; i++) {
+        g_array_append_val(array, i);
+    }
+
+    // the mapping is handed over without a copy, the caller resizes and
+    // frees it with g_realloc() and g_free()
+    char *mapping = array->data;
+    data = (int*) g_array_free(array, false);
+    ck_assert_ptr_eq(data, mapping);
+    for (int i = 0; i < 50000; i++) {
+        ck_assert_int_eq(data[i], i);
+    }
+    ck_assert_int_eq(data[50000], 0);
+
+    data = g_realloc(data, 200000 * sizeof(int));
+    for (int i = 0; i < 50000; i++) {
+        ck_assert_int_eq(data[i], i);
+    }
+    data[199999] = 1;
+    g_free(data);
+
+    array = g_array_sized_new(false, true, sizeof(int), 100000);
+#ifdef _G_MEM_MREMAP
+    ck_assert(array->_mapped);
+#endif
+    for (int i = 0; i < 100000; i++) {
+        ck_assert_int_eq(((int*) array->data)[i], 0);
+    }
+    g_array_free(array, true);
+}
+END_TEST
+
+START_TEST(test_gmem_mremap_string)
+{
+    GString *string = g_string_new(NULL);
+    char *str;
+
+    for (int i = 0; i < 10000; i++) {
+        g_string_append(string, "0123456789");
+    }
+
+#ifdef _G_MEM_MREMAP
+    ck_assert(string->_mapped);
+#endif
+    ck_assert_int_eq(string->len, 100000);
+    ck_assert_int_eq(string->str[99999], '9');
+    ck_assert_int_eq(string->str[100000], '\0');
+
+    str = g_string_free(string, false);
+    ck_assert_int_eq(strlen(str), 100000);
+    g_free(str);
+}
+END_TEST
+
+Suite* gmem_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GMem");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, test_gmem_stats_reset);
+
+    tcase_add_test(tc_core, test_gmem_stats_array);
+    tcase_add_test(tc_core, test_gmem_stats_array_steal);
+    tcase_add_test(tc_core, test_gmem_stats_array_small);
+    tcase_add_test(tc_core, test_gmem_stats_hash_table);
+    tcase_add_test(tc_core, test_gmem_stats_list);
+    tcase_add_test(tc_core, test_gmem_stats_string);
+
+    tcase_add_test(tc_core, test_gmem_vtable);
+    tcase_add_test(tc_core, test_gmem_vtable_arena);
+    tcase_add_test(tc_core, test_gmem_malloc0);
+    tcase_add_test(tc_core, test_gmem_mremap_array);
+    tcase_add_test(tc_core, test_gmem_mremap_string);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = gmem_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <check.h>
+
+#define _CLIB_IMPL 1
+#include "gqueuearray.h"
+
+static int num_cleared = 0;
+
+static void clear_int(void *data)
+{
+    ck_assert_int_ge(*(int*) data, 0);
+    num_cleared++;
+}
+
+START_TEST(test_g_queue_array_new)
+{
+    GQueueArray *queue = g_queue_array_new(sizeof(int));
+
+    ck_assert_ptr_nonnull(queue);
+    ck_assert_int_eq(queue->len, 0);
+    ck_assert_ptr_null(g_queue_array_peek_head(queue));
+    ck_assert_ptr_null(g_queue_array_peek_tail(queue));
+    ck_assert(!g_queue_array_pop_head(queue, NULL));
+    ck_assert(!g_queue_array_pop_tail(queue, NULL));
+
+    g_queue_array_free(queue);
+
+    queue = g_queue_array_sized_new(sizeof(int), 100);
+    ck_assert_int_eq(queue->len, 0);
+    ck_assert_int_eq(queue->_allocated_elements, 128);
+    g_queue_array_free(queue);
+}
+END_TEST
+
+START_TEST(test_g_queue_array_push_pop)
+{
+    GQueueArray *queue = g_queue_array_new(sizeof(int));
+    int val;
+
+    for (int i = 0; i < 1000; i++) {
+        g_queue_array_push_tail_val(queue, i);
+    }
+
+    ck_assert_int_eq(queue->len, 1000);
+    ck_assert_int_eq(*(int*) g_queue_array_peek_head(queue), 0);
+    ck_assert_int_eq(*(int*) g_queue_array_peek_tail(queue), 999);
+
+    for (int i = 0; i < 500; i++) {
+        ck_assert(g_queue_array_pop_head(queue, &val));
+        ck_assert_int_eq(val, i);
+    }
+
+    for (int i = 999; i >= 500; i--) {
+        ck_assert(g_queue_array_pop_tail(queue, &val));
+        ck_assert_int_eq(val, i);
+    }
+
+    ck_assert_int_eq(queue->len, 0);
+    ck_assert(!g_queue_array_pop_head(queue, &val));
+
+    for (int i = 0; i < 1000; i++) {
+        g_queue_array_push_head_val(queue, i);
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        ck_assert_int_eq(g_queue_array_index(queue, int, i), 999 - i);
+    }
+
+    g_queue_array_free(queue);
+}
+END_TEST
+
+START_TEST(test_g_queue_array_wrap_around)
+{
+    GQueueArray *queue = g_queue_array_new(sizeof(int));
+    int val;
+
+    // keep the queue at 6 elements while its head moves through the buffer
+    for (int i = 0; i < 6; i++) {
+        g_queue_array_push_tail_val(queue, i);
+    }
+
+    for (int i = 6; i < 100; i++) {
+        g_queue_array_push_tail_val(queue, i);
+        ck_assert(g_queue_array_pop_head(queue, &val));
+        ck_assert_int_eq(val, i - 6);
+
+        ck_assert_int_eq(queue->len, 6);
+        ck_assert_int_eq(queue->_allocated_elements, 8);
+        for (int j = 0; j < 6; j++) {
+            ck_assert_int_eq(g_queue_array_index(queue, int, j), i - 5 + j);
+        }
+    }
+
+    // grow while the elements wrap around
+    int vals[] = {100, 101, 102, 103, 104, 105, 106, 107, 108, 109};
+    ck_assert_int_gt(queue->_head + queue->len, queue->_allocated_elements);
+    g_queue_array_push_tail_vals(queue, vals, sizeof(vals) / sizeof(int));
+
+    ck_assert_int_eq(queue->len, 16);
+    ck_assert_int_eq(queue->_allocated_elements, 16);
+    for (int i = 0; i < 16; i++) {
+        ck_assert_int_eq(g_queue_array_index(queue, int, i), 94 + i);
+    }
+
+    g_queue_array_free(queue);
+}
+END_TEST
+
+START_TEST(test_g_queue_array_push_head_vals)
+{
+    GQueueArray *queue = g_queue_array_new(sizeof(int));
+    int vals[] = {1, 2, 3};
+    int more_vals[] = {-2, -1, 0};
+
+    g_queue_array_push_head_vals(queue, vals, 3);
+    g_queue_array_push_head_vals(queue, more_vals, 3);
+    g_queue_array_push_head_vals(queue, NULL, 0);
+
+    ck_assert_int_eq(queue->len, 6);
+    for (int i = 0; i < 6; i++) {
+        ck_assert_int_eq(g_queue_array_index(queue, int, i), i - 2);
+    }
+
+    g_queue_array_free(queue);
+}
+END_TEST
+
+START_TEST(test_g_queue_array_linearize)
+{
+    GQueueArray *queue = g_queue_array_new(sizeof(int));
+    int *data;
+
+    ck_assert_ptr_null(g_queue_array_linearize(queue));
+
+    // wrapped: head at the end of the buffer, tail at the start
+    for (int i = 0; i < 5; i++) {
+        g_queue_array_push_tail_val(queue, i);
+    }
+    for (int i = -1; i >= -3; i--) {
+        g_queue_array_push_head_val(queue, i);
+    }
+
+    ck_assert_int_eq(queue->_head, 5);
+    data = (int*) g_queue_array_linearize(queue);
+    ck_assert_int_eq(queue->_head, 0);
+    for (int i = 0; i < 8; i++) {
+        ck_assert_int_eq(data[i], i - 3);
+    }
+
+    // contiguous but not at the start of the buffer
+    ck_assert(g_queue_array_pop_head(queue, NULL));
+    ck_assert(g_queue_array_pop_head(queue, NULL));
+    data = (int*) g_queue_array_linearize(queue);
+    ck_assert_int_eq(queue->_head, 0);
+    ck_assert_int_eq(queue->len, 6);
+    for (int i = 0; i < 6; i++) {
+        ck_assert_int_eq(data[i], i - 1);
+    }
+
+    g_queue_array_free(queue);
+}
+END_TEST
+
+START_TEST(test_g_queue_array_clear_func)
+{
+    GQueueArray *queue = g_queue_array_new(sizeof(int));
+
+    g_queue_array_set_clear_func(queue, clear_int);
+
+    for (int i = 0; i < 20; i++) {
+        g_queue_array_push_tail_val(queue, i);
+    }
+
+    num_cleared = 0;
+    g_queue_array_clear(queue);
+    ck_assert_int_eq(num_cleared, 20);
+    ck_assert_int_eq(queue->len, 0);
+
+    for (int i = 0; i < 5; i++) {
+        g_queue_array_push_head_val(queue, i);
+    }
+
+    // popped elements are only cleared if they aren't returned
+    int val;
+    num_cleared = 0;
+    ck_assert(g_queue_array_pop_head(queue, &val));
+    ck_assert(g_queue_array_pop_tail(queue, &val));
+    ck_assert_int_eq(num_cleared, 0);
+    ck_assert(g_queue_array_pop_head(queue, NULL));
+    ck_assert(g_queue_array_pop_tail(queue, NULL));
+    ck_assert_int_eq(num_cleared, 2);
+
+    num_cleared = 0;
+    g_queue_array_free(queue);
+    ck_assert_int_eq(num_cleared, 1);
+}
+END_TEST
+
+START_TEST(test_g_queue_array_memory_usage)
+{
+    GQueueArray *queue = g_queue_array_new(sizeof(int));
+    GMemUsage usage;
+
+    for (int i = 0; i < 10; i++) {
+        g_queue_array_push_tail_val(queue, i);
+    }
+
+    g_queue_array_memory_usage(queue, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GQueueArray) + 16 * sizeof(int));
+    ck_assert_int_eq(usage.used, 10 * sizeof(int));
+    ck_assert_int_eq(usage.overhead, usage.allocated - usage.used);
+
+    g_queue_array_free(queue);
+}
+END_TEST
+
+Suite* gqueuearray_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GQueueArray");
+
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, test_g_queue_array_new);
+    tcase_add_test(tc_core, test_g_queue_array_push_pop);
+    tcase_add_test(tc_core, test_g_queue_array_wrap_around);
+    tcase_add_test(tc_core, test_g_queue_array_push_head_vals);
+    tcase_add_test(tc_core, test_g_queue_array_linearize);
+    tcase_add_test(tc_core, test_g_queue_array_clear_func);
+    tcase_add_test(tc_core, test_g_queue_array_memory_usage);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = gqueuearray_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -111,7 +111,7 @@ START_TEST(test_gstring_free)
     result = g_string_free(string, false);
     ck_assert_ptr_nonnull(result);
     ck_assert_str_eq(result, "Hello World");
-    free(result);
+    g_free(result);
 }
 END_TEST
 
@@ -762,6 +762,28 @@ START_TEST(test_gstring_equal)
 }
 END_TEST
 
+START_TEST(test_gstring_memory_usage)
+{
+    GString *string = NULL;
+    GMemUsage usage;
+
+    string = g_string_new("Hello World");
+
+    g_string_memory_usage(string, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GString) + GSTRING_MIN_BUF_SIZE);
+    ck_assert_int_eq(usage.used, 11);
+    ck_assert_int_eq(usage.overhead, sizeof(GString) + GSTRING_MIN_BUF_SIZE - 11);
+
+    g_string_append(string, " and everybody else in the universe");
+
+    g_string_memory_usage(string, &usage);
+    ck_assert_int_eq(usage.allocated, sizeof(GString) + string->allocated_len);
+    ck_assert_int_eq(usage.used, string->len);
+
+    g_string_free(string, true);
+}
+END_TEST
+
 Suite* gstring_suite(void)
 {
     Suite *s;
@@ -830,6 +852,8 @@ Suite* gstring_suite(void)
 
     tcase_add_test(tc_core, test_gstring_free);
 
+    tcase_add_test(tc_core, test_gstring_memory_usage);
+
     suite_add_tcase(s, tc_core);
 
     return s;
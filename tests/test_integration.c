@@ -7,6 +7,9 @@
 #include "ghashtable.h"
 #include "glist.h"
 #include "gstring.h"
+#include "gqueuearray.h"
+#include "gchunkarray.h"
+#include "gcolumnarray.h"
 
 START_TEST(test_integration)
 {